@@ -100,6 +100,9 @@ class MachineFunction {
   // numbered and this vector keeps track of the mapping from ID's to MBB's.
   std::vector<MachineBasicBlock*> MBBNumbering;
 
+  // Slab source for Allocator when the creator does not provide one.
+  MallocSlabAllocator DefaultSlabAllocator;
+
   // Pool-allocate MachineFunction-lifetime and IR objects.
   BumpPtrAllocator Allocator;
 
@@ -137,9 +140,11 @@ class MachineFunction {
   MachineFunction(const MachineFunction &) LLVM_DELETED_FUNCTION;
   void operator=(const MachineFunction&) LLVM_DELETED_FUNCTION;
 public:
+  /// If Slabs is not null, the memory of the function is allocated from it,
+  /// which lets the creator recycle it for the next function.
   MachineFunction(const Function *Fn, const TargetMachine &TM,
                   unsigned FunctionNum, MachineModuleInfo &MMI,
-                  GCModuleInfo* GMI);
+                  GCModuleInfo* GMI, SlabAllocator *Slabs = 0);
   ~MachineFunction();
 
   MachineModuleInfo &getMMI() const { return MMI; }
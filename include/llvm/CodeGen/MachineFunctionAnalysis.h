@@ -15,6 +15,7 @@
 #define LLVM_CODEGEN_MACHINEFUNCTIONANALYSIS_H
 
 #include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
 
 namespace llvm {
 
@@ -28,6 +29,8 @@ private:
   const TargetMachine &TM;
   MachineFunction *MF;
   unsigned NextFnNum;
+  /// Slabs - Memory of released MachineFunctions, kept for the next one.
+  RecyclingSlabAllocator Slabs;
 public:
   static char ID;
   explicit MachineFunctionAnalysis(const TargetMachine &tm);
@@ -41,6 +44,7 @@ public:
 
 private:
   virtual bool doInitialization(Module &M);
+  virtual bool doFinalization(Module &M);
   virtual bool runOnFunction(Function &F);
   virtual void releaseMemory();
   virtual void getAnalysisUsage(AnalysisUsage &AU) const;
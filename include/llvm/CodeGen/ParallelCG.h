@@ -0,0 +1,45 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares an interface for parallel code generation: a module is
+// split into partitions, and each one is compiled on its own thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Target/TargetMachine.h"
+#include <string>
+
+namespace llvm {
+
+class Module;
+class TargetLibraryInfo;
+class formatted_raw_ostream;
+
+/// splitCodeGen - Split \p M into OSs.size() partitions (see
+/// ModuleSplitter), and generate code of type \p FT for partition I into
+/// *OSs[I].  Every partition is compiled in its own LLVMContext and on its own
+/// thread, by a copy of \p TM; \p TLI, if given, is copied into every code
+/// generation pipeline.  The outputs only depend on the module, so they are
+/// the same from run to run.  Linking all of them together is equivalent to
+/// linking the object file for the whole module.
+///
+/// \p M is modified: local symbols referenced from several partitions are
+/// externalized.  Returns true and sets \p ErrMsg on failure.
+bool splitCodeGen(Module *M, ArrayRef<formatted_raw_ostream *> OSs,
+                  const TargetMachine &TM,
+                  TargetMachine::CodeGenFileType FT,
+                  const TargetLibraryInfo *TLI, std::string &ErrMsg);
+
+} // End llvm namespace
+
+#endif
@@ -23,6 +23,7 @@ namespace llvm {
 
 class FunctionPass;
 class MachineFunctionPass;
+class ModulePass;
 class PassConfigImpl;
 class PassInfo;
 class PassManagerBase;
@@ -181,6 +182,11 @@ public:
   /// transforms following machine independent optimization.
   virtual void addIRPasses();
 
+  /// Add IR passes that transform the whole module, such as reordering its
+  /// functions.  These need a PassManager, so this is only called when
+  /// emitting a file, never on the FunctionPassManager used by the JIT.
+  virtual void addModuleIRPasses();
+
   /// Add passes to lower exception handling for the code generator.
   void addPassesToHandleExceptions();
 
@@ -428,6 +434,11 @@ namespace llvm {
   ///
   FunctionPass *createGreedyRegisterAllocator();
 
+  /// LinearScanRegisterAllocation Pass - This pass implements a linear scan
+  /// register allocator that trades some code quality for compile time.
+  ///
+  FunctionPass *createLinearScanRegisterAllocator();
+
   /// PBQPRegisterAllocation Pass - This pass implements the Partitioned Boolean
   /// Quadratic Prograaming (PBQP) based register allocator.
   ///
@@ -482,6 +493,11 @@ namespace llvm {
   /// information.
   extern char &MachineBlockPlacementStatsID;
 
+  /// createFunctionOrderingPass - This pass reorders the functions of a module,
+  /// and hence their order in the object file, to place functions that call
+  /// each other frequently according to the call profile next to each other.
+  ModulePass *createFunctionOrderingPass();
+
   /// GCLowering Pass - Performs target-independent LLVM IR transformations for
   /// highly portable strategies.
   ///
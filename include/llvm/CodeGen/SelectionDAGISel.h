@@ -15,6 +15,7 @@
 #ifndef LLVM_CODEGEN_SELECTIONDAGISEL_H
 #define LLVM_CODEGEN_SELECTIONDAGISEL_H
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/IR/BasicBlock.h"
@@ -36,6 +37,7 @@ namespace llvm {
   class GCFunctionInfo;
   class ScheduleDAGSDNodes;
   class LoadInst;
+  class raw_ostream;
 
 /// SelectionDAGISel - This is the common base class used for SelectionDAG-based
 /// pattern-matching instruction selectors.
@@ -66,6 +68,9 @@ public:
 
   virtual bool runOnMachineFunction(MachineFunction &MF);
 
+  /// doFinalization - Print the -fast-isel-report summary, if requested.
+  virtual bool doFinalization(Module &M);
+
   virtual void EmitFunctionEntryCode() {}
 
   /// PreprocessISelDAG - This hook allows targets to hack on the graph before
@@ -277,6 +282,16 @@ private:
   ///
   ScheduleDAGSDNodes *CreateScheduler();
 
+  /// FastISelMisses - For -fast-isel-report, the number of times FastISel
+  /// gave up on each kind of instruction, and the number of instructions
+  /// that were left to SelectionDAG because of it.
+  StringMap<std::pair<unsigned, unsigned> > FastISelMisses;
+  unsigned NumFastISelSelected;
+  unsigned NumFastISelMissed;
+
+  void recordFastISelMiss(StringRef Kind, unsigned NumMissed);
+  void printFastISelReport(raw_ostream &OS) const;
+
   /// OpcodeOffset - This is a cache used to dispatch efficiently into isel
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
@@ -327,6 +327,10 @@ private:
   /// NodeId - Unique id per SDNode in the DAG.
   int NodeId;
 
+  /// CombinerWorklistIndex - Position of this node in the DAG combiner's
+  /// worklist, or -1 if it is not on the worklist.
+  int CombinerWorklistIndex;
+
   /// OperandList - The values that are used by this operation.
   ///
   SDUse *OperandList;
@@ -419,6 +423,13 @@ public:
   /// setNodeId - Set unique node id.
   void setNodeId(int Id) { NodeId = Id; }
 
+  /// getCombinerWorklistIndex - Return the position of this node in the DAG
+  /// combiner's worklist, or -1 if it is not on the worklist.
+  int getCombinerWorklistIndex() const { return CombinerWorklistIndex; }
+
+  /// setCombinerWorklistIndex - Only the DAG combiner should call this.
+  void setCombinerWorklistIndex(int Index) { CombinerWorklistIndex = Index; }
+
   /// getIROrder - Return the node ordering.
   ///
   unsigned getIROrder() const { return IROrder; }
@@ -701,7 +712,7 @@ protected:
   SDNode(unsigned Opc, unsigned Order, const DebugLoc dl, SDVTList VTs,
          const SDValue *Ops, unsigned NumOps)
     : NodeType(Opc), OperandsNeedDelete(true), HasDebugValue(false),
-      SubclassData(0), NodeId(-1),
+      SubclassData(0), NodeId(-1), CombinerWorklistIndex(-1),
       OperandList(NumOps ? new SDUse[NumOps] : 0),
       ValueList(VTs.VTs), UseList(NULL),
       NumOperands(NumOps), NumValues(VTs.NumVTs),
@@ -717,9 +728,9 @@ protected:
   /// set later with InitOperands.
   SDNode(unsigned Opc, unsigned Order, const DebugLoc dl, SDVTList VTs)
     : NodeType(Opc), OperandsNeedDelete(false), HasDebugValue(false),
-      SubclassData(0), NodeId(-1), OperandList(0),
-      ValueList(VTs.VTs), UseList(NULL), NumOperands(0), NumValues(VTs.NumVTs),
-      debugLoc(dl), IROrder(Order) {}
+      SubclassData(0), NodeId(-1), CombinerWorklistIndex(-1),
+      OperandList(0), ValueList(VTs.VTs), UseList(NULL), NumOperands(0),
+      NumValues(VTs.NumVTs), debugLoc(dl), IROrder(Order) {}
 
   /// InitOperands - Initialize the operands list of this with 1 operand.
   void InitOperands(SDUse *Ops, const SDValue &Op0) {
@@ -182,24 +182,28 @@ namespace llvm {
     /// Compare two SlotIndex objects. Return true if the first index
     /// is strictly lower than the second.
     bool operator<(SlotIndex other) const {
-      return getIndex() < other.getIndex();
+      // Slots of the same instruction are ordered by the slot alone, without
+      // loading the list entry.
+      if (lie.getPointer() == other.lie.getPointer())
+        return getSlot() < other.getSlot();
+      return listEntry()->getIndex() < other.listEntry()->getIndex();
     }
     /// Compare two SlotIndex objects. Return true if the first index
     /// is lower than, or equal to, the second.
     bool operator<=(SlotIndex other) const {
-      return getIndex() <= other.getIndex();
+      return !(other < *this);
     }
 
     /// Compare two SlotIndex objects. Return true if the first index
     /// is greater than the second.
     bool operator>(SlotIndex other) const {
-      return getIndex() > other.getIndex();
+      return other < *this;
     }
 
     /// Compare two SlotIndex objects. Return true if the first index
     /// is greater than, or equal to, the second.
     bool operator>=(SlotIndex other) const {
-      return getIndex() >= other.getIndex();
+      return !(*this < other);
     }
 
     /// isSameInstr - Return true if A and B refer to the same instruction.
@@ -134,11 +134,19 @@ public:
   DIContext(DIContextKind K) : Kind(K) {}
   virtual ~DIContext();
 
-  /// getDWARFContext - get a context for binary DWARF data.
-  static DIContext *getDWARFContext(object::ObjectFile *);
+  /// getDWARFContext - get a context for binary DWARF data.  Dumping and
+  /// address range table construction parse units on up to \p NumThreads
+  /// threads.
+  static DIContext *getDWARFContext(object::ObjectFile *,
+                                    unsigned NumThreads = 1);
 
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All) = 0;
 
+  /// dumpDIEsNamed - Print the debug info entries called \p Name, using the
+  /// name indexes of the object where possible.  Returns false if there are
+  /// none.
+  virtual bool dumpDIEsNamed(raw_ostream &OS, StringRef Name) = 0;
+
   virtual DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DILineInfoTable getLineInfoForAddressRange(uint64_t Address,
@@ -92,6 +92,11 @@ public:
   void emitError(const Instruction *I, const Twine &ErrorStr);
   void emitError(const Twine &ErrorStr);
 
+  /// emitWarning - Emit a warning message to the currently installed error
+  /// handler, or print it to stderr if there is none.  Compilation carries on
+  /// either way.  The message will be implicitly prefixed with "warning: ".
+  void emitWarning(const Twine &WarningStr);
+
 private:
   LLVMContext(LLVMContext&) LLVM_DELETED_FUNCTION;
   void operator=(LLVMContext&) LLVM_DELETED_FUNCTION;
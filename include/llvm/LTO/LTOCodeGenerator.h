@@ -48,6 +48,7 @@ namespace llvm {
   class GlobalValue;
   class Mangler;
   class MemoryBuffer;
+  class PassManager;
   class TargetMachine;
   class raw_ostream;
 }
@@ -71,6 +72,10 @@ struct LTOCodeGenerator {
 
   void setCpu(const char *mCpu) { MCpu = mCpu; }
 
+  // Set the number of partitions compile_to_files() splits the merged module
+  // into.
+  void setCodeGenPartitions(unsigned N) { CodeGenPartitions = N ? N : 1; }
+
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
   void addDSOSymbol(const char* Sym) {
@@ -119,9 +124,27 @@ struct LTOCodeGenerator {
                       bool disableGVNLoadPRE,
                       std::string &errMsg);
 
+  // As with compile_to_file(), but the merged module is split into the
+  // number of partitions given to setCodeGenPartitions(), and code for them
+  // is generated in parallel. The paths to the object files, one per
+  // partition, are returned in "names"; together they replace the single
+  // object file. Return true on success.
+  //
+  // As with compile_to_file(), it is up to the linker to remove the files.
+  bool compile_to_files(std::vector<std::string> &names,
+                        bool disableOpt,
+                        bool disableInline,
+                        bool disableGVNLoadPRE,
+                        std::string &errMsg);
+
 private:
   void initializeLTOPasses();
 
+  void addOptimizationPasses(llvm::PassManager &passes,
+                             bool disableOpt,
+                             bool disableInline,
+                             bool disableGVNLoadPRE);
+
   bool generateObjectFile(llvm::raw_ostream &out,
                           bool disableOpt,
                           bool disableInline,
@@ -147,6 +170,7 @@ private:
   StringSet MustPreserveSymbols;
   StringSet AsmUndefinedRefs;
   llvm::MemoryBuffer *NativeObjectFile;
+  unsigned CodeGenPartitions;
   std::vector<char *> CodegenOptions;
   std::string MCpu;
   std::string NativeObjectPath;
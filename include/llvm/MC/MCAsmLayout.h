@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include <vector>
 
 namespace llvm {
 class MCAssembler;
@@ -42,6 +43,17 @@ private:
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSectionData*, MCFragment*> LastValidFragment;
 
+  /// The section being relaxed incrementally, or 0. While it is set, the
+  /// offsets of its fragments are answered from FragmentSizeTree instead of
+  /// the lazily computed MCFragment::Offset.
+  const MCSectionData *IncrementalSection;
+
+  /// The sizes of the fragments of IncrementalSection in layout order, and a
+  /// Fenwick tree over them, so that resizing a fragment and querying the
+  /// offset of any other are both logarithmic.
+  std::vector<uint64_t> FragmentSizes;
+  std::vector<uint64_t> FragmentSizeTree;
+
   /// \brief Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
@@ -70,6 +82,19 @@ public:
   /// been initialized.
   void layoutFragment(MCFragment *Fragment);
 
+  /// \brief Lay out all of \p SD and switch it to incremental mode, where
+  /// fragments are resized in place through resizeFragment() instead of
+  /// invalidating everything that follows them. Bundling is not supported.
+  void beginIncrementalLayout(MCSectionData *SD);
+
+  /// \brief Record that fragment \p F of the incremental section now has size
+  /// \p NewSize. Returns the change in size.
+  int64_t resizeFragment(const MCFragment *F, uint64_t NewSize);
+
+  /// \brief Leave incremental mode, storing the final offsets back into the
+  /// fragments of the section.
+  void endIncrementalLayout();
+
   /// @name Section Access (in layout order)
   /// @{
 
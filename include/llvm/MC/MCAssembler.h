@@ -918,6 +918,15 @@ private:
   /// if any offsets were adjusted.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
 
+  /// \brief Relax the given section until nothing in it changes, revisiting
+  /// only the fragments whose fixups depend on a fragment that was resized.
+  /// Return true if any fragment was resized.
+  bool layoutSectionIncrementally(MCAsmLayout &Layout, MCSectionData &SD);
+
+  /// \brief Relax a single fragment, returning true if it was re-encoded with
+  /// a different size (or, for instructions, relaxed at all).
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
+
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
@@ -10,14 +10,16 @@
 #define LLVM_MC_MCDISASSEMBLER_H
 
 #include "llvm-c/Disassembler.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCSymbolizer.h"
 #include "llvm/MC/MCRelocationInfo.h"
 #include "llvm/Support/DataTypes.h"
+#include <vector>
 
 namespace llvm {
 
-class MCInst;
 class MCSubtargetInfo;
 class MemoryObject;
 class raw_ostream;
@@ -85,6 +87,41 @@ public:
                                        uint64_t address,
                                        raw_ostream &vStream,
                                        raw_ostream &cStream) const = 0;
+
+  /// getInstructionFromBytes - Like getInstruction, but decodes the
+  ///   instruction at the start of the contiguous buffer \p Bytes, whose first
+  ///   byte is at \p Address.  The default implementation wraps the buffer in
+  ///   a MemoryObject; targets override it to read the bytes directly.
+  virtual DecodeStatus getInstructionFromBytes(MCInst &Instr, uint64_t &Size,
+                                               ArrayRef<uint8_t> Bytes,
+                                               uint64_t Address,
+                                               raw_ostream &VStream,
+                                               raw_ostream &CStream) const;
+
+  /// DecodedInst - An instruction decoded by getInstructions.
+  struct DecodedInst {
+    MCInst Inst;
+    uint64_t Address;
+    /// The size of the instruction, or the number of bytes skipped if it
+    /// could not be decoded.
+    uint64_t Size;
+    DecodeStatus Status;
+  };
+
+  /// getInstructions - Decodes the instructions of \p Bytes, whose first byte
+  ///   is at \p Address, one after the other.  Bytes that do not decode are
+  ///   recorded as a Fail instruction and skipped, like the tools do.
+  ///
+  /// Decoding stops at the end of the buffer or after \p MaxInsts
+  /// instructions.  The instructions go to the front of \p Insts, which is
+  /// only ever grown, so that a caller decoding a large region in pieces
+  /// reuses the same MCInsts for every piece.
+  ///
+  /// @return - The number of instructions decoded into \p Insts.
+  size_t getInstructions(std::vector<DecodedInst> &Insts,
+                         ArrayRef<uint8_t> Bytes, uint64_t Address,
+                         raw_ostream &VStream, raw_ostream &CStream,
+                         size_t MaxInsts = ~size_t(0)) const;
 private:
   //
   // Hooks for symbolic disassembly via the public 'C' interface.
@@ -0,0 +1,57 @@
+//===- MCModuleBinary.h - MCModule binary serialization ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file declares the reader and writer of the binary
+/// representation of MCModule, a compact alternative to MCModuleYAML meant
+/// for caching the result of MCObjectDisassembler::buildModule.
+///
+/// The representation is a header followed by arrays of fixed-size
+/// little-endian records: the atoms, their instructions and operands, the
+/// functions, their basic blocks and the successor/predecessor edges, then
+/// the contents of the data atoms and the names.  Records refer to each other
+/// by index, so the arrays can be read in place from a mapped file.
+///
+/// Opcodes and registers are stored as enum values.  The header records how
+/// many of each the writer knew of and a key chosen by the writer, and a
+/// module is only read back for the same counts and key.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_MC_MCMODULEBINARY_H
+#define LLVM_MC_MCMODULEBINARY_H
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/MC/MCModule.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace llvm {
+
+class MCInstrInfo;
+class MCRegisterInfo;
+
+/// \brief Write the binary representation of the MCModule \p MCM to \p OS.
+/// \p Key is stored along with it, for instance to identify the object file
+/// the module was built from.
+/// \returns The empty string on success, an error message on failure.
+StringRef mcmodule2binary(raw_ostream &OS, const MCModule &MCM, StringRef Key,
+                          const MCInstrInfo &MII, const MCRegisterInfo &MRI);
+
+/// \brief Creates a new module from the binary representation in \p Buffer
+/// and returns it in \p MCM.  \p Key must be the one the module was written
+/// with.
+/// \returns The empty string on success, an error message on failure.
+StringRef binary2mcmodule(OwningPtr<MCModule> &MCM, StringRef Buffer,
+                          StringRef Key, const MCInstrInfo &MII,
+                          const MCRegisterInfo &MRI);
+
+} // end namespace llvm
+
+#endif
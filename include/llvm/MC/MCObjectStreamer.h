@@ -68,6 +68,11 @@ protected:
   /// fragment is not a data fragment.
   MCDataFragment *getOrCreateDataFragment() const;
 
+  /// Encode an instruction at the end of a fragment. The encoding is written
+  /// straight into the fragment contents and the fixups into its fixup list,
+  /// adjusted to be relative to the start of the fragment.
+  void appendEncodedInst(MCEncodedFragmentWithFixups &F, const MCInst &Inst);
+
   const MCExpr *AddValueSymbols(const MCExpr *Value);
 
 public:
@@ -14,11 +14,13 @@
 #ifndef LLVM_OBJECT_ARCHIVE_H
 #define LLVM_OBJECT_ARCHIVE_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Object/Binary.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <vector>
 
 namespace llvm {
 namespace object {
@@ -48,10 +50,13 @@ class Archive : public Binary {
 public:
   class Child {
     const Archive *Parent;
-    /// \brief Includes header but not padding byte.
+    /// \brief Includes header but not padding byte. Members of a thin archive
+    /// only have a header here; their data is in a file of their own.
     StringRef Data;
     /// \brief Offset from Data to the start of the file.
     uint16_t StartOfFile;
+    /// \brief Whether this is a member of a thin archive.
+    bool IsThinMember;
 
     const ArchiveMemberHeader *getHeader() const {
       return reinterpret_cast<const ArchiveMemberHeader *>(Data.data());
@@ -82,12 +87,19 @@ public:
       return getHeader()->getAccessMode();
     }
     /// \return the size of the archive member without the header or padding.
-    uint64_t getSize() const { return Data.size() - StartOfFile; }
-
-    StringRef getBuffer() const {
-      return StringRef(Data.data() + StartOfFile, getSize());
+    uint64_t getSize() const {
+      if (IsThinMember)
+        return getHeader()->getSize();
+      return Data.size() - StartOfFile;
     }
 
+    bool isThinMember() const { return IsThinMember; }
+
+    /// \return the contents of the member. The file a thin archive member
+    /// refers to is read on first use; an empty buffer is returned if that
+    /// fails.
+    StringRef getBuffer() const;
+
     error_code getMemoryBuffer(OwningPtr<MemoryBuffer> &Result,
                                bool FullPath = false) const;
 
@@ -163,6 +175,7 @@ public:
   };
 
   Archive(MemoryBuffer *source, error_code &ec);
+  ~Archive();
 
   enum Kind {
     K_GNU,
@@ -174,6 +187,10 @@ public:
     return Format;
   }
 
+  /// \brief Whether this is a GNU thin archive, whose members refer to files
+  /// by path instead of holding their data.
+  bool isThin() const { return IsThin; }
+
   child_iterator begin_children(bool SkipInternal = true) const;
   child_iterator end_children() const;
 
@@ -185,16 +202,35 @@ public:
     return v->isArchive();
   }
 
-  // check if a symbol is in the archive
+  /// \brief Find the member defining \p name. The first call sorts the
+  /// names of the symbol table, which stay in the mapped archive, so that
+  /// every lookup is a binary search. It is not safe to call this from
+  /// several threads at once.
   child_iterator findSym(StringRef name) const;
 
   bool hasSymbolTable() const;
 
 private:
+  /// \brief Load the file of the thin archive member named \p Name, whose
+  /// header starts at \p Start.
+  error_code getThinMember(const char *Start, StringRef Name,
+                           StringRef &Result) const;
+  /// \brief Where the file of a thin archive member named \p Name is.
+  std::string getThinMemberPath(StringRef Name) const;
+
   child_iterator SymbolTable;
   child_iterator StringTable;
   child_iterator FirstRegular;
   Kind Format;
+  bool IsThin;
+
+  /// \brief The files of the thin archive members read so far, by the start
+  /// of their header.
+  mutable DenseMap<const char *, MemoryBuffer *> ThinMembers;
+
+  /// \brief The symbol table sorted by name, as (name, symbol index) pairs.
+  mutable std::vector<std::pair<StringRef, uint32_t> > SymbolIndex;
+  mutable bool HasSymbolIndex;
 };
 
 }
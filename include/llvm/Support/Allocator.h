@@ -83,6 +83,33 @@ public:
   virtual void Deallocate(MemSlab *Slab) LLVM_OVERRIDE;
 };
 
+/// RecyclingSlabAllocator - A slab allocator that keeps the slabs it is given
+/// back and hands them out again.  Sharing one between a sequence of
+/// short-lived bump allocators, such as those of the MachineFunctions of a
+/// module, avoids going back to malloc for every slab.  Only slabs of the
+/// standard size are kept, and at most MaxFreeSlabs of them.
+class RecyclingSlabAllocator : public SlabAllocator {
+  MallocSlabAllocator Allocator;
+  size_t SlabSize;
+  unsigned MaxFreeSlabs;
+
+  /// FreeSlabs - Slabs available for reuse, chained through NextPtr.
+  MemSlab *FreeSlabs;
+  unsigned NumFreeSlabs;
+
+public:
+  explicit RecyclingSlabAllocator(size_t SlabSize = 4096,
+                                  unsigned MaxFreeSlabs = 1024)
+    : SlabSize(SlabSize), MaxFreeSlabs(MaxFreeSlabs), FreeSlabs(0),
+      NumFreeSlabs(0) { }
+  virtual ~RecyclingSlabAllocator();
+  virtual MemSlab *Allocate(size_t Size) LLVM_OVERRIDE;
+  virtual void Deallocate(MemSlab *Slab) LLVM_OVERRIDE;
+
+  /// clear - Release all slabs that are kept for reuse.
+  void clear();
+};
+
 /// BumpPtrAllocator - This allocator is useful for containers that need
 /// very simple memory allocation strategies.  In particular, this just keeps
 /// allocating memory, and never deletes it until the entire block is dead. This
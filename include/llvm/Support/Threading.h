@@ -54,6 +54,19 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_execute_in_parallel - Call \p UserFn(UserData, I) for every I in
+  /// [0, NumTasks), spreading the calls over up to \p NumThreads threads.
+  /// Tasks are handed out in increasing order, but may complete in any order.
+  /// Returns once every task has finished.
+  ///
+  /// The calling thread takes part in the work.  Where threads are not
+  /// available the tasks simply run one after another on the calling thread.
+  /// The callback must be safe to run concurrently, see
+  /// llvm_start_multithreaded().
+  void llvm_execute_in_parallel(void (*UserFn)(void*, unsigned),
+                                void *UserData, unsigned NumTasks,
+                                unsigned NumThreads);
 }
 
 #endif
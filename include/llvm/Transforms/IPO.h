@@ -203,6 +203,13 @@ ModulePass *createMergeFunctionsPass();
 /// createPartialInliningPass - This pass inlines parts of functions.
 ///
 ModulePass *createPartialInliningPass();
+
+//===----------------------------------------------------------------------===//
+/// createHotColdSplittingPass - This pass outlines rarely executed regions of
+/// functions, as estimated by BlockFrequencyInfo, into separate functions
+/// placed in a cold text section.
+///
+ModulePass *createHotColdSplittingPass();
   
 //===----------------------------------------------------------------------===//
 // createMetaRenamerPass - Rename everything with metasyntatic names.
@@ -15,6 +15,8 @@
 #ifndef LLVM_TRANSFORMS_SCALAR_H
 #define LLVM_TRANSFORMS_SCALAR_H
 
+#include "llvm/ADT/StringRef.h"
+
 namespace llvm {
 
 class FunctionPass;
@@ -354,6 +356,13 @@ FunctionPass *createLowerExpectIntrinsicPass();
 //
 FunctionPass *createPartiallyInlineLibCallsPass();
 
+//===----------------------------------------------------------------------===//
+//
+// SampleProfileLoader - Annotate branches and calls with the counts recorded
+// in a textual sampled profile.
+//
+FunctionPass *createSampleProfileLoaderPass(StringRef Name = "");
+
 } // End llvm namespace
 
 #endif
@@ -0,0 +1,63 @@
+//===-- Transform/Utils/SplitModule.h - Split a module ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A utility to divide the function definitions of a module into partitions
+// that can be compiled independently of each other.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+#define LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+
+#include "llvm/ADT/StringMap.h"
+
+namespace llvm {
+  class Function;
+  class Module;
+
+  /// \brief Utility class for splitting a module into partitions.
+  ///
+  /// Every function definition is assigned to exactly one partition, trying
+  /// to give the partitions similar amounts of code. Global variables,
+  /// aliases, functions that are the target of an alias and module level
+  /// inline assembly all go to partition 0. Linking the objects produced for
+  /// all partitions gives the same program as compiling the whole module.
+  ///
+  /// The partitions are described by name, so that they can be extracted
+  /// from copies of the module that live in other LLVMContexts, for example
+  /// after a round trip through bitcode. The assignment only depends on the
+  /// contents of the module, which keeps the output deterministic.
+  class ModuleSplitter {
+    unsigned NumPartitions;
+    StringMap<unsigned> FunctionPartition;
+
+  public:
+    /// \brief Assign the definitions in \p M to \p N partitions.
+    ///
+    /// This modifies \p M: global values with local linkage that are
+    /// referenced from another partition are given external linkage with
+    /// hidden visibility, and unnamed global values are given a name.
+    ModuleSplitter(Module &M, unsigned N);
+
+    unsigned getNumPartitions() const { return NumPartitions; }
+
+    /// \brief Return the partition that the definition of \p F is assigned
+    /// to.
+    unsigned getPartition(const Function *F) const;
+
+    /// \brief Reduce \p M, a copy of the module the splitter was built
+    /// for, to partition \p I.
+    ///
+    /// Definitions that belong to other partitions are turned into
+    /// declarations. This is safe to call concurrently on different copies.
+    void extractPartition(Module &M, unsigned I) const;
+  };
+}
+
+#endif
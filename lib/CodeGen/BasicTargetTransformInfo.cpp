@@ -272,6 +272,10 @@ unsigned BasicTTI::getArithmeticInstrCost(unsigned Opcode, Type *Ty,
 
 unsigned BasicTTI::getShuffleCost(ShuffleKind Kind, Type *Tp, int Index,
                                   Type *SubTp) const {
+  // Without a blend instruction, every element is extracted from one of the
+  // sources and inserted into the result.
+  if (Kind == SK_Alternate)
+    return getScalarizationOverhead(Tp, true, true);
   return 1;
 }
 
@@ -0,0 +1,254 @@
+//===-- FunctionOrdering.cpp - Profile-guided function layout -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The AsmPrinter emits functions in the order they appear in the module.  This
+// pass reorders the module's function list so that functions which call each
+// other frequently end up next to each other in the object file, reducing
+// i-TLB and i-cache misses.
+//
+// Call counts come from the "branch_weights" profile metadata attached to
+// direct calls, as produced by -sample-profile.  Modules without such
+// metadata are left untouched.
+//
+// The layout follows Pettis and Hansen, "Profile Guided Code Positioning"
+// (PLDI 1990): every function starts out in a chain of its own, and the edges
+// of the undirected call graph are visited in decreasing weight order.  For
+// each edge the chains of both ends are merged, choosing the orientation of
+// the two chains which places the two functions closest together.  The
+// resulting chains are emitted hottest first, followed by the functions which
+// did not appear in the profile in their original order.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "function-ordering"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace llvm;
+
+STATISTIC(NumFunctionsPlaced, "Number of functions placed from call profile");
+STATISTIC(NumChains, "Number of function chains formed");
+
+namespace {
+  class FunctionOrdering : public ModulePass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    FunctionOrdering() : ModulePass(ID) {
+      initializeFunctionOrderingPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnModule(Module &M);
+  };
+
+  /// CallEdge - An undirected, weighted edge of the call graph between the
+  /// functions with the given indices in the original module order.
+  struct CallEdge {
+    unsigned A, B;
+    uint64_t Weight;
+
+    CallEdge(unsigned A, unsigned B, uint64_t Weight)
+      : A(A), B(B), Weight(Weight) {}
+
+    /// Heaviest edges first; ties are broken by module order so that the
+    /// layout is deterministic.
+    bool operator<(const CallEdge &RHS) const {
+      if (Weight != RHS.Weight)
+        return Weight > RHS.Weight;
+      if (A != RHS.A)
+        return A < RHS.A;
+      return B < RHS.B;
+    }
+  };
+
+  /// FunctionChain - A sequence of functions that will be laid out
+  /// contiguously.
+  struct FunctionChain {
+    std::vector<unsigned> Funcs;
+    uint64_t Weight;
+  };
+}
+
+char FunctionOrdering::ID = 0;
+INITIALIZE_PASS(FunctionOrdering, "function-ordering",
+                "Profile Guided Function Ordering", false, false)
+
+ModulePass *llvm::createFunctionOrderingPass() {
+  return new FunctionOrdering();
+}
+
+/// getCallCount - Return the execution count recorded on a call site, or zero
+/// if it carries no profile.
+static uint64_t getCallCount(const CallInst *CI) {
+  MDNode *MD = CI->getMetadata(LLVMContext::MD_prof);
+  if (!MD || MD->getNumOperands() != 2)
+    return 0;
+  MDString *Name = dyn_cast<MDString>(MD->getOperand(0));
+  if (!Name || Name->getString() != "branch_weights")
+    return 0;
+  ConstantInt *Count = dyn_cast<ConstantInt>(MD->getOperand(1));
+  return Count ? Count->getZExtValue() : 0;
+}
+
+/// distanceAfterMerge - Return how far apart A and B end up when the chain
+/// holding A, optionally reversed, is followed by the chain holding B,
+/// optionally reversed.
+static unsigned distanceAfterMerge(unsigned PosA, unsigned SizeA, bool RevA,
+                                   unsigned PosB, bool RevB, unsigned SizeB) {
+  unsigned EndA = RevA ? PosA : SizeA - 1 - PosA;
+  unsigned StartB = RevB ? SizeB - 1 - PosB : PosB;
+  return EndA + StartB + 1;
+}
+
+bool FunctionOrdering::runOnModule(Module &M) {
+  std::vector<Function *> Funcs;
+  DenseMap<const Function *, unsigned> Index;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    Index[I] = Funcs.size();
+    Funcs.push_back(I);
+  }
+
+  // Collect the undirected call graph, summing the counts of all call sites
+  // between each pair of functions.
+  DenseMap<std::pair<unsigned, unsigned>, uint64_t> EdgeWeights;
+  for (unsigned Caller = 0, e = Funcs.size(); Caller != e; ++Caller) {
+    Function *F = Funcs[Caller];
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB)
+      for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE;
+           ++I) {
+        const CallInst *CI = dyn_cast<CallInst>(I);
+        if (!CI)
+          continue;
+        const Function *Callee = CI->getCalledFunction();
+        if (!Callee || Callee->isDeclaration() || Callee == F)
+          continue;
+        uint64_t Count = getCallCount(CI);
+        if (!Count)
+          continue;
+        unsigned CalleeIdx = Index[Callee];
+        EdgeWeights[std::make_pair(std::min(Caller, CalleeIdx),
+                                   std::max(Caller, CalleeIdx))] += Count;
+      }
+  }
+
+  if (EdgeWeights.empty())
+    return false;
+
+  std::vector<CallEdge> Edges;
+  Edges.reserve(EdgeWeights.size());
+  for (DenseMap<std::pair<unsigned, unsigned>, uint64_t>::iterator
+       I = EdgeWeights.begin(), E = EdgeWeights.end(); I != E; ++I)
+    Edges.push_back(CallEdge(I->first.first, I->first.second, I->second));
+  std::sort(Edges.begin(), Edges.end());
+
+  // ChainOf maps each function to the chain holding it, Chains owns the
+  // chains.  Functions only get a chain once they appear on an edge.
+  std::vector<FunctionChain> Chains;
+  std::vector<int> ChainOf(Funcs.size(), -1);
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+    const CallEdge &Edge = Edges[i];
+    unsigned Ends[2] = { Edge.A, Edge.B };
+    for (unsigned j = 0; j != 2; ++j)
+      if (ChainOf[Ends[j]] < 0) {
+        ChainOf[Ends[j]] = Chains.size();
+        Chains.push_back(FunctionChain());
+        Chains.back().Funcs.push_back(Ends[j]);
+        Chains.back().Weight = 0;
+      }
+
+    unsigned CA = ChainOf[Edge.A], CB = ChainOf[Edge.B];
+    if (CA == CB) {
+      Chains[CA].Weight += Edge.Weight;
+      continue;
+    }
+
+    // Keep the chain formed first (the hotter one) in front.
+    if (CA > CB)
+      std::swap(CA, CB);
+    unsigned FA = ChainOf[Edge.A] == (int)CA ? Edge.A : Edge.B;
+    unsigned FB = FA == Edge.A ? Edge.B : Edge.A;
+
+    std::vector<unsigned> &First = Chains[CA].Funcs;
+    std::vector<unsigned> &Second = Chains[CB].Funcs;
+    unsigned PosA =
+      std::find(First.begin(), First.end(), FA) - First.begin();
+    unsigned PosB =
+      std::find(Second.begin(), Second.end(), FB) - Second.begin();
+
+    // Pick the orientation of both chains that places the two ends of the
+    // edge closest to each other, preferring to keep the existing order.
+    bool BestRevA = false, BestRevB = false;
+    unsigned BestDist = ~0U;
+    for (unsigned RevA = 0; RevA != 2; ++RevA)
+      for (unsigned RevB = 0; RevB != 2; ++RevB) {
+        unsigned Dist = distanceAfterMerge(PosA, First.size(), RevA,
+                                           PosB, RevB, Second.size());
+        if (Dist < BestDist) {
+          BestDist = Dist;
+          BestRevA = RevA;
+          BestRevB = RevB;
+        }
+      }
+
+    if (BestRevA)
+      std::reverse(First.begin(), First.end());
+    if (BestRevB)
+      std::reverse(Second.begin(), Second.end());
+    First.insert(First.end(), Second.begin(), Second.end());
+    for (unsigned j = 0, je = Second.size(); j != je; ++j)
+      ChainOf[Second[j]] = CA;
+    Second.clear();
+    Chains[CA].Weight += Chains[CB].Weight + Edge.Weight;
+    Chains[CB].Weight = 0;
+  }
+
+  // Emit the chains hottest first.  Chains are numbered in the order they
+  // were created, which breaks ties deterministically.
+  std::vector<std::pair<uint64_t, unsigned> > ChainOrder;
+  for (unsigned i = 0, e = Chains.size(); i != e; ++i)
+    if (!Chains[i].Funcs.empty())
+      ChainOrder.push_back(std::make_pair(~Chains[i].Weight, i));
+  std::sort(ChainOrder.begin(), ChainOrder.end());
+  NumChains += ChainOrder.size();
+
+  Module::FunctionListType &FL = M.getFunctionList();
+  std::vector<Function *> NewOrder;
+  NewOrder.reserve(Funcs.size());
+  for (unsigned i = 0, e = ChainOrder.size(); i != e; ++i) {
+    const FunctionChain &Chain = Chains[ChainOrder[i].second];
+    for (unsigned j = 0, je = Chain.Funcs.size(); j != je; ++j)
+      NewOrder.push_back(Funcs[Chain.Funcs[j]]);
+  }
+  NumFunctionsPlaced += NewOrder.size();
+  for (unsigned i = 0, e = Funcs.size(); i != e; ++i)
+    if (ChainOf[i] < 0)
+      NewOrder.push_back(Funcs[i]);
+
+  bool Changed = false;
+  for (unsigned i = 0, e = NewOrder.size(); i != e; ++i) {
+    Changed |= NewOrder[i] != Funcs[i];
+    FL.remove(NewOrder[i]);
+    FL.push_back(NewOrder[i]);
+  }
+
+  DEBUG(if (Changed) {
+    dbgs() << "FunctionOrdering: new function order:\n";
+    for (unsigned i = 0, e = NewOrder.size(); i != e; ++i)
+      if (!NewOrder[i]->isDeclaration())
+        dbgs() << "  " << NewOrder[i]->getName() << "\n";
+  });
+  return Changed;
+}
@@ -87,9 +87,12 @@ void LLVMTargetMachine::addAnalysisPasses(PassManagerBase &PM) {
 }
 
 /// addPassesToX helper drives creation and initialization of TargetPassConfig.
+/// ModulePasses is false when PM may be a FunctionPassManager, which can't
+/// run module passes.
 static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
                                           PassManagerBase &PM,
                                           bool DisableVerify,
+                                          bool ModulePasses,
                                           AnalysisID StartAfter,
                                           AnalysisID StopAfter) {
   // Targets may override createPassConfig to provide a target-specific sublass.
@@ -101,6 +104,9 @@ static MCContext *addPassesToGenerateCode(LLVMTargetMachine *TM,
 
   PM.add(PassConfig);
 
+  if (ModulePasses)
+    PassConfig->addModuleIRPasses();
+
   PassConfig->addIRPasses();
 
   PassConfig->addCodeGenPrepare();
@@ -144,6 +150,7 @@ bool LLVMTargetMachine::addPassesToEmitFile(PassManagerBase &PM,
                                             AnalysisID StopAfter) {
   // Add common CodeGen passes.
   MCContext *Context = addPassesToGenerateCode(this, PM, DisableVerify,
+                                               /*ModulePasses=*/true,
                                                StartAfter, StopAfter);
   if (!Context)
     return true;
@@ -238,7 +245,8 @@ bool LLVMTargetMachine::addPassesToEmitMachineCode(PassManagerBase &PM,
                                                    JITCodeEmitter &JCE,
                                                    bool DisableVerify) {
   // Add common CodeGen passes.
-  MCContext *Context = addPassesToGenerateCode(this, PM, DisableVerify, 0, 0);
+  MCContext *Context = addPassesToGenerateCode(this, PM, DisableVerify,
+                                               /*ModulePasses=*/false, 0, 0);
   if (!Context)
     return true;
 
@@ -257,7 +265,8 @@ bool LLVMTargetMachine::addPassesToEmitMC(PassManagerBase &PM,
                                           raw_ostream &Out,
                                           bool DisableVerify) {
   // Add common CodeGen passes.
-  Ctx = addPassesToGenerateCode(this, PM, DisableVerify, 0, 0);
+  Ctx = addPassesToGenerateCode(this, PM, DisableVerify,
+                                /*ModulePasses=*/false, 0, 0);
   if (!Ctx)
     return true;
 
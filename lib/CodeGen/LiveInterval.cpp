@@ -142,6 +142,10 @@ bool LiveRange::overlaps(const LiveRange &Other, const CoalescerPair &CP,
   if (Other.empty())
     return false;
 
+  // Nothing can overlap when the ranges don't even overlap as a whole.
+  if (Other.endIndex() <= beginIndex() || endIndex() <= Other.beginIndex())
+    return false;
+
   // Use binary searches to find initial positions.
   const_iterator I = find(Other.beginIndex());
   const_iterator IE = end();
@@ -125,8 +125,13 @@ collectInterferingVRegs(unsigned MaxInterferingRegs) {
   if (!CheckedFirstInterference) {
     CheckedFirstInterference = true;
 
-    // Quickly skip interference check for empty sets.
-    if (VirtReg->empty() || LiveUnion->empty()) {
+    // Quickly skip interference check for empty sets, and for sets that
+    // don't even overlap.  The allocator probes every register in the
+    // allocation order, and most units only have segments far away from
+    // VirtReg.
+    if (VirtReg->empty() || LiveUnion->empty() ||
+        VirtReg->endIndex() <= LiveUnion->startIndex() ||
+        LiveUnion->endIndex() <= VirtReg->beginIndex()) {
       SeenAllInterferences = true;
       return 0;
     }
@@ -47,7 +47,12 @@ bool MachineFunctionAnalysis::runOnFunction(Function &F) {
   assert(!MF && "MachineFunctionAnalysis already initialized!");
   MF = new MachineFunction(&F, TM, NextFnNum++,
                            getAnalysis<MachineModuleInfo>(),
-                           getAnalysisIfAvailable<GCModuleInfo>());
+                           getAnalysisIfAvailable<GCModuleInfo>(), &Slabs);
+  return false;
+}
+
+bool MachineFunctionAnalysis::doFinalization(Module &M) {
+  Slabs.clear();
   return false;
 }
 
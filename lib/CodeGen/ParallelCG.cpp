@@ -0,0 +1,163 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+// LLVMContexts cannot be shared between threads, so the module is written to
+// bitcode once, and every worker reads its own copy into a private context,
+// strips it down to its partition and runs a complete code generation
+// pipeline on it.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "parallel-cg"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <vector>
+using namespace llvm;
+
+/// codeGen - Run the code generation pipeline for TM over M.
+static bool codeGen(Module &M, formatted_raw_ostream &OS, TargetMachine &TM,
+                    TargetMachine::CodeGenFileType FT,
+                    const TargetLibraryInfo *TLI, std::string &ErrMsg) {
+  PassManager PM;
+  if (TLI)
+    PM.add(new TargetLibraryInfo(*TLI));
+  TM.addAnalysisPasses(PM);
+  if (const DataLayout *DL = TM.getDataLayout())
+    PM.add(new DataLayout(*DL));
+  else
+    PM.add(new DataLayout(&M));
+
+  if (TM.addPassesToEmitFile(PM, OS, FT)) {
+    ErrMsg = "target does not support generation of this file type";
+    return true;
+  }
+  PM.run(M);
+  return false;
+}
+
+/// cloneTargetMachine - Create a target machine configured like TM.
+static TargetMachine *cloneTargetMachine(const TargetMachine &TM) {
+  TargetMachine *Clone =
+    TM.getTarget().createTargetMachine(TM.getTargetTriple(),
+                                       TM.getTargetCPU(),
+                                       TM.getTargetFeatureString(),
+                                       TM.Options, TM.getRelocationModel(),
+                                       TM.getCodeModel(), TM.getOptLevel());
+  if (!Clone)
+    return 0;
+  Clone->setMCRelaxAll(TM.hasMCRelaxAll());
+  Clone->setMCSaveTempLabels(TM.hasMCSaveTempLabels());
+  Clone->setMCNoExecStack(TM.hasMCNoExecStack());
+  Clone->setMCUseLoc(TM.hasMCUseLoc());
+  Clone->setMCUseCFI(TM.hasMCUseCFI());
+  Clone->setMCUseDwarfDirectory(TM.hasMCUseDwarfDirectory());
+  return Clone;
+}
+
+namespace {
+  /// SplitCodeGenState - What the workers share.  Every worker only writes
+  /// the entry of Errors for its own partition.
+  struct SplitCodeGenState {
+    StringRef Bitcode;
+    const ModuleSplitter *Splitter;
+    ArrayRef<formatted_raw_ostream *> OSs;
+    const TargetMachine *TM;
+    TargetMachine::CodeGenFileType FT;
+    const TargetLibraryInfo *TLI;
+    std::vector<std::string> Errors;
+  };
+}
+
+static void codeGenPartition(void *Arg, unsigned I) {
+  SplitCodeGenState &State = *static_cast<SplitCodeGenState *>(Arg);
+  std::string &ErrMsg = State.Errors[I];
+
+  LLVMContext Context;
+  OwningPtr<MemoryBuffer> Buffer(
+    MemoryBuffer::getMemBuffer(State.Bitcode, "", false));
+  OwningPtr<Module> M(ParseBitcodeFile(Buffer.get(), Context, &ErrMsg));
+  if (!M)
+    return;
+  State.Splitter->extractPartition(*M, I);
+
+  OwningPtr<TargetMachine> TM(cloneTargetMachine(*State.TM));
+  if (!TM) {
+    ErrMsg = "could not allocate target machine";
+    return;
+  }
+  codeGen(*M, *State.OSs[I], *TM, State.FT, State.TLI, ErrMsg);
+}
+
+bool llvm::splitCodeGen(Module *M, ArrayRef<formatted_raw_ostream *> OSs,
+                        const TargetMachine &TM,
+                        TargetMachine::CodeGenFileType FT,
+                        const TargetLibraryInfo *TLI, std::string &ErrMsg) {
+  assert(!OSs.empty() && "Need an output for every partition!");
+
+  // There is nothing to split; keep the module in its own context.
+  if (OSs.size() == 1) {
+    OwningPtr<TargetMachine> Clone(cloneTargetMachine(TM));
+    if (!Clone) {
+      ErrMsg = "could not allocate target machine";
+      return true;
+    }
+    return codeGen(*M, *OSs[0], *Clone, FT, TLI, ErrMsg);
+  }
+
+  ModuleSplitter Splitter(*M, OSs.size());
+
+  SmallString<0> Bitcode;
+  {
+    raw_svector_ostream BitcodeOS(Bitcode);
+    WriteBitcodeToFile(M, BitcodeOS);
+  }
+
+  // Statistics, the pass registry and friends need to be told that they are
+  // used from several threads.
+  if (!llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  SplitCodeGenState State;
+  State.Bitcode = Bitcode.str();
+  State.Splitter = &Splitter;
+  State.OSs = OSs;
+  State.TM = &TM;
+  State.FT = FT;
+  State.TLI = TLI;
+  State.Errors.resize(OSs.size());
+
+  DEBUG(dbgs() << "ParallelCG: compiling " << OSs.size() << " partitions of "
+               << M->getModuleIdentifier() << "\n");
+  llvm_execute_in_parallel(codeGenPartition, &State, OSs.size(), OSs.size());
+
+  for (unsigned I = 0, E = OSs.size(); I != E; ++I) {
+    if (State.Errors[I].empty())
+      continue;
+    ErrMsg = "partition " + utostr(I) + ": " + State.Errors[I];
+    return true;
+  }
+  return false;
+}
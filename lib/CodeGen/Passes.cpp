@@ -42,6 +42,8 @@ static cl::opt<bool> DisableBlockPlacement("disable-block-placement",
     cl::Hidden, cl::desc("Disable probability-driven block placement"));
 static cl::opt<bool> EnableBlockPlacementStats("enable-block-placement-stats",
     cl::Hidden, cl::desc("Collect probability-driven block placement stats"));
+static cl::opt<bool> DisableFunctionOrdering("disable-function-ordering",
+    cl::Hidden, cl::desc("Disable profile-guided function ordering"));
 static cl::opt<bool> DisableSSC("disable-ssc", cl::Hidden,
     cl::desc("Disable Stack Slot Coloring"));
 static cl::opt<bool> DisableMachineDCE("disable-machine-dce", cl::Hidden,
@@ -385,6 +387,15 @@ void TargetPassConfig::addIRPasses() {
   addPass(createUnreachableBlockEliminationPass());
 }
 
+/// Add IR passes that run on the whole module before the per-function codegen
+/// pipeline.
+void TargetPassConfig::addModuleIRPasses() {
+  // Functions are emitted in module order; lay them out along hot call edges
+  // before the function pass pipeline starts walking the module.
+  if (getOptLevel() != CodeGenOpt::None && !DisableFunctionOrdering)
+    addPass(createFunctionOrderingPass());
+}
+
 /// Turn exception handling constructs into something the code generators can
 /// handle.
 void TargetPassConfig::addPassesToHandleExceptions() {
@@ -0,0 +1,455 @@
+//===-- RegAllocLinearScan.cpp - Linear Scan Register Allocator -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the RALinearScan function pass, a register allocator that
+// sits between the fast and the greedy allocators in compile time and code
+// quality.
+//
+// Live ranges are visited once in order of their start point, like a classic
+// linear scan.  A range that finds no free register may evict cheaper ranges
+// that were never evicted before; an unspillable range may also evict ranges
+// with a larger allocation order.  Failing that, a range that spans several
+// blocks is split around the blocks that use it, and the remainder is spilled.
+// There is no region splitting and no interference caching, which is where the
+// greedy allocator spends most of its time.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "regalloc"
+#include "llvm/CodeGen/Passes.h"
+#include "AllocationOrder.h"
+#include "LiveDebugVariables.h"
+#include "RegAllocBase.h"
+#include "Spiller.h"
+#include "SplitKit.h"
+#include "llvm/ADT/IndexedMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/CodeGen/CalcSpillWeights.h"
+#include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/CodeGen/LiveRangeEdit.h"
+#include "llvm/CodeGen/LiveRegMatrix.h"
+#include "llvm/CodeGen/LiveStackAnalysis.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/RegAllocRegistry.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include "llvm/PassAnalysisSupport.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+#include <queue>
+
+using namespace llvm;
+
+STATISTIC(NumEvicted,     "Number of interferences evicted");
+STATISTIC(NumBlockSplits, "Number of live ranges split around blocks");
+
+static RegisterRegAlloc linearScanRegAlloc("linearscan",
+                                           "linear scan register allocator",
+                                           createLinearScanRegisterAllocator);
+
+namespace {
+/// RALinearScan assigns live ranges in start order, evicting and splitting
+/// around blocks when it runs out of registers.
+class RALinearScan : public MachineFunctionPass,
+                     public RegAllocBase,
+                     private LiveRangeEdit::Delegate {
+  // context
+  MachineFunction *MF;
+  SlotIndexes *Indexes;
+  LiveDebugVariables *DebugVars;
+
+  // state
+  OwningPtr<Spiller> SpillerInstance;
+  OwningPtr<SplitAnalysis> SA;
+  OwningPtr<SplitEditor> SE;
+  std::priority_queue<std::pair<unsigned, unsigned> > Queue;
+
+  /// LiveRangeStage - What a live range has been through so far.  Every range
+  /// moves forward through the stages, which guarantees termination.
+  enum LiveRangeStage {
+    /// RS_New - Never evicted or split.  Only these ranges can be evicted.
+    RS_New,
+
+    /// RS_Evicted - Evicted once, may still be split.
+    RS_Evicted,
+
+    /// RS_Split - Local range produced by block splitting.
+    RS_Split,
+
+    /// RS_Spill - Spill if no register is free.
+    RS_Spill
+  };
+
+  IndexedMap<unsigned char, VirtReg2IndexFunctor> Stage;
+
+  LiveRangeStage getStage(const LiveInterval &VirtReg) const {
+    return LiveRangeStage(Stage[VirtReg.reg]);
+  }
+
+  void setStage(const LiveInterval &VirtReg, LiveRangeStage S) {
+    Stage.grow(VirtReg.reg);
+    Stage[VirtReg.reg] = S;
+  }
+
+public:
+  RALinearScan();
+
+  /// Return the pass name.
+  virtual const char* getPassName() const {
+    return "Linear Scan Register Allocator";
+  }
+
+  /// RALinearScan analysis usage.
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+  virtual void releaseMemory();
+
+  virtual Spiller &spiller() { return *SpillerInstance; }
+
+  virtual void enqueue(LiveInterval *LI);
+
+  virtual LiveInterval *dequeue() {
+    if (Queue.empty())
+      return 0;
+    LiveInterval *LI = &LIS->getInterval(~Queue.top().second);
+    Queue.pop();
+    return LI;
+  }
+
+  virtual unsigned selectOrSplit(LiveInterval &VirtReg,
+                                 SmallVectorImpl<unsigned> &SplitVRegs);
+
+  /// Perform register allocation.
+  virtual bool runOnMachineFunction(MachineFunction &mf);
+
+  static char ID;
+
+private:
+  bool LRE_CanEraseVirtReg(unsigned);
+  void LRE_WillShrinkVirtReg(unsigned);
+  void LRE_DidCloneVirtReg(unsigned, unsigned);
+
+  bool canEvictInterference(LiveInterval &VirtReg, unsigned PhysReg,
+                            float &MaxWeight);
+  void evictInterference(LiveInterval &VirtReg, unsigned PhysReg);
+  unsigned tryEvict(LiveInterval &VirtReg, ArrayRef<unsigned> Candidates);
+  void splitAroundBlocks(LiveInterval &VirtReg,
+                         SmallVectorImpl<unsigned> &SplitVRegs);
+};
+
+char RALinearScan::ID = 0;
+
+} // end anonymous namespace
+
+RALinearScan::RALinearScan(): MachineFunctionPass(ID) {
+  initializeLiveDebugVariablesPass(*PassRegistry::getPassRegistry());
+  initializeSlotIndexesPass(*PassRegistry::getPassRegistry());
+  initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
+  initializeRegisterCoalescerPass(*PassRegistry::getPassRegistry());
+  initializeMachineSchedulerPass(*PassRegistry::getPassRegistry());
+  initializeCalculateSpillWeightsPass(*PassRegistry::getPassRegistry());
+  initializeLiveStacksPass(*PassRegistry::getPassRegistry());
+  initializeMachineDominatorTreePass(*PassRegistry::getPassRegistry());
+  initializeMachineLoopInfoPass(*PassRegistry::getPassRegistry());
+  initializeVirtRegMapPass(*PassRegistry::getPassRegistry());
+  initializeLiveRegMatrixPass(*PassRegistry::getPassRegistry());
+}
+
+void RALinearScan::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesCFG();
+  AU.addRequired<AliasAnalysis>();
+  AU.addPreserved<AliasAnalysis>();
+  AU.addRequired<SlotIndexes>();
+  AU.addPreserved<SlotIndexes>();
+  AU.addRequired<LiveIntervals>();
+  AU.addPreserved<LiveIntervals>();
+  AU.addRequired<LiveDebugVariables>();
+  AU.addPreserved<LiveDebugVariables>();
+  AU.addRequired<CalculateSpillWeights>();
+  AU.addRequired<LiveStacks>();
+  AU.addPreserved<LiveStacks>();
+  AU.addRequired<MachineBlockFrequencyInfo>();
+  AU.addPreserved<MachineBlockFrequencyInfo>();
+  AU.addRequiredID(MachineDominatorsID);
+  AU.addPreservedID(MachineDominatorsID);
+  AU.addRequired<MachineLoopInfo>();
+  AU.addPreserved<MachineLoopInfo>();
+  AU.addRequired<VirtRegMap>();
+  AU.addPreserved<VirtRegMap>();
+  AU.addRequired<LiveRegMatrix>();
+  AU.addPreserved<LiveRegMatrix>();
+  MachineFunctionPass::getAnalysisUsage(AU);
+}
+
+void RALinearScan::releaseMemory() {
+  SpillerInstance.reset(0);
+  SA.reset(0);
+  SE.reset(0);
+  Stage.clear();
+}
+
+//===----------------------------------------------------------------------===//
+//                     LiveRangeEdit delegate methods
+//===----------------------------------------------------------------------===//
+
+bool RALinearScan::LRE_CanEraseVirtReg(unsigned VirtReg) {
+  if (VRM->hasPhys(VirtReg)) {
+    Matrix->unassign(LIS->getInterval(VirtReg));
+    return true;
+  }
+  // Unassigned virtreg is probably in the priority queue.
+  // RegAllocBase will erase it after dequeueing.
+  return false;
+}
+
+void RALinearScan::LRE_WillShrinkVirtReg(unsigned VirtReg) {
+  if (!VRM->hasPhys(VirtReg))
+    return;
+
+  // Register is assigned, put it back on the queue for reassignment.
+  LiveInterval &LI = LIS->getInterval(VirtReg);
+  Matrix->unassign(LI);
+  enqueue(&LI);
+}
+
+void RALinearScan::LRE_DidCloneVirtReg(unsigned New, unsigned Old) {
+  // Cloning a register we haven't even heard about yet?  Just ignore it.
+  if (!Stage.inBounds(Old))
+    return;
+  Stage.grow(New);
+  Stage[New] = Stage[Old];
+}
+
+//===----------------------------------------------------------------------===//
+//                              Allocation
+//===----------------------------------------------------------------------===//
+
+void RALinearScan::enqueue(LiveInterval *LI) {
+  const unsigned Reg = LI->reg;
+  assert(TargetRegisterInfo::isVirtualRegister(Reg) &&
+         "Can only enqueue virtual registers");
+  Stage.grow(Reg);
+
+  // Visit ranges in order of their start point.  The distance to the end of
+  // the function is largest for the earliest start, and the virtual register
+  // number breaks ties.
+  unsigned Prio = 0;
+  if (!LI->empty())
+    Prio = LI->beginIndex().getInstrDistance(Indexes->getLastIndex());
+  Queue.push(std::make_pair(Prio, ~Reg));
+}
+
+/// canEvictInterference - Return true if all interference with VirtReg on
+/// PhysReg is cheaper than VirtReg and was never evicted before, or if the
+/// eviction is urgent.  Return the largest interfering weight in MaxWeight.
+bool RALinearScan::canEvictInterference(LiveInterval &VirtReg,
+                                        unsigned PhysReg, float &MaxWeight) {
+  MaxWeight = 0;
+  const TargetRegisterClass *RC = MRI->getRegClass(VirtReg.reg);
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    Q.collectInterferingVRegs();
+    if (VirtReg.isSpillable() && Q.seenUnspillableVReg())
+      return false;
+    for (unsigned i = Q.interferingVRegs().size(); i; --i) {
+      LiveInterval *Intf = Q.interferingVRegs()[i - 1];
+      // An unspillable range has nowhere else to go, so as in the greedy
+      // allocator it may evict anything spillable, and unspillable ranges
+      // with a strictly larger allocation order.  The order shrinks with
+      // every such eviction, so this can't go on forever.
+      bool Urgent = !VirtReg.isSpillable() &&
+        (Intf->isSpillable() ||
+         RegClassInfo.getNumAllocatableRegs(RC) <
+         RegClassInfo.getNumAllocatableRegs(MRI->getRegClass(Intf->reg)));
+      if (!Urgent && (!Intf->isSpillable() || Intf->weight >= VirtReg.weight ||
+                      getStage(*Intf) != RS_New))
+        return false;
+      MaxWeight = std::max(MaxWeight, Intf->weight);
+    }
+  }
+  return true;
+}
+
+/// evictInterference - Unassign all interference with VirtReg on PhysReg and
+/// put it back on the queue.
+void RALinearScan::evictInterference(LiveInterval &VirtReg, unsigned PhysReg) {
+  SmallVector<LiveInterval*, 8> Intfs;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    assert(Q.seenAllInterferences() && "Didn't check all interfererences.");
+    ArrayRef<LiveInterval*> IVR = Q.interferingVRegs();
+    Intfs.append(IVR.begin(), IVR.end());
+  }
+
+  for (unsigned i = 0, e = Intfs.size(); i != e; ++i) {
+    LiveInterval &Intf = *Intfs[i];
+    // The same VirtReg may be present in multiple RegUnits. Skip duplicates.
+    if (!VRM->hasPhys(Intf.reg))
+      continue;
+    DEBUG(dbgs() << "evicting " << Intf << '\n');
+    Matrix->unassign(Intf);
+    setStage(Intf, RS_Evicted);
+    enqueue(&Intf);
+    ++NumEvicted;
+  }
+}
+
+/// tryEvict - Evict the cheapest interference among the Candidates that
+/// VirtReg may evict.  Return the freed register, or 0.
+unsigned RALinearScan::tryEvict(LiveInterval &VirtReg,
+                                ArrayRef<unsigned> Candidates) {
+  unsigned BestPhys = 0;
+  float BestWeight = 0;
+  for (unsigned i = 0, e = Candidates.size(); i != e; ++i) {
+    float MaxWeight;
+    if (!canEvictInterference(VirtReg, Candidates[i], MaxWeight))
+      continue;
+    if (!BestPhys || MaxWeight < BestWeight) {
+      BestPhys = Candidates[i];
+      BestWeight = MaxWeight;
+    }
+  }
+  if (!BestPhys)
+    return 0;
+
+  evictInterference(VirtReg, BestPhys);
+  assert(!Matrix->checkInterference(VirtReg, BestPhys) &&
+         "Interference after eviction.");
+  return BestPhys;
+}
+
+/// splitAroundBlocks - Give every block that uses VirtReg its own local live
+/// range, and leave the remainder to the spiller.
+void RALinearScan::splitAroundBlocks(LiveInterval &VirtReg,
+                                     SmallVectorImpl<unsigned> &SplitVRegs) {
+  unsigned Reg = VirtReg.reg;
+  bool SingleInstrs = RegClassInfo.isProperSubClass(MRI->getRegClass(Reg));
+  LiveRangeEdit LREdit(&VirtReg, SplitVRegs, *MF, *LIS, VRM, this);
+  SE->reset(LREdit);
+  ArrayRef<SplitAnalysis::BlockInfo> UseBlocks = SA->getUseBlocks();
+  for (unsigned i = 0; i != UseBlocks.size(); ++i) {
+    const SplitAnalysis::BlockInfo &BI = UseBlocks[i];
+    if (SA->shouldSplitSingleBlock(BI, SingleInstrs))
+      SE->splitSingleBlock(BI);
+  }
+  // No blocks were split.
+  if (LREdit.empty())
+    return;
+
+  SmallVector<unsigned, 8> IntvMap;
+  SE->finish(&IntvMap);
+
+  // Tell LiveDebugVariables about the new ranges.
+  DebugVars->splitRegister(Reg, LREdit.regs(), *LIS);
+
+  // The remainder interval goes straight to spilling, the local ranges get
+  // one more chance at a register.
+  for (unsigned i = 0, e = LREdit.size(); i != e; ++i) {
+    LiveInterval &LI = LIS->getInterval(LREdit.get(i));
+    setStage(LI, IntvMap[i] == 0 ? RS_Spill : RS_Split);
+  }
+  ++NumBlockSplits;
+
+  if (VerifyEnabled)
+    MF->verify(this, "After splitting live range around basic blocks");
+}
+
+unsigned RALinearScan::selectOrSplit(LiveInterval &VirtReg,
+                                     SmallVectorImpl<unsigned> &SplitVRegs) {
+  // Registers that only have virtual register interference.
+  SmallVector<unsigned, 8> EvictCands;
+
+  AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo);
+  while (unsigned PhysReg = Order.next()) {
+    switch (Matrix->checkInterference(VirtReg, PhysReg)) {
+    case LiveRegMatrix::IK_Free:
+      return PhysReg;
+    case LiveRegMatrix::IK_VirtReg:
+      EvictCands.push_back(PhysReg);
+      continue;
+    default:
+      // RegMask or RegUnit interference.
+      continue;
+    }
+  }
+
+  if (unsigned PhysReg = tryEvict(VirtReg, EvictCands))
+    return PhysReg;
+
+  // Split a global range around its blocks.  The new ranges are queued by the
+  // caller.
+  if (getStage(VirtReg) < RS_Split && !LIS->intervalIsInOneMBB(VirtReg)) {
+    // Most functions never get here, so the splitter is created on demand.
+    if (!SA) {
+      SA.reset(new SplitAnalysis(*VRM, *LIS, getAnalysis<MachineLoopInfo>()));
+      SE.reset(new SplitEditor(*SA, *LIS, *VRM,
+                               getAnalysis<MachineDominatorTree>(),
+                               getAnalysis<MachineBlockFrequencyInfo>()));
+    }
+    SA->analyze(&VirtReg);
+    // SplitAnalysis may repair broken live ranges coming from the coalescer,
+    // which can make the range allocatable.
+    if (SA->didRepairRange()) {
+      Matrix->invalidateVirtRegs();
+      Order.rewind();
+      while (unsigned PhysReg = Order.next())
+        if (!Matrix->checkInterference(VirtReg, PhysReg))
+          return PhysReg;
+    }
+    splitAroundBlocks(VirtReg, SplitVRegs);
+    if (!SplitVRegs.empty())
+      return 0;
+  }
+
+  // Nothing else worked, spill VirtReg.
+  DEBUG(dbgs() << "spilling: " << VirtReg << '\n');
+  if (!VirtReg.isSpillable())
+    return ~0u;
+  LiveRangeEdit LRE(&VirtReg, SplitVRegs, *MF, *LIS, VRM, this);
+  spiller().spill(LRE);
+  // Spill products should not be split or evicted again.
+  for (unsigned i = 0, e = SplitVRegs.size(); i != e; ++i)
+    setStage(LIS->getInterval(SplitVRegs[i]), RS_Spill);
+
+  if (VerifyEnabled)
+    MF->verify(this, "After spilling");
+  return 0;
+}
+
+bool RALinearScan::runOnMachineFunction(MachineFunction &mf) {
+  DEBUG(dbgs() << "********** LINEAR SCAN REGISTER ALLOCATION **********\n"
+               << "********** Function: " << mf.getName() << '\n');
+
+  MF = &mf;
+  RegAllocBase::init(getAnalysis<VirtRegMap>(),
+                     getAnalysis<LiveIntervals>(),
+                     getAnalysis<LiveRegMatrix>());
+  Indexes = &getAnalysis<SlotIndexes>();
+  DebugVars = &getAnalysis<LiveDebugVariables>();
+  SpillerInstance.reset(createInlineSpiller(*this, *MF, *VRM));
+  Stage.clear();
+  Stage.resize(MRI->getNumVirtRegs());
+
+  allocatePhysRegs();
+
+  // Diagnostic output before rewriting
+  DEBUG(dbgs() << "Post alloc VirtRegMap:\n" << *VRM << "\n");
+
+  releaseMemory();
+  return true;
+}
+
+FunctionPass* llvm::createLinearScanRegisterAllocator() {
+  return new RALinearScan();
+}
@@ -51,6 +51,7 @@ STATISTIC(NumReMats   , "Number of instructions re-materialized");
 STATISTIC(NumInflated , "Number of register classes inflated");
 STATISTIC(NumLaneConflicts, "Number of dead lane conflicts tested");
 STATISTIC(NumLaneResolves,  "Number of dead lane conflicts resolved");
+STATISTIC(NumLargeSkipped,  "Number of copies of large intervals not joined");
 
 static cl::opt<bool>
 EnableJoining("join-liveintervals",
@@ -68,6 +69,28 @@ EnableGlobalCopies("join-globalcopies",
   cl::desc("Coalesce copies that span blocks (default=subtarget)"),
   cl::init(cl::BOU_UNSET), cl::Hidden);
 
+// Joining two intervals takes time proportional to the number of values in
+// both of them.  When a huge interval, like the result of a PHI with thousands
+// of operands, would be joined over and over again, stop after a while.  This
+// bounds the total work for copy-heavy functions.
+static cl::opt<unsigned>
+LargeIntervalSizeThreshold("large-interval-size-threshold", cl::Hidden,
+  cl::desc("Number of values above which an interval is considered large "
+           "by the coalescer"),
+  cl::init(100));
+
+static cl::opt<unsigned>
+LargeIntervalFreqThreshold("large-interval-freq-threshold", cl::Hidden,
+  cl::desc("Number of times a large interval may be joined before the "
+           "coalescer stops joining it"),
+  cl::init(100));
+
+static cl::opt<unsigned>
+MaxShrinkScan("coalescer-max-shrink-scan", cl::Hidden,
+  cl::desc("Number of instructions the coalescer looks at to trim a live "
+           "range after erasing a copy, before it recomputes the range"),
+  cl::init(100));
+
 static cl::opt<bool>
 VerifyCoalescing("verify-coalescing",
          cl::desc("Verify machine instrs before and after register coalescing"),
@@ -108,6 +131,10 @@ namespace {
     /// Virtual registers to be considered for register class inflation.
     SmallVector<unsigned, 8> InflateRegs;
 
+    /// LargeLIVisitCounter - Number of times each large interval has been
+    /// considered for joining.
+    DenseMap<unsigned, unsigned> LargeLIVisitCounter;
+
     /// Recursively eliminate dead defs in DeadDefs.
     void eliminateDeadDefs();
 
@@ -182,6 +209,16 @@ namespace {
     /// eliminateUndefCopy - Handle copies of undef values.
     bool eliminateUndefCopy(MachineInstr *CopyMI, const CoalescerPair &CP);
 
+    /// shrinkAfterErasedUse - Update LI after the instruction at Idx, which
+    /// read it, was erased.  Only the segment killed there is trimmed back
+    /// to the previous reader in its block.  Return false when that isn't
+    /// enough and LI must be recomputed with shrinkToUses().
+    bool shrinkAfterErasedUse(LiveInterval &LI, SlotIndex Idx);
+
+    /// isHighCostLiveInterval - Return true if LI is large and has already
+    /// been considered for joining too often to be worth the time again.
+    bool isHighCostLiveInterval(LiveInterval &LI);
+
   public:
     static char ID; // Class identification, replacement for typeinfo
     RegisterCoalescer() : MachineFunctionPass(ID) {
@@ -1094,6 +1131,15 @@ bool RegisterCoalescer::joinCopy(MachineInstr *CopyMI, bool &Again) {
       CP.flip();
   }
 
+  // Don't spend more time on intervals that have grown too large.
+  if (!CP.isPhys() &&
+      (isHighCostLiveInterval(LIS->getInterval(CP.getDstReg())) ||
+       isHighCostLiveInterval(LIS->getInterval(CP.getSrcReg())))) {
+    DEBUG(dbgs() << "\tInterval too large to join again.\n");
+    ++NumLargeSkipped;
+    return false;
+  }
+
   // Okay, attempt to join these two intervals.  On failure, this returns false.
   // Otherwise, if one of the intervals being joined is a physreg, this method
   // always canonicalizes DstInt to be it.  The output "SrcInt" will not have
@@ -1407,9 +1453,9 @@ public:
   /// Erase any machine instructions that have been coalesced away.
   /// Add erased instructions to ErasedInstrs.
   /// Add foreign virtual registers to ShrinkRegs if their live range ended at
-  /// the erased instrs.
+  /// the erased instrs, together with the index of the erased instr.
   void eraseInstrs(SmallPtrSet<MachineInstr*, 8> &ErasedInstrs,
-                   SmallVectorImpl<unsigned> &ShrinkRegs);
+                   SmallVectorImpl<std::pair<unsigned, SlotIndex> > &ShrinkRegs);
 
   /// Get the value assignments suitable for passing to LiveInterval::join.
   const int *getAssignments() const { return Assignments.data(); }
@@ -1922,7 +1968,7 @@ void JoinVals::pruneValues(JoinVals &Other,
 }
 
 void JoinVals::eraseInstrs(SmallPtrSet<MachineInstr*, 8> &ErasedInstrs,
-                           SmallVectorImpl<unsigned> &ShrinkRegs) {
+                 SmallVectorImpl<std::pair<unsigned, SlotIndex> > &ShrinkRegs) {
   for (unsigned i = 0, e = LI.getNumValNums(); i != e; ++i) {
     // Get the def location before markUnused() below invalidates it.
     SlotIndex Def = LI.getValNumInfo(i)->def;
@@ -1948,7 +1994,7 @@ void JoinVals::eraseInstrs(SmallPtrSet<MachineInstr*, 8> &ErasedInstrs,
         unsigned Reg = MI->getOperand(1).getReg();
         if (TargetRegisterInfo::isVirtualRegister(Reg) &&
             Reg != CP.getSrcReg() && Reg != CP.getDstReg())
-          ShrinkRegs.push_back(Reg);
+          ShrinkRegs.push_back(std::make_pair(Reg, Def));
       }
       ErasedInstrs.insert(MI);
       DEBUG(dbgs() << "\t\terased:\t" << Def << '\t' << *MI);
@@ -1994,11 +2040,15 @@ bool RegisterCoalescer::joinVirtRegs(CoalescerPair &CP) {
 
   // Erase COPY and IMPLICIT_DEF instructions. This may cause some external
   // registers to require trimming.
-  SmallVector<unsigned, 8> ShrinkRegs;
+  SmallVector<std::pair<unsigned, SlotIndex>, 8> ShrinkRegs;
   LHSVals.eraseInstrs(ErasedInstrs, ShrinkRegs);
   RHSVals.eraseInstrs(ErasedInstrs, ShrinkRegs);
-  while (!ShrinkRegs.empty())
-    LIS->shrinkToUses(&LIS->getInterval(ShrinkRegs.pop_back_val()));
+  while (!ShrinkRegs.empty()) {
+    std::pair<unsigned, SlotIndex> Shrink = ShrinkRegs.pop_back_val();
+    LiveInterval &LI = LIS->getInterval(Shrink.first);
+    if (!shrinkAfterErasedUse(LI, Shrink.second))
+      LIS->shrinkToUses(&LI);
+  }
 
   // Join RHS into LHS.
   LHS.join(RHS, LHSVals.getAssignments(), RHSVals.getAssignments(), NewVNInfo);
@@ -2081,6 +2131,51 @@ static bool isLocalCopy(MachineInstr *Copy, const LiveIntervals *LIS) {
     || LIS->intervalIsInOneMBB(LIS->getInterval(DstReg));
 }
 
+bool RegisterCoalescer::shrinkAfterErasedUse(LiveInterval &LI, SlotIndex Idx) {
+  SlotIndex UseIdx = Idx.getRegSlot();
+  LiveInterval::iterator S = LI.find(UseIdx.getPrevSlot());
+  if (S == LI.end() || S->start > UseIdx.getPrevSlot())
+    return false;
+
+  // The value is still live after the erased instruction.  The segment ends
+  // at a later reader or at the end of the block, so it is still valid.
+  if (S->end != UseIdx)
+    return true;
+
+  // Segments spanning several blocks need the full update.
+  SlotIndexes *Indexes = LIS->getSlotIndexes();
+  if (Indexes->getMBBFromIndex(S->start) != Indexes->getMBBFromIndex(Idx))
+    return false;
+
+  // Find the last remaining reader before the erased instruction.  Readers
+  // at the instruction that starts the segment read an earlier value.
+  SlotIndex StartIdx = S->start.getBaseIndex();
+  SlotIndex I = Idx.getBaseIndex();
+  for (unsigned Scanned = 0; Scanned != MaxShrinkScan; ++Scanned) {
+    I = I.getPrevIndex();
+    if (I == StartIdx)
+      return false;
+    MachineInstr *MI = Indexes->getInstructionFromIndex(I);
+    if (!MI || MI->isDebugValue() || !MI->readsVirtualRegister(LI.reg))
+      continue;
+    S->end = I.getRegSlot();
+    DEBUG(dbgs() << "\t\ttrimmed:\t" << LI << '\n');
+    return true;
+  }
+  return false;
+}
+
+bool RegisterCoalescer::isHighCostLiveInterval(LiveInterval &LI) {
+  if (LI.getNumValNums() < LargeIntervalSizeThreshold)
+    return false;
+  unsigned &Counter = LargeLIVisitCounter[LI.reg];
+  if (Counter < LargeIntervalFreqThreshold) {
+    ++Counter;
+    return false;
+  }
+  return true;
+}
+
 // Try joining WorkList copies starting from index From.
 // Null out any successful joins.
 bool RegisterCoalescer::
@@ -2187,6 +2282,7 @@ void RegisterCoalescer::releaseMemory() {
   WorkList.clear();
   DeadDefs.clear();
   InflateRegs.clear();
+  LargeLIVisitCounter.clear();
 }
 
 bool RegisterCoalescer::runOnMachineFunction(MachineFunction &fn) {
@@ -63,36 +63,64 @@ const MCInstrDesc *ScheduleDAG::getNodeDesc(const SDNode *Node) const {
 /// not already.  It also adds the current node as a successor of the
 /// specified node.
 bool SUnit::addPred(const SDep &D, bool Required) {
+  SDep P = D;
+  P.setSUnit(this);
+  SUnit *N = D.getSUnit();
   // If this node already has this depenence, don't add a redundant one.
-  for (SmallVectorImpl<SDep>::iterator I = Preds.begin(), E = Preds.end();
-         I != E; ++I) {
-    // Zero-latency weak edges may be added purely for heuristic ordering. Don't
-    // add them if another kind of edge already exists.
-    if (!Required && I->getSUnit() == D.getSUnit())
-      return false;
-    if (I->overlaps(D)) {
-      // Extend the latency if needed. Equivalent to removePred(I) + addPred(D).
-      if (I->getLatency() < D.getLatency()) {
-        SUnit *PredSU = I->getSUnit();
-        // Find the corresponding successor in N.
-        SDep ForwardD = *I;
-        ForwardD.setSUnit(this);
-        for (SmallVectorImpl<SDep>::iterator II = PredSU->Succs.begin(),
-               EE = PredSU->Succs.end(); II != EE; ++II) {
-          if (*II == ForwardD) {
-            II->setLatency(D.getLatency());
-            break;
+  // Every edge is recorded at both ends in the same relative order, so either
+  // list can be searched.  Use the shorter one; the boundary nodes of a large
+  // region collect thousands of edges.
+  if (N->Succs.size() < Preds.size()) {
+    for (SmallVectorImpl<SDep>::iterator II = N->Succs.begin(),
+           EE = N->Succs.end(); II != EE; ++II) {
+      if (II->getSUnit() != this)
+        continue;
+      if (!Required)
+        return false;
+      if (II->overlaps(P)) {
+        if (II->getLatency() < D.getLatency()) {
+          // Find the corresponding predecessor in this node.
+          SDep BackwardD = *II;
+          BackwardD.setSUnit(N);
+          for (SmallVectorImpl<SDep>::iterator I = Preds.begin(),
+                 E = Preds.end(); I != E; ++I) {
+            if (*I == BackwardD) {
+              I->setLatency(D.getLatency());
+              break;
+            }
           }
+          II->setLatency(D.getLatency());
         }
-        I->setLatency(D.getLatency());
+        return false;
+      }
+    }
+  } else {
+    for (SmallVectorImpl<SDep>::iterator I = Preds.begin(), E = Preds.end();
+           I != E; ++I) {
+      // Zero-latency weak edges may be added purely for heuristic ordering.
+      // Don't add them if another kind of edge already exists.
+      if (!Required && I->getSUnit() == N)
+        return false;
+      if (I->overlaps(D)) {
+        // Extend the latency if needed. Equivalent to removePred(I) +
+        // addPred(D).
+        if (I->getLatency() < D.getLatency()) {
+          // Find the corresponding successor in N.
+          SDep ForwardD = *I;
+          ForwardD.setSUnit(this);
+          for (SmallVectorImpl<SDep>::iterator II = N->Succs.begin(),
+                 EE = N->Succs.end(); II != EE; ++II) {
+            if (*II == ForwardD) {
+              II->setLatency(D.getLatency());
+              break;
+            }
+          }
+          I->setLatency(D.getLatency());
+        }
+        return false;
       }
-      return false;
     }
   }
-  // Now add a corresponding succ to N.
-  SDep P = D;
-  P.setSUnit(this);
-  SUnit *N = D.getSUnit();
   // Update the bookkeeping.
   if (D.getKind() == SDep::Data) {
     assert(NumPreds < UINT_MAX && "NumPreds will overflow!");
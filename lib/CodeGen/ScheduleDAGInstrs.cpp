@@ -404,13 +404,16 @@ void ScheduleDAGInstrs::addVRegUseDeps(SUnit *SU, unsigned OperIdx) {
   MachineInstr *MI = SU->getInstr();
   unsigned Reg = MI->getOperand(OperIdx).getReg();
 
-  // Record this local VReg use.
-  VReg2UseMap::iterator UI = VRegUses.find(Reg);
-  for (; UI != VRegUses.end(); ++UI) {
-    if (UI->SU == SU)
-      break;
+  // Record this local VReg use, unless an earlier operand of MI already did.
+  // Searching the use list instead would be quadratic in the number of uses
+  // of a widely used vreg such as a base pointer.
+  bool Recorded = false;
+  for (unsigned i = 0; i != OperIdx && !Recorded; ++i) {
+    const MachineOperand &MO = MI->getOperand(i);
+    Recorded = MO.isReg() && MO.getReg() == Reg && !MO.isDef() &&
+               MO.readsReg();
   }
-  if (UI == VRegUses.end())
+  if (!Recorded)
     VRegUses.insert(VReg2SUnit(Reg, SU));
 
   // Lookup this operand's reaching definition.
@@ -934,7 +937,7 @@ void ScheduleDAGInstrs::buildSchedGraph(AliasAnalysis *AA,
       if (BarrierChain)
         BarrierChain->addPred(SDep(SU, SDep::Barrier));
 
-      if (!ExitSU.isPred(SU))
+      if (!SU->isSucc(&ExitSU))
         // Push store's up a bit to avoid them getting in between cmp
         // and branches.
         ExitSU.addPred(SDep(SU, SDep::Artificial));
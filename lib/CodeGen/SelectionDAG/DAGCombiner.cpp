@@ -82,18 +82,13 @@ namespace {
     // also only appear once. The naive approach to this takes
     // linear time.
     //
-    // To reduce the insert/remove time to logarithmic, we use
-    // a set and a vector to maintain our worklist.
-    //
-    // The set contains the items on the worklist, but does not
-    // maintain the order they should be visited.
-    //
-    // The vector maintains the order nodes should be visited, but may
-    // contain duplicate or removed nodes. When choosing a node to
-    // visit, we pop off the order stack until we find an item that is
-    // also in the contents set. All operations are O(log N).
-    SmallPtrSet<SDNode*, 64> WorkListContents;
-    SmallVector<SDNode*, 64> WorkListOrder;
+    // To make insert/remove constant time, every node on the worklist
+    // records its position in the vector (see
+    // SDNode::getCombinerWorklistIndex).  Removing a node, or moving it to
+    // the back, leaves a null entry behind that is skipped when it is
+    // popped.  WorkListSize counts the nodes actually on the worklist.
+    SmallVector<SDNode*, 64> WorkList;
+    unsigned WorkListSize;
 
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
@@ -116,14 +111,39 @@ namespace {
     /// AddToWorkList - Add to the work list making sure its instance is at the
     /// back (next to be processed.)
     void AddToWorkList(SDNode *N) {
-      WorkListContents.insert(N);
-      WorkListOrder.push_back(N);
+      int Index = N->getCombinerWorklistIndex();
+      if (Index >= 0) {
+        // Already on the worklist; move it to the back.
+        if ((unsigned)Index + 1 == WorkList.size())
+          return;
+        WorkList[Index] = 0;
+      } else {
+        ++WorkListSize;
+      }
+      N->setCombinerWorklistIndex(WorkList.size());
+      WorkList.push_back(N);
     }
 
     /// removeFromWorkList - remove all instances of N from the worklist.
     ///
     void removeFromWorkList(SDNode *N) {
-      WorkListContents.erase(N);
+      int Index = N->getCombinerWorklistIndex();
+      if (Index < 0)
+        return;
+      WorkList[Index] = 0;
+      N->setCombinerWorklistIndex(-1);
+      --WorkListSize;
+    }
+
+    /// getNextWorkListEntry - Pop the node at the back of the worklist.
+    SDNode *getNextWorkListEntry() {
+      SDNode *N;
+      do {
+        N = WorkList.pop_back_val();
+      } while (!N);
+      N->setCombinerWorklistIndex(-1);
+      --WorkListSize;
+      return N;
     }
 
     SDValue CombineTo(SDNode *N, const SDValue *To, unsigned NumTo,
@@ -329,7 +349,8 @@ namespace {
   public:
     DAGCombiner(SelectionDAG &D, AliasAnalysis &A, CodeGenOpt::Level OL)
         : DAG(D), TLI(D.getTargetLoweringInfo()), Level(BeforeLegalizeTypes),
-          OptLevel(OL), LegalOperations(false), LegalTypes(false), AA(A) {
+          OptLevel(OL), LegalOperations(false), LegalTypes(false),
+          WorkListSize(0), AA(A) {
       AttributeSet FnAttrs =
           DAG.getMachineFunction().getFunction()->getAttributes();
       ForCodeSize =
@@ -707,6 +728,7 @@ CommitTargetLoweringOpt(const TargetLowering::TargetLoweringOpt &TLO) {
       if (TLO.Old.getNode()->getOperand(i).getNode()->hasOneUse())
         AddToWorkList(TLO.Old.getNode()->getOperand(i).getNode());
 
+    removeFromWorkList(TLO.Old.getNode());
     DAG.DeleteNode(TLO.Old.getNode());
   }
 }
@@ -1036,16 +1058,8 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
 
   // while the worklist isn't empty, find a node and
   // try and combine it.
-  while (!WorkListContents.empty()) {
-    SDNode *N;
-    // The WorkListOrder holds the SDNodes in order, but it may contain
-    // duplicates.
-    // In order to avoid a linear scan, we use a set (O(log N)) to hold what the
-    // worklist *should* contain, and check the node we want to visit is should
-    // actually be visited.
-    do {
-      N = WorkListOrder.pop_back_val();
-    } while (!WorkListContents.erase(N));
+  while (WorkListSize) {
+    SDNode *N = getNextWorkListEntry();
 
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
@@ -5746,6 +5760,7 @@ SDValue DAGCombiner::visitBITCAST(SDNode *N) {
       // Ideally this won't happen very often, because instcombine
       // and the earlier dagcombine runs (where illegal nodes are
       // permitted) should have folded most of them already.
+      removeFromWorkList(Res.getNode());
       DAG.DeleteNode(Res.getNode());
     }
   }
@@ -7286,6 +7301,7 @@ bool DAGCombiner::CombineToPreIndexedLoadStore(SDNode *N) {
   }
 
   // Finally, since the node is now dead, remove it from the graph.
+  removeFromWorkList(N);
   DAG.DeleteNode(N);
 
   if (Swapped)
@@ -7462,6 +7478,7 @@ bool DAGCombiner::CombineToPostIndexedLoadStore(SDNode *N) {
         }
 
         // Finally, since the node is now dead, remove it from the graph.
+        removeFromWorkList(N);
         DAG.DeleteNode(N);
 
         // Replace the uses of Use with uses of the updated base value.
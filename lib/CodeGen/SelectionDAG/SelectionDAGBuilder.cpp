@@ -17,6 +17,7 @@
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/ConstantFolding.h"
@@ -61,6 +62,9 @@
 #include <algorithm>
 using namespace llvm;
 
+STATISTIC(NumEBBRecomputed, "Number of values recomputed in a later block of "
+                            "their extended basic block");
+
 /// LimitFloatPrecision - Generate low-precision inline sequences for
 /// some float libcalls (6, 8 or 12 bits).
 static unsigned LimitFloatPrecision;
@@ -72,6 +76,21 @@ LimitFPPrecision("limit-float-precision",
                  cl::location(LimitFloatPrecision),
                  cl::init(0));
 
+// Selection DAGs are built one basic block at a time, so patterns spanning
+// blocks are normally only matched after CodeGenPrepare sinks the relevant
+// computation.  With this option a block's DAG also covers the cheap
+// computations of its extended basic block (the chain of single predecessors
+// leading to it) that its addresses and conditions are built from.
+static cl::opt<bool>
+EnableEBBISel("isel-extended-blocks", cl::Hidden,
+              cl::desc("Select cheap values from predecessors in the same "
+                       "extended basic block together with their users "
+                       "(experimental)"),
+              cl::init(false));
+
+// Only look this many blocks up the chain of single predecessors.
+static const unsigned MaxEBBDepth = 8;
+
 // Limit the width of DAG chains. This is important in general to prevent
 // prevent DAG-based analysis from blowing up. For example, alias analysis and
 // load clustering may not complete in reasonable time. It is difficult to
@@ -961,8 +980,11 @@ void SelectionDAGBuilder::visit(const Instruction &I) {
 
   visit(I.getOpcode(), I);
 
-  if (!isa<TerminatorInst>(&I) && !HasTailCall)
+  if (!isa<TerminatorInst>(&I) && !HasTailCall) {
     CopyToExportRegsIfNeeded(&I);
+    if (EnableEBBISel && OptLevel != CodeGenOpt::None)
+      ExportOperandsForEBBUsers(I);
+  }
 
   CurInst = NULL;
 }
@@ -1015,6 +1037,12 @@ SDValue SelectionDAGBuilder::getValue(const Value *V) {
   SDValue &N = NodeMap[V];
   if (N.getNode()) return N;
 
+  // Select cheap values from an earlier block of the extended basic block
+  // again when that lets them fold into the current instruction.
+  if (const Instruction *Inst = dyn_cast<Instruction>(V))
+    if (CurInst && shouldRecomputeInCurrentBlock(Inst))
+      return recomputeInCurrentBlock(Inst);
+
   // If there's a virtual register allocated and initialized for this
   // value, use it.
   DenseMap<const Value *, unsigned>::iterator It = FuncInfo.ValueMap.find(V);
@@ -1035,6 +1063,131 @@ SDValue SelectionDAGBuilder::getValue(const Value *V) {
   return Val;
 }
 
+/// isCheapToRecompute - Return true if I can be evaluated a second time in a
+/// later block without changing the program or costing much.
+static bool isCheapToRecompute(const Instruction *I) {
+  if (I->getType()->isVectorTy())
+    return false;
+  switch (I->getOpcode()) {
+  default:
+    return false;
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::Mul:
+  case Instruction::Shl:
+  case Instruction::LShr:
+  case Instruction::AShr:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+  case Instruction::ICmp:
+  case Instruction::GetElementPtr:
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+  case Instruction::PtrToInt:
+  case Instruction::IntToPtr:
+  case Instruction::BitCast:
+    return true;
+  }
+}
+
+/// isFoldingUse - Return true if the target can usually fold V into U when
+/// both are in the same DAG: V is the address of a load or store, or the
+/// comparison a branch or select is controlled by.
+static bool isFoldingUse(const Instruction *U, const Value *V) {
+  if (const LoadInst *LI = dyn_cast<LoadInst>(U))
+    return LI->getPointerOperand() == V;
+  if (const StoreInst *SI = dyn_cast<StoreInst>(U))
+    return SI->getPointerOperand() == V;
+  if (!isa<CmpInst>(V))
+    return false;
+  if (const BranchInst *BI = dyn_cast<BranchInst>(U))
+    return BI->isConditional() && BI->getCondition() == V;
+  if (const SelectInst *SI = dyn_cast<SelectInst>(U))
+    return SI->getCondition() == V;
+  return false;
+}
+
+/// isEBBPredecessor - Return true if Pred is reached from BB by following
+/// single predecessors, i.e. Pred dominates BB in their extended basic block.
+static bool isEBBPredecessor(const BasicBlock *Pred, const BasicBlock *BB) {
+  for (unsigned i = 0; BB && i != MaxEBBDepth; ++i) {
+    BB = BB->getSinglePredecessor();
+    if (BB == Pred)
+      return true;
+  }
+  return false;
+}
+
+/// ExportOperandsForEBBUsers - If I is used by an instruction it can fold
+/// into in a later block of the extended basic block, make its operands
+/// available there as well, so that the later block can select I again.
+void SelectionDAGBuilder::ExportOperandsForEBBUsers(const Instruction &I) {
+  if (!isCheapToRecompute(&I) || !FuncInfo.isExportedInst(&I))
+    return;
+
+  bool HasFoldingUse = false;
+  for (Value::const_use_iterator UI = I.use_begin(), E = I.use_end();
+       UI != E && !HasFoldingUse; ++UI) {
+    const Instruction *User = cast<Instruction>(*UI);
+    HasFoldingUse = User->getParent() != I.getParent() &&
+                    isFoldingUse(User, &I) &&
+                    isEBBPredecessor(I.getParent(), User->getParent());
+  }
+  if (!HasFoldingUse)
+    return;
+
+  for (unsigned i = 0, e = I.getNumOperands(); i != e; ++i) {
+    const Value *Op = I.getOperand(i);
+    if (Op->getType()->isEmptyTy())
+      continue;
+    if (const AllocaInst *AI = dyn_cast<AllocaInst>(Op))
+      if (FuncInfo.StaticAllocaMap.count(AI))
+        continue;
+    ExportFromCurrentBlock(Op);
+  }
+}
+
+/// shouldRecomputeInCurrentBlock - Return true if I was defined in an earlier
+/// block of the current extended basic block, folds into the instruction
+/// being selected and all of its operands are available here.
+bool
+SelectionDAGBuilder::shouldRecomputeInCurrentBlock(const Instruction *I) {
+  if (!EnableEBBISel || OptLevel == CodeGenOpt::None)
+    return false;
+  if (!isFoldingUse(CurInst, I) || !isCheapToRecompute(I))
+    return false;
+  const BasicBlock *BB = FuncInfo.MBB->getBasicBlock();
+  if (!BB || I->getParent() == BB || !isEBBPredecessor(I->getParent(), BB))
+    return false;
+
+  for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i) {
+    const Value *Op = I->getOperand(i);
+    if (isa<Constant>(Op) || FuncInfo.isExportedInst(Op))
+      continue;
+    if (const AllocaInst *AI = dyn_cast<AllocaInst>(Op))
+      if (FuncInfo.StaticAllocaMap.count(AI))
+        continue;
+    DenseMap<const Value*, SDValue>::const_iterator It = NodeMap.find(Op);
+    if (It == NodeMap.end() || !It->second.getNode())
+      return false;
+  }
+  return true;
+}
+
+/// recomputeInCurrentBlock - Build the nodes for I, which was defined in an
+/// earlier block, again in the current DAG.
+SDValue SelectionDAGBuilder::recomputeInCurrentBlock(const Instruction *I) {
+  DEBUG(dbgs() << "Recomputing in extended basic block: " << *I << '\n');
+  ++NumEBBRecomputed;
+  const Instruction *SavedInst = CurInst;
+  CurInst = I;
+  visit(I->getOpcode(), *I);
+  CurInst = SavedInst;
+  return NodeMap[I];
+}
+
 /// getNonRegisterValue - Return an SDValue for the given Value, but
 /// don't look in FuncInfo.ValueMap for a virtual register.
 SDValue SelectionDAGBuilder::getNonRegisterValue(const Value *V) {
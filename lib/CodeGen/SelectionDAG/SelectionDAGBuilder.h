@@ -616,6 +616,9 @@ public:
   bool isExportableFromCurrentBlock(const Value *V, const BasicBlock *FromBB);
   void CopyToExportRegsIfNeeded(const Value *V);
   void ExportFromCurrentBlock(const Value *V);
+  void ExportOperandsForEBBUsers(const Instruction &I);
+  bool shouldRecomputeInCurrentBlock(const Instruction *I);
+  SDValue recomputeInCurrentBlock(const Instruction *I);
   void LowerCallTo(ImmutableCallSite CS, SDValue Callee, bool IsTailCall,
                    MachineBasicBlock *LandingPad = NULL);
 
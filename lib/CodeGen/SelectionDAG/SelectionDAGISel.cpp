@@ -45,6 +45,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -59,6 +60,9 @@
 #include <algorithm>
 using namespace llvm;
 
+// CreateInfoOutputFile - Return a file stream to print our output on.
+namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
+
 STATISTIC(NumFastIselFailures, "Number of instructions fast isel failed on");
 STATISTIC(NumFastIselSuccess, "Number of instructions fast isel selected");
 STATISTIC(NumFastIselBlocks, "Number of blocks selected entirely by fast isel");
@@ -152,6 +156,10 @@ EnableFastISelAbort("fast-isel-abort", cl::Hidden,
           cl::desc("Enable abort calls when \"fast\" instruction selection "
                    "fails to lower an instruction"));
 static cl::opt<bool>
+EnableFastISelReport("fast-isel-report", cl::Hidden,
+          cl::desc("Print a summary of the instructions the \"fast\" "
+                   "instruction selector left to SelectionDAG"));
+static cl::opt<bool>
 EnableFastISelAbortArgs("fast-isel-abort-args", cl::Hidden,
           cl::desc("Enable abort calls when \"fast\" instruction selection "
                    "fails to lower a formal argument"));
@@ -284,7 +292,7 @@ SelectionDAGISel::SelectionDAGISel(TargetMachine &tm,
   SDB(new SelectionDAGBuilder(*CurDAG, *FuncInfo, OL)),
   GFI(),
   OptLevel(OL),
-  DAGSize(0) {
+  DAGSize(0), NumFastISelSelected(0), NumFastISelMissed(0) {
     initializeGCModuleInfoPass(*PassRegistry::getPassRegistry());
     initializeAliasAnalysisAnalysisGroup(*PassRegistry::getPassRegistry());
     initializeBranchProbabilityInfoPass(*PassRegistry::getPassRegistry());
@@ -941,6 +949,98 @@ static void collectFailStats(const Instruction *I) {
 }
 #endif
 
+/// getFastISelMissKind - Describe the instruction FastISel gave up on for
+/// -fast-isel-report: its opcode, the intrinsic or the kind of callee for
+/// calls, and whether it operates on vectors.
+static std::string getFastISelMissKind(const Instruction *I) {
+  std::string Kind = I->getOpcodeName();
+  if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(I)) {
+    Kind += " " + Intrinsic::getName(II->getIntrinsicID());
+  } else if (const CallInst *CI = dyn_cast<CallInst>(I)) {
+    if (CI->isInlineAsm())
+      Kind += " asm";
+    else if (!CI->getCalledFunction())
+      Kind += " indirect";
+  }
+
+  bool IsVector = I->getType()->isVectorTy();
+  for (unsigned i = 0, e = I->getNumOperands(); i != e && !IsVector; ++i)
+    IsVector = I->getOperand(i)->getType()->isVectorTy();
+  if (IsVector)
+    Kind += " <vector>";
+  return Kind;
+}
+
+void SelectionDAGISel::recordFastISelMiss(StringRef Kind, unsigned NumMissed) {
+  std::pair<unsigned, unsigned> &Entry = FastISelMisses[Kind];
+  ++Entry.first;
+  Entry.second += NumMissed;
+  NumFastISelMissed += NumMissed;
+}
+
+namespace {
+  typedef std::pair<StringRef, std::pair<unsigned, unsigned> > FastISelMiss;
+
+  /// MissOrder - Sort the report by the number of instructions left to
+  /// SelectionDAG, most first.
+  struct MissOrder {
+    bool operator()(const FastISelMiss &A, const FastISelMiss &B) const {
+      if (A.second.second != B.second.second)
+        return A.second.second > B.second.second;
+      if (A.second.first != B.second.first)
+        return A.second.first > B.second.first;
+      return A.first < B.first;
+    }
+  };
+}
+
+void SelectionDAGISel::printFastISelReport(raw_ostream &OS) const {
+  std::vector<FastISelMiss> Misses;
+  for (StringMap<std::pair<unsigned, unsigned> >::const_iterator
+       I = FastISelMisses.begin(), E = FastISelMisses.end(); I != E; ++I)
+    Misses.push_back(FastISelMiss(I->getKey(), I->getValue()));
+  std::sort(Misses.begin(), Misses.end(), MissOrder());
+
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                       ... FastISel Fallback Report ...\n"
+     << "===" << std::string(73, '-') << "===\n\n";
+
+  unsigned Total = NumFastISelSelected + NumFastISelMissed;
+  OS << format("%8u", NumFastISelSelected)
+     << " instructions selected by FastISel\n"
+     << format("%8u", NumFastISelMissed)
+     << " instructions selected by SelectionDAG\n";
+  if (Total)
+    OS << format("%7.1f%%", 100.0 * NumFastISelSelected / Total)
+       << " FastISel coverage\n";
+
+  if (Misses.empty()) {
+    OS << '\n';
+    OS.flush();
+    return;
+  }
+
+  // Each miss hands the instruction and everything above it in the block
+  // (just the instruction for calls) over to SelectionDAG.
+  OS << "\n  Misses    Insts  Instruction\n";
+  for (unsigned i = 0, e = Misses.size(); i != e; ++i)
+    OS << format("%8u %8u", Misses[i].second.first, Misses[i].second.second)
+       << "  " << Misses[i].first << '\n';
+  OS << '\n';
+  OS.flush();
+}
+
+bool SelectionDAGISel::doFinalization(Module &M) {
+  if (EnableFastISelReport && TM.Options.EnableFastISel) {
+    raw_ostream &OutStream = *CreateInfoOutputFile();
+    printFastISelReport(OutStream);
+    delete &OutStream;
+  }
+  FastISelMisses.clear();
+  NumFastISelSelected = NumFastISelMissed = 0;
+  return MachineFunctionPass::doFinalization(M);
+}
+
 void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
   // Initialize the Fast-ISel state, if needed.
   FastISel *FastIS = 0;
@@ -1002,6 +1102,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (!FastIS->LowerArguments()) {
           // Fast isel failed to lower these arguments
           ++NumFastIselFailLowerArguments;
+          if (EnableFastISelReport)
+            recordFastISelMiss("formal arguments", 0);
           if (EnableFastISelAbortArgs)
             llvm_unreachable("FastISel didn't lower all arguments");
 
@@ -1040,6 +1142,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (FastIS->SelectInstruction(Inst)) {
           --NumFastIselRemaining;
           ++NumFastIselSuccess;
+          ++NumFastISelSelected;
           // If fast isel succeeded, skip over all the folded instructions, and
           // then see if there is a load right before the selected instructions.
           // Try to fold the load if so.
@@ -1056,6 +1159,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
             BI = llvm::next(BasicBlock::const_iterator(BeforeInst));
             --NumFastIselRemaining;
             ++NumFastIselSuccess;
+            ++NumFastISelSelected;
           }
           continue;
         }
@@ -1093,12 +1197,18 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
 
           // Recompute NumFastIselRemaining as Selection DAG instruction
           // selection may have handled the call, input args, etc.
-          unsigned RemainingNow = std::distance(Begin, BI);
+          unsigned RemainingNow = std::distance(Begin, BI) - 1;
           NumFastIselFailures += NumFastIselRemaining - RemainingNow;
+          if (EnableFastISelReport)
+            recordFastISelMiss(getFastISelMissKind(Inst),
+                               NumFastIselRemaining - RemainingNow);
           NumFastIselRemaining = RemainingNow;
           continue;
         }
 
+        if (EnableFastISelReport)
+          recordFastISelMiss(getFastISelMissKind(Inst), NumFastIselRemaining);
+
         if (isa<TerminatorInst>(Inst) && !isa<BranchInst>(Inst)) {
           // Don't abort, and use a different message for terminator misses.
           NumFastIselFailures += NumFastIselRemaining;
@@ -13,6 +13,9 @@ using namespace llvm;
 
 DIContext::~DIContext() {}
 
-DIContext *DIContext::getDWARFContext(object::ObjectFile *Obj) {
-  return new DWARFContextInMemory(Obj);
+DIContext *DIContext::getDWARFContext(object::ObjectFile *Obj,
+                                      unsigned NumThreads) {
+  DWARFContextInMemory *Ctx = new DWARFContextInMemory(Obj);
+  Ctx->setNumThreads(NumThreads);
+  return Ctx;
 }
@@ -0,0 +1,135 @@
+//===-- DWARFAcceleratorTable.cpp -----------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DWARFAcceleratorTable.h"
+#include "llvm/Support/Dwarf.h"
+using namespace llvm;
+using namespace dwarf;
+
+static const uint32_t AccelTableMagic = 0x48415348; // 'HASH'
+
+static uint32_t hashDJB(StringRef Str) {
+  uint32_t H = 5381;
+  for (unsigned i = 0, e = Str.size(); i != e; ++i)
+    H = ((H << 5) + H) + Str[i];
+  return H;
+}
+
+bool DWARFAcceleratorTable::extract() {
+  uint32_t Offset = 0;
+  if (!AccelSection.isValidOffsetForDataOfSize(Offset, 20))
+    return false;
+  Hdr.Magic = AccelSection.getU32(&Offset);
+  Hdr.Version = AccelSection.getU16(&Offset);
+  Hdr.HashFunction = AccelSection.getU16(&Offset);
+  Hdr.BucketCount = AccelSection.getU32(&Offset);
+  Hdr.HashCount = AccelSection.getU32(&Offset);
+  Hdr.HeaderDataLength = AccelSection.getU32(&Offset);
+  if (Hdr.Magic != AccelTableMagic ||
+      Hdr.HashFunction != DW_hash_function_djb || Hdr.BucketCount == 0)
+    return false;
+
+  uint32_t HeaderDataEnd = Offset + Hdr.HeaderDataLength;
+  DIEOffsetBase = AccelSection.getU32(&Offset);
+  uint32_t NumAtoms = AccelSection.getU32(&Offset);
+  for (uint32_t i = 0; i != NumAtoms && Offset + 4 <= HeaderDataEnd; ++i) {
+    uint16_t Type = AccelSection.getU16(&Offset);
+    uint16_t Form = AccelSection.getU16(&Offset);
+    Atoms.push_back(std::make_pair(Type, Form));
+  }
+
+  BucketsOffset = HeaderDataEnd;
+  HashesOffset = BucketsOffset + Hdr.BucketCount * 4;
+  OffsetsOffset = HashesOffset + Hdr.HashCount * 4;
+  if (Hdr.HashCount &&
+      !AccelSection.isValidOffsetForDataOfSize(OffsetsOffset,
+                                               Hdr.HashCount * 4)) {
+    Hdr.BucketCount = 0;
+    return false;
+  }
+  return true;
+}
+
+bool DWARFAcceleratorTable::readAtom(uint16_t Form, uint32_t *OffsetPtr,
+                                     uint64_t &Value) const {
+  if (!AccelSection.isValidOffset(*OffsetPtr))
+    return false;
+  switch (Form) {
+  case DW_FORM_data1:
+  case DW_FORM_flag:
+    Value = AccelSection.getU8(OffsetPtr);
+    return true;
+  case DW_FORM_data2:
+    Value = AccelSection.getU16(OffsetPtr);
+    return true;
+  case DW_FORM_data4:
+    Value = AccelSection.getU32(OffsetPtr);
+    return true;
+  case DW_FORM_data8:
+    Value = AccelSection.getU64(OffsetPtr);
+    return true;
+  case DW_FORM_udata:
+    Value = AccelSection.getULEB128(OffsetPtr);
+    return true;
+  default:
+    return false;
+  }
+}
+
+void DWARFAcceleratorTable::findDIEOffsets(
+    StringRef Name, SmallVectorImpl<uint32_t> &Offsets) const {
+  if (Hdr.BucketCount == 0)
+    return;
+
+  uint32_t Hash = hashDJB(Name);
+  uint32_t Bucket = Hash % Hdr.BucketCount;
+  uint32_t Offset = BucketsOffset + Bucket * 4;
+  uint32_t Index = AccelSection.getU32(&Offset);
+  if (Index == UINT32_MAX)
+    return;
+
+  // The hashes of a bucket are contiguous; stop at the first one that
+  // belongs to another bucket.
+  for (uint32_t i = Index; i < Hdr.HashCount; ++i) {
+    uint32_t HashOffset = HashesOffset + i * 4;
+    uint32_t H = AccelSection.getU32(&HashOffset);
+    if (H % Hdr.BucketCount != Bucket)
+      break;
+    if (H != Hash)
+      continue;
+
+    uint32_t DataOffsetOffset = OffsetsOffset + i * 4;
+    uint32_t DataOffset = AccelSection.getU32(&DataOffsetOffset);
+
+    // Walk the chain of names with this hash value up to the terminating
+    // zero string offset.
+    while (AccelSection.isValidOffsetForDataOfSize(DataOffset, 8)) {
+      RelocAddrMap::const_iterator AI = Relocs.find(DataOffset);
+      uint64_t StrOffset = AccelSection.getU32(&DataOffset);
+      if (AI != Relocs.end())
+        StrOffset += AI->second.second;
+      else if (StrOffset == 0)
+        break;
+      uint32_t NumDIEs = AccelSection.getU32(&DataOffset);
+
+      uint32_t StrOffset32 = StrOffset;
+      const char *Str = StringSection.getCStr(&StrOffset32);
+      bool Match = Str && Name == Str;
+      for (uint32_t j = 0; j != NumDIEs; ++j) {
+        for (unsigned k = 0, e = Atoms.size(); k != e; ++k) {
+          uint64_t Value;
+          if (!readAtom(Atoms[k].second, &DataOffset, Value))
+            return;
+          if (Match && Atoms[k].first == DW_ATOM_die_offset)
+            Offsets.push_back(DIEOffsetBase + Value);
+        }
+      }
+    }
+  }
+}
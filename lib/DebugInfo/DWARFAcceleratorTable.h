@@ -0,0 +1,70 @@
+//===-- DWARFAcceleratorTable.h ---------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_DWARFACCELERATORTABLE_H
+#define LLVM_DEBUGINFO_DWARFACCELERATORTABLE_H
+
+#include "DWARFRelocMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/DataExtractor.h"
+
+namespace llvm {
+
+/// DWARFAcceleratorTable - Reader for the Apple-style hash tables found in
+/// the .apple_names and .apple_types sections, as written by
+/// DwarfAccelTable.  A lookup hashes the name, visits the one bucket it
+/// falls into and reads only the hash data of matching hash values.
+class DWARFAcceleratorTable {
+  struct Header {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t HashFunction;
+    uint32_t BucketCount;
+    uint32_t HashCount;
+    uint32_t HeaderDataLength;
+  };
+
+  DataExtractor AccelSection;
+  DataExtractor StringSection;
+  const RelocAddrMap &Relocs;
+
+  Header Hdr;
+  uint32_t DIEOffsetBase;
+  // (DW_ATOM_*, DW_FORM_*) pairs describing each entry of the hash data.
+  SmallVector<std::pair<uint16_t, uint16_t>, 3> Atoms;
+  // Section offsets of the bucket, hash and hash data offset arrays.
+  uint32_t BucketsOffset;
+  uint32_t HashesOffset;
+  uint32_t OffsetsOffset;
+
+  /// readAtom - Read one atom value of the given form.  Returns false if
+  /// the form is not one the tables use.
+  bool readAtom(uint16_t Form, uint32_t *OffsetPtr, uint64_t &Value) const;
+
+public:
+  DWARFAcceleratorTable(DataExtractor AccelSection,
+                        DataExtractor StringSection, const RelocAddrMap &Relocs)
+    : AccelSection(AccelSection), StringSection(StringSection),
+      Relocs(Relocs), DIEOffsetBase(0), BucketsOffset(0), HashesOffset(0),
+      OffsetsOffset(0) {
+    Hdr.BucketCount = 0;
+  }
+
+  /// extract - Read the table header.  Returns false if the section does
+  /// not hold a table this reader understands.
+  bool extract();
+
+  /// findDIEOffsets - Append the .debug_info offsets of the DIEs named
+  /// \p Name to \p Offsets.
+  void findDIEOffsets(StringRef Name, SmallVectorImpl<uint32_t> &Offsets) const;
+};
+
+}
+
+#endif
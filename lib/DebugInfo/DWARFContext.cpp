@@ -11,10 +11,12 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/DebugInfo/DWARFFormValue.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 using namespace llvm;
@@ -66,8 +68,11 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
 
   if (DumpType == DIDT_All || DumpType == DIDT_Info) {
     OS << "\n.debug_info contents:\n";
-    for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i)
-      getCompileUnitAtIndex(i)->dump(OS);
+    if (NumThreads > 1 && getNumCompileUnits() > 1)
+      dumpCompileUnitsInParallel(OS);
+    else
+      for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i)
+        getCompileUnitAtIndex(i)->dump(OS);
   }
 
   if (DumpType == DIDT_All || DumpType == DIDT_Types) {
@@ -194,6 +199,38 @@ void DWARFContext::dump(raw_ostream &OS, DIDumpType DumpType) {
     }
 }
 
+namespace {
+  /// UnitDumpBatch - A run of compile units printed to strings by the
+  /// workers of dumpCompileUnitsInParallel.
+  struct UnitDumpBatch {
+    DWARFCompileUnit *const *Units;
+    std::vector<std::string> Text;
+  };
+}
+
+static void dumpUnitToString(void *Arg, unsigned I) {
+  UnitDumpBatch &Batch = *static_cast<UnitDumpBatch *>(Arg);
+  raw_string_ostream OS(Batch.Text[I]);
+  Batch.Units[I]->dump(OS);
+}
+
+void DWARFContext::dumpCompileUnitsInParallel(raw_ostream &OS) {
+  // Units only share the abbreviations, which were parsed along with the
+  // unit headers.  Bound the amount of buffered output by rendering a few
+  // units per thread at a time.
+  unsigned NumUnits = getNumCompileUnits();
+  unsigned BatchSize = NumThreads * 4;
+  UnitDumpBatch Batch;
+  for (unsigned Begin = 0; Begin < NumUnits; Begin += BatchSize) {
+    unsigned N = std::min(BatchSize, NumUnits - Begin);
+    Batch.Units = CUs.begin() + Begin;
+    Batch.Text.assign(N, std::string());
+    llvm_execute_in_parallel(dumpUnitToString, &Batch, N, NumThreads);
+    for (unsigned i = 0; i != N; ++i)
+      OS << Batch.Text[i];
+  }
+}
+
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrev() {
   if (Abbrev)
     return Abbrev.get();
@@ -256,6 +293,137 @@ const DWARFDebugFrame *DWARFContext::getDebugFrame() {
   return DebugFrame.get();
 }
 
+static DWARFAcceleratorTable *
+extractAppleTable(const DWARFContext::Section &Sec, StringRef StrSec,
+                  bool LittleEndian) {
+  OwningPtr<DWARFAcceleratorTable> Table(new DWARFAcceleratorTable(
+      DataExtractor(Sec.Data, LittleEndian, 0),
+      DataExtractor(StrSec, LittleEndian, 0), Sec.Relocs));
+  if (!Table->extract())
+    return 0;
+  return Table.take();
+}
+
+const DWARFAcceleratorTable *DWARFContext::getAppleNames() {
+  if (!AppleNames && !getAppleNamesSection().Data.empty())
+    AppleNames.reset(extractAppleTable(getAppleNamesSection(),
+                                       getStringSection(), isLittleEndian()));
+  return AppleNames.get();
+}
+
+const DWARFAcceleratorTable *DWARFContext::getAppleTypes() {
+  if (!AppleTypes && !getAppleTypesSection().Data.empty())
+    AppleTypes.reset(extractAppleTable(getAppleTypesSection(),
+                                       getStringSection(), isLittleEndian()));
+  return AppleTypes.get();
+}
+
+/// indexPubSection - Add the entries of all sets in a pubnames-style
+/// section to Index.  Entries are relative to the unit of their set.
+static void indexPubSection(StringRef Data, bool LittleEndian, bool GnuStyle,
+                            StringMap<SmallVector<uint32_t, 1> > &Index) {
+  DataExtractor PubNames(Data, LittleEndian, 0);
+  uint32_t Offset = 0;
+  while (PubNames.isValidOffsetForDataOfSize(Offset, 14)) {
+    uint32_t Length = PubNames.getU32(&Offset);
+    uint32_t SetEnd = Offset + Length;
+    if (SetEnd < Offset)
+      return;
+    PubNames.getU16(&Offset); // Version.
+    uint32_t CUOffset = PubNames.getU32(&Offset);
+    PubNames.getU32(&Offset); // Unit length.
+    while (Offset < SetEnd && PubNames.isValidOffset(Offset)) {
+      uint32_t DIERef = PubNames.getU32(&Offset);
+      if (DIERef == 0)
+        break;
+      if (GnuStyle)
+        PubNames.getU8(&Offset);
+      const char *Name = PubNames.getCStr(&Offset);
+      if (!Name)
+        return;
+      Index[Name].push_back(CUOffset + DIERef);
+    }
+    Offset = SetEnd;
+  }
+}
+
+void DWARFContext::buildPubNameIndex() {
+  PubNameIndexBuilt = true;
+  bool LE = isLittleEndian();
+  indexPubSection(getPubNamesSection(), LE, false, PubNameIndex);
+  indexPubSection(getPubTypesSection(), LE, false, PubNameIndex);
+  indexPubSection(getGnuPubNamesSection(), LE, true, PubNameIndex);
+  indexPubSection(getGnuPubTypesSection(), LE, true, PubNameIndex);
+}
+
+/// findNamedDIEs - Append the offsets of the DIEs below and including Die
+/// whose name or linkage name is Name.
+static void findNamedDIEs(const DWARFUnit *U,
+                          const DWARFDebugInfoEntryMinimal *Die, StringRef Name,
+                          SmallVectorImpl<uint32_t> &Offsets) {
+  for (; Die && !Die->isNULL(); Die = Die->getSibling()) {
+    const char *DieName = Die->getAttributeValueAsString(U, DW_AT_name, 0);
+    if (!DieName || Name != DieName)
+      DieName = Die->getAttributeValueAsString(U, DW_AT_MIPS_linkage_name, 0);
+    if (DieName && Name == DieName)
+      Offsets.push_back(Die->getOffset());
+    findNamedDIEs(U, Die->getFirstChild(), Name, Offsets);
+  }
+}
+
+void DWARFContext::findDIEOffsetsByName(StringRef Name,
+                                        SmallVectorImpl<uint32_t> &Offsets) {
+  size_t Begin = Offsets.size();
+  const DWARFAcceleratorTable *Names = getAppleNames();
+  const DWARFAcceleratorTable *Types = getAppleTypes();
+  if (Names || Types) {
+    if (Names)
+      Names->findDIEOffsets(Name, Offsets);
+    if (Types)
+      Types->findDIEOffsets(Name, Offsets);
+  } else {
+    if (!PubNameIndexBuilt)
+      buildPubNameIndex();
+    if (!PubNameIndex.empty()) {
+      StringMap<SmallVector<uint32_t, 1> >::const_iterator I =
+          PubNameIndex.find(Name);
+      if (I != PubNameIndex.end())
+        Offsets.append(I->getValue().begin(), I->getValue().end());
+    } else {
+      // No index at all; look at every DIE.
+      for (unsigned i = 0, e = getNumCompileUnits(); i != e; ++i) {
+        DWARFCompileUnit *CU = getCompileUnitAtIndex(i);
+        findNamedDIEs(CU, CU->getCompileUnitDIE(false), Name, Offsets);
+      }
+    }
+  }
+  std::sort(Offsets.begin() + Begin, Offsets.end());
+  Offsets.erase(std::unique(Offsets.begin() + Begin, Offsets.end()),
+                Offsets.end());
+}
+
+bool DWARFContext::dumpDIEsNamed(raw_ostream &OS, StringRef Name) {
+  SmallVector<uint32_t, 4> Offsets;
+  findDIEOffsetsByName(Name, Offsets);
+
+  bool Found = false;
+  for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
+    DWARFCompileUnit *CU = getCompileUnitContainingOffset(Offsets[i]);
+    if (!CU || !CU->getCompileUnitDIE())
+      continue;
+    // Read just this DIE; its unit's other DIEs stay unparsed.
+    DWARFDebugInfoEntryMinimal Die;
+    uint32_t Offset = Offsets[i];
+    const uint8_t *FixedFormSizes = DWARFFormValue::getFixedFormSizes(
+        CU->getAddressByteSize(), CU->getVersion());
+    if (!Die.extractFast(CU, FixedFormSizes, &Offset) || Die.isNULL())
+      continue;
+    Die.dump(OS, CU, 0);
+    Found = true;
+  }
+  return Found;
+}
+
 const DWARFLineTable *
 DWARFContext::getLineTableForCompileUnit(DWARFCompileUnit *cu) {
   if (!Line)
@@ -361,6 +529,18 @@ DWARFCompileUnit *DWARFContext::getCompileUnitForOffset(uint32_t Offset) {
   return 0;
 }
 
+DWARFCompileUnit *
+DWARFContext::getCompileUnitContainingOffset(uint32_t Offset) {
+  if (CUs.empty())
+    parseCompileUnits();
+
+  DWARFCompileUnit **CU =
+      std::upper_bound(CUs.begin(), CUs.end(), Offset, OffsetComparator());
+  if (CU == CUs.begin() || !(*--CU)->containsDIEOffset(Offset))
+    return 0;
+  return *CU;
+}
+
 DWARFCompileUnit *DWARFContext::getCompileUnitForAddress(uint64_t Address) {
   // First, get the offset of the compile unit.
   uint32_t CUOffset = getDebugAranges()->findAddress(Address);
@@ -621,6 +801,8 @@ DWARFContextInMemory::DWARFContextInMemory(object::ObjectFile *Obj) :
             .Case("debug_str.dwo", &StringDWOSection)
             .Case("debug_str_offsets.dwo", &StringOffsetDWOSection)
             .Case("debug_addr", &AddrSection)
+            .Case("apple_names", &AppleNamesSection.Data)
+            .Case("apple_types", &AppleTypesSection.Data)
             // Any more debug info sections go here.
             .Default(0);
     if (Section) {
@@ -645,12 +827,21 @@ DWARFContextInMemory::DWARFContextInMemory(object::ObjectFile *Obj) :
         RelSecName.find_first_not_of("._")); // Skip . and _ prefixes.
 
     // TODO: Add support for relocations in other sections as needed.
-    // Record relocations for the debug_info and debug_line sections.
+    // Record relocations for the debug_info and debug_line sections.  The
+    // string offsets of the accelerator tables are only relocated in ELF;
+    // Mach-O relocates just their offsets within the section.
+    RelocAddrMap *AppleNamesRelocs = 0, *AppleTypesRelocs = 0;
+    if (Obj->isELF()) {
+      AppleNamesRelocs = &AppleNamesSection.Relocs;
+      AppleTypesRelocs = &AppleTypesSection.Relocs;
+    }
     RelocAddrMap *Map = StringSwitch<RelocAddrMap*>(RelSecName)
         .Case("debug_info", &InfoSection.Relocs)
         .Case("debug_loc", &LocSection.Relocs)
         .Case("debug_info.dwo", &InfoDWOSection.Relocs)
         .Case("debug_line", &LineSection.Relocs)
+        .Case("apple_names", AppleNamesRelocs)
+        .Case("apple_types", AppleTypesRelocs)
         .Default(0);
     if (!Map) {
       if (RelSecName != "debug_types")
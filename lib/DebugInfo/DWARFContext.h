@@ -10,6 +10,7 @@
 #ifndef LLVM_DEBUGINFO_DWARFCONTEXT_H
 #define LLVM_DEBUGINFO_DWARFCONTEXT_H
 
+#include "DWARFAcceleratorTable.h"
 #include "DWARFCompileUnit.h"
 #include "DWARFDebugAranges.h"
 #include "DWARFDebugFrame.h"
@@ -19,6 +20,7 @@
 #include "DWARFTypeUnit.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/DebugInfo/DIContext.h"
 
 namespace llvm {
@@ -35,10 +37,20 @@ class DWARFContext : public DIContext {
   OwningPtr<DWARFDebugAranges> Aranges;
   OwningPtr<DWARFDebugLine> Line;
   OwningPtr<DWARFDebugFrame> DebugFrame;
+  OwningPtr<DWARFAcceleratorTable> AppleNames;
+  OwningPtr<DWARFAcceleratorTable> AppleTypes;
+
+  /// DIE offsets by name from the pubnames and pubtypes sections, built on
+  /// the first lookup that has no accelerator table to use.
+  StringMap<SmallVector<uint32_t, 1> > PubNameIndex;
+  bool PubNameIndexBuilt;
 
   SmallVector<DWARFCompileUnit *, 1> DWOCUs;
   OwningPtr<DWARFDebugAbbrev> AbbrevDWO;
 
+  /// Number of threads used to parse the DIEs of several units at once.
+  unsigned NumThreads;
+
   DWARFContext(DWARFContext &) LLVM_DELETED_FUNCTION;
   DWARFContext &operator=(DWARFContext &) LLVM_DELETED_FUNCTION;
 
@@ -52,20 +64,34 @@ class DWARFContext : public DIContext {
   /// DWOCUs.
   void parseDWOCompileUnits();
 
+  /// Print the compile units, rendering batches of them on NumThreads
+  /// threads.  The units are printed in order.
+  void dumpCompileUnitsInParallel(raw_ostream &OS);
+
+  /// Read the pubnames and pubtypes sections into PubNameIndex.
+  void buildPubNameIndex();
+
 public:
   struct Section {
     StringRef Data;
     RelocAddrMap Relocs;
   };
 
-  DWARFContext() : DIContext(CK_DWARF) {}
+  DWARFContext()
+    : DIContext(CK_DWARF), PubNameIndexBuilt(false), NumThreads(1) {}
   virtual ~DWARFContext();
 
   static bool classof(const DIContext *DICtx) {
     return DICtx->getKind() == CK_DWARF;
   }
 
+  /// Set the number of threads used for dumping .debug_info and for building
+  /// the address ranges of units not covered by .debug_aranges.
+  void setNumThreads(unsigned N) { NumThreads = N ? N : 1; }
+  unsigned getNumThreads() const { return NumThreads; }
+
   virtual void dump(raw_ostream &OS, DIDumpType DumpType = DIDT_All);
+  virtual bool dumpDIEsNamed(raw_ostream &OS, StringRef Name);
 
   /// Get the number of compile units in this context.
   unsigned getNumCompileUnits() {
@@ -124,6 +150,17 @@ public:
   /// Get a pointer to the parsed frame information object.
   const DWARFDebugFrame *getDebugFrame();
 
+  /// Get a pointer to the .apple_names or .apple_types table, or null if
+  /// the section is missing or malformed.
+  const DWARFAcceleratorTable *getAppleNames();
+  const DWARFAcceleratorTable *getAppleTypes();
+
+  /// Append the sorted .debug_info offsets of the DIEs named \p Name to
+  /// \p Offsets.  Uses the accelerator tables if there are any, and the
+  /// pubnames and pubtypes sections otherwise.  Only without either does it
+  /// parse every unit.
+  void findDIEOffsetsByName(StringRef Name, SmallVectorImpl<uint32_t> &Offsets);
+
   /// Get a pointer to a parsed line table corresponding to a compile unit.
   const DWARFDebugLine::LineTable *
   getLineTableForCompileUnit(DWARFCompileUnit *cu);
@@ -150,6 +187,8 @@ public:
   virtual StringRef getPubTypesSection() = 0;
   virtual StringRef getGnuPubNamesSection() = 0;
   virtual StringRef getGnuPubTypesSection() = 0;
+  virtual const Section &getAppleNamesSection() = 0;
+  virtual const Section &getAppleTypesSection() = 0;
 
   // Sections for DWARF5 split dwarf proposal.
   virtual const Section &getInfoDWOSection() = 0;
@@ -166,6 +205,9 @@ private:
   /// Return the compile unit that includes an offset (relative to .debug_info).
   DWARFCompileUnit *getCompileUnitForOffset(uint32_t Offset);
 
+  /// Return the compile unit whose DIEs span the given .debug_info offset.
+  DWARFCompileUnit *getCompileUnitContainingOffset(uint32_t Offset);
+
   /// Return the compile unit which contains instruction with provided
   /// address.
   DWARFCompileUnit *getCompileUnitForAddress(uint64_t Address);
@@ -191,6 +233,8 @@ class DWARFContextInMemory : public DWARFContext {
   StringRef PubTypesSection;
   StringRef GnuPubNamesSection;
   StringRef GnuPubTypesSection;
+  Section AppleNamesSection;
+  Section AppleTypesSection;
 
   // Sections for DWARF5 split dwarf proposal.
   Section InfoDWOSection;
@@ -222,6 +266,8 @@ public:
   virtual StringRef getPubTypesSection() { return PubTypesSection; }
   virtual StringRef getGnuPubNamesSection() { return GnuPubNamesSection; }
   virtual StringRef getGnuPubTypesSection() { return GnuPubTypesSection; }
+  virtual const Section &getAppleNamesSection() { return AppleNamesSection; }
+  virtual const Section &getAppleTypesSection() { return AppleTypesSection; }
 
   // Sections for DWARF5 split dwarf proposal.
   virtual const Section &getInfoDWOSection() { return InfoDWOSection; }
@@ -11,6 +11,7 @@
 #include "DWARFCompileUnit.h"
 #include "DWARFContext.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -47,6 +48,19 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   }
 }
 
+namespace {
+  struct BuildRangesState {
+    const std::vector<DWARFCompileUnit *> *Units;
+    std::vector<DWARFDebugAranges> Tables;
+  };
+}
+
+static void buildRangesForUnit(void *Arg, unsigned I) {
+  BuildRangesState &State = *static_cast<BuildRangesState *>(Arg);
+  DWARFCompileUnit *CU = (*State.Units)[I];
+  CU->buildAddressRangeTable(&State.Tables[I], true, CU->getOffset());
+}
+
 void DWARFDebugAranges::generate(DWARFContext *CTX) {
   clear();
   if (!CTX)
@@ -59,14 +73,31 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
+  std::vector<DWARFCompileUnit *> Units;
   for (uint32_t i = 0, n = CTX->getNumCompileUnits(); i < n; ++i) {
     if (DWARFCompileUnit *CU = CTX->getCompileUnitAtIndex(i)) {
-      uint32_t CUOffset = CU->getOffset();
-      if (ParsedCUOffsets.insert(CUOffset).second)
-        CU->buildAddressRangeTable(this, true, CUOffset);
+      if (ParsedCUOffsets.insert(CU->getOffset()).second)
+        Units.push_back(CU);
     }
   }
 
+  unsigned NumThreads = CTX->getNumThreads();
+  if (NumThreads <= 1 || Units.size() <= 1) {
+    for (unsigned i = 0, e = Units.size(); i != e; ++i)
+      Units[i]->buildAddressRangeTable(this, true, Units[i]->getOffset());
+  } else {
+    // Every worker parses one unit into a table of its own.  Appending the
+    // tables in unit order gives the same ranges as the serial loop.
+    BuildRangesState State;
+    State.Units = &Units;
+    State.Tables.resize(Units.size());
+    llvm_execute_in_parallel(buildRangesForUnit, &State, Units.size(),
+                             NumThreads);
+    for (unsigned i = 0, e = State.Tables.size(); i != e; ++i)
+      Aranges.insert(Aranges.end(), State.Tables[i].Aranges.begin(),
+                     State.Tables[i].Aranges.end());
+  }
+
   sortAndMinimize();
 }
 
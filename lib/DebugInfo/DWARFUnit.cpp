@@ -12,6 +12,7 @@
 #include "llvm/DebugInfo/DWARFFormValue.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <cstdio>
 
 using namespace llvm;
@@ -309,6 +310,12 @@ bool DWARFUnit::parseDWO() {
 }
 
 void DWARFUnit::clearDIEs(bool KeepCUDie) {
+  // The subprogram index refers to DIEs by position.
+  SubprogramRanges.clear();
+  SubprogramMaxHighPC.clear();
+  RangeListSubprograms.clear();
+  SubprogramIndexBuilt = false;
+
   if (DieArray.size() > (unsigned)KeepCUDie) {
     // std::vectors never get any smaller when resized to a smaller size,
     // or when clear() or erase() are called, the size will report that it
@@ -355,15 +362,62 @@ DWARFUnit::buildAddressRangeTable(DWARFDebugAranges *debug_aranges,
     clearDIEs(true);
 }
 
+void DWARFUnit::buildSubprogramIndex() {
+  SubprogramIndexBuilt = true;
+  for (size_t i = 0, n = DieArray.size(); i != n; i++) {
+    const DWARFDebugInfoEntryMinimal &DIE = DieArray[i];
+    if (!DIE.isSubprogramDIE())
+      continue;
+    uint64_t LowPC, HighPC;
+    if (DIE.getLowAndHighPC(this, LowPC, HighPC)) {
+      SubprogramRange R = { LowPC, HighPC, (uint32_t)i };
+      SubprogramRanges.push_back(R);
+    } else if (DIE.getAttributeValueAsReference(this, DW_AT_ranges, -1U) !=
+               -1U) {
+      RangeListSubprograms.push_back(i);
+    }
+  }
+  std::stable_sort(SubprogramRanges.begin(), SubprogramRanges.end());
+
+  uint64_t MaxHighPC = 0;
+  SubprogramMaxHighPC.reserve(SubprogramRanges.size());
+  for (size_t i = 0, n = SubprogramRanges.size(); i != n; i++) {
+    MaxHighPC = std::max(MaxHighPC, SubprogramRanges[i].HighPC);
+    SubprogramMaxHighPC.push_back(MaxHighPC);
+  }
+}
+
 const DWARFDebugInfoEntryMinimal *
 DWARFUnit::getSubprogramForAddress(uint64_t Address) {
   extractDIEsIfNeeded(false);
-  for (size_t i = 0, n = DieArray.size(); i != n; i++)
-    if (DieArray[i].isSubprogramDIE() &&
-        DieArray[i].addressRangeContainsAddress(this, Address)) {
-      return &DieArray[i];
+  if (!SubprogramIndexBuilt)
+    buildSubprogramIndex();
+
+  // Return the first subprogram in DIE order that contains Address.  Ranges
+  // starting at or below Address are candidates; stop looking once none of
+  // the remaining ones reaches Address.
+  uint32_t Best = -1U;
+  SubprogramRange Key = { Address, 0, 0 };
+  size_t i = std::upper_bound(SubprogramRanges.begin(), SubprogramRanges.end(),
+                              Key) - SubprogramRanges.begin();
+  while (i != 0) {
+    --i;
+    if (SubprogramMaxHighPC[i] < Address)
+      break;
+    if (Address <= SubprogramRanges[i].HighPC)
+      Best = std::min(Best, SubprogramRanges[i].DIEIndex);
+  }
+
+  for (size_t i = 0, n = RangeListSubprograms.size(); i != n; i++) {
+    uint32_t Index = RangeListSubprograms[i];
+    if (Index >= Best)
+      break;
+    if (DieArray[Index].addressRangeContainsAddress(this, Address)) {
+      Best = Index;
+      break;
     }
-  return 0;
+  }
+  return Best == -1U ? 0 : &DieArray[Best];
 }
 
 DWARFDebugInfoEntryInlinedChain
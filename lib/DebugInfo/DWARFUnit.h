@@ -49,6 +49,24 @@ class DWARFUnit {
   // The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntryMinimal> DieArray;
 
+  /// SubprogramRange - The [LowPC, HighPC] range of a subprogram DIE, which
+  /// getSubprogramForAddress searches instead of walking all DIEs.
+  struct SubprogramRange {
+    uint64_t LowPC;
+    uint64_t HighPC;
+    uint32_t DIEIndex;
+    bool operator<(const SubprogramRange &RHS) const {
+      return LowPC < RHS.LowPC;
+    }
+  };
+  // Subprogram ranges sorted by LowPC, and the largest HighPC among each
+  // range and the ones before it.
+  std::vector<SubprogramRange> SubprogramRanges;
+  std::vector<uint64_t> SubprogramMaxHighPC;
+  // Subprograms described by DW_AT_ranges, in DIE order.
+  std::vector<uint32_t> RangeListSubprograms;
+  bool SubprogramIndexBuilt;
+
   class DWOHolder {
     OwningPtr<object::ObjectFile> DWOFile;
     OwningPtr<DWARFContext> DWOContext;
@@ -160,6 +178,10 @@ private:
   /// clearDIEs - Clear parsed DIEs to keep memory usage low.
   void clearDIEs(bool KeepCUDie);
 
+  /// buildSubprogramIndex - Collect the address ranges of the subprogram
+  /// DIEs for getSubprogramForAddress.
+  void buildSubprogramIndex();
+
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
   /// it was actually constructed.
   bool parseDWO();
@@ -125,6 +125,17 @@ void LLVMContext::emitError(unsigned LocCookie, const Twine &ErrorStr) {
   pImpl->InlineAsmDiagHandler(Diag, pImpl->InlineAsmDiagContext, LocCookie);
 }
 
+void LLVMContext::emitWarning(const Twine &WarningStr) {
+  if (pImpl->InlineAsmDiagHandler == 0) {
+    errs() << "warning: " << WarningStr << "\n";
+    return;
+  }
+
+  SMDiagnostic Diag("", SourceMgr::DK_Warning, WarningStr.str());
+
+  pImpl->InlineAsmDiagHandler(Diag, pImpl->InlineAsmDiagContext, 0);
+}
+
 //===----------------------------------------------------------------------===//
 // Metadata Kind Uniquing
 //===----------------------------------------------------------------------===//
@@ -18,6 +18,7 @@
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -59,7 +60,8 @@ const char* LTOCodeGenerator::getVersionString() {
 LTOCodeGenerator::LTOCodeGenerator()
     : Context(getGlobalContext()), Linker(new Module("ld-temp.o", Context)),
       TargetMach(NULL), EmitDwarfDebugInfo(false), ScopeRestrictionsDone(false),
-      CodeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC), NativeObjectFile(NULL) {
+      CodeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC), NativeObjectFile(NULL),
+      CodeGenPartitions(1) {
   initializeLTOPasses();
 }
 
@@ -417,7 +419,38 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
 
   // Instantiate the pass manager to organize the passes.
   PassManager passes;
+  addOptimizationPasses(passes, DisableOpt, DisableInline, DisableGVNLoadPRE);
 
+  PassManager codeGenPasses;
+
+  codeGenPasses.add(new DataLayout(*TargetMach->getDataLayout()));
+  TargetMach->addAnalysisPasses(codeGenPasses);
+
+  formatted_raw_ostream Out(out);
+
+  // If the bitcode files contain ARC code and were compiled with optimization,
+  // the ObjCARCContractPass must be run, so do it unconditionally here.
+  codeGenPasses.add(createObjCARCContractPass());
+
+  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
+                                      TargetMachine::CGFT_ObjectFile)) {
+    errMsg = "target file type not supported";
+    return false;
+  }
+
+  // Run our queue of passes all at once now, efficiently.
+  passes.run(*mergedModule);
+
+  // Run the code generator, and write assembly file
+  codeGenPasses.run(*mergedModule);
+
+  return true;
+}
+
+void LTOCodeGenerator::addOptimizationPasses(PassManager &passes,
+                                             bool DisableOpt,
+                                             bool DisableInline,
+                                             bool DisableGVNLoadPRE) {
   // Start off with a verification pass.
   passes.add(createVerifierPass());
 
@@ -436,30 +469,70 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
 
   // Make sure everything is still good.
   passes.add(createVerifierPass());
+}
 
-  PassManager codeGenPasses;
+bool LTOCodeGenerator::compile_to_files(std::vector<std::string> &names,
+                                        bool DisableOpt,
+                                        bool DisableInline,
+                                        bool DisableGVNLoadPRE,
+                                        std::string &errMsg) {
+  if (!this->determineTarget(errMsg))
+    return false;
 
-  codeGenPasses.add(new DataLayout(*TargetMach->getDataLayout()));
-  TargetMach->addAnalysisPasses(codeGenPasses);
+  Module *mergedModule = Linker.getModule();
 
-  formatted_raw_ostream Out(out);
+  // Mark which symbols can not be internalized
+  this->applyScopeRestrictions();
 
-  // If the bitcode files contain ARC code and were compiled with optimization,
-  // the ObjCARCContractPass must be run, so do it unconditionally here.
-  codeGenPasses.add(createObjCARCContractPass());
+  PassManager passes;
+  addOptimizationPasses(passes, DisableOpt, DisableInline, DisableGVNLoadPRE);
 
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
-                                      TargetMachine::CGFT_ObjectFile)) {
-    errMsg = "target file type not supported";
-    return false;
+  // The module is split right after optimization, so the ARC contraction that
+  // normally runs as part of code generation is done here.
+  passes.add(createObjCARCContractPass());
+  passes.run(*mergedModule);
+
+  // Make one temporary object file per partition.
+  std::vector<tool_output_file *> objFiles;
+  std::vector<formatted_raw_ostream *> OSs;
+  std::vector<std::string> Filenames;
+  bool Failed = false;
+  for (unsigned i = 0; i != CodeGenPartitions; ++i) {
+    SmallString<128> Filename;
+    int FD;
+    error_code EC = sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      Failed = true;
+      break;
+    }
+    objFiles.push_back(new tool_output_file(Filename.c_str(), FD));
+    OSs.push_back(new formatted_raw_ostream(objFiles.back()->os()));
+    Filenames.push_back(Filename.str());
   }
 
-  // Run our queue of passes all at once now, efficiently.
-  passes.run(*mergedModule);
+  if (!Failed)
+    Failed = splitCodeGen(mergedModule, OSs, *TargetMach,
+                          TargetMachine::CGFT_ObjectFile, NULL, errMsg);
 
-  // Run the code generator, and write assembly file
-  codeGenPasses.run(*mergedModule);
+  for (unsigned i = 0, e = objFiles.size(); i != e; ++i) {
+    delete OSs[i];
+    objFiles[i]->os().close();
+    if (objFiles[i]->os().has_error()) {
+      objFiles[i]->os().clear_error();
+      Failed = true;
+    }
+    objFiles[i]->keep();
+    delete objFiles[i];
+  }
+
+  if (Failed) {
+    for (unsigned i = 0, e = Filenames.size(); i != e; ++i)
+      sys::fs::remove(Twine(Filenames[i]));
+    return false;
+  }
 
+  names.swap(Filenames);
   return true;
 }
 
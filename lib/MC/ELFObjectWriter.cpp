@@ -28,15 +28,85 @@
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Threading.h"
+#include <algorithm>
 #include <vector>
 using namespace llvm;
 
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+static cl::opt<unsigned>
+WriterThreads("elf-writer-threads", cl::Hidden, cl::init(1),
+              cl::desc("Number of threads used to sort and encode the symbol "
+                       "table and the relocations of ELF objects"));
+
+namespace {
+  /// SortState - The slices of a range sorted by parallelStableSort.  At
+  /// every step, task I combines the slices starting at Bounds[2*I].
+  template <typename Iter, typename Compare>
+  struct SortState {
+    Iter Begin;
+    Compare Comp;
+    std::vector<size_t> Bounds;
+  };
+}
+
+template <typename Iter, typename Compare>
+static void sortSlice(void *Arg, unsigned I) {
+  SortState<Iter, Compare> &State =
+    *static_cast<SortState<Iter, Compare> *>(Arg);
+  std::stable_sort(State.Begin + State.Bounds[I],
+                   State.Begin + State.Bounds[I + 1], State.Comp);
+}
+
+template <typename Iter, typename Compare>
+static void mergeSlices(void *Arg, unsigned I) {
+  SortState<Iter, Compare> &State =
+    *static_cast<SortState<Iter, Compare> *>(Arg);
+  std::inplace_merge(State.Begin + State.Bounds[2 * I],
+                     State.Begin + State.Bounds[2 * I + 1],
+                     State.Begin + State.Bounds[2 * I + 2], State.Comp);
+}
+
+/// parallelStableSort - Sort [Begin, End) exactly like std::stable_sort,
+/// using up to NumThreads threads.  Equal slices are sorted concurrently and
+/// then merged pairwise, which keeps equal elements in their original order.
+template <typename Iter, typename Compare>
+static void parallelStableSort(Iter Begin, Iter End, Compare Comp,
+                               unsigned NumThreads) {
+  size_t Size = End - Begin;
+  if (NumThreads <= 1 || Size < 4096) {
+    std::stable_sort(Begin, End, Comp);
+    return;
+  }
+
+  SortState<Iter, Compare> State;
+  State.Begin = Begin;
+  State.Comp = Comp;
+  for (unsigned i = 0; i != NumThreads; ++i)
+    State.Bounds.push_back(Size * i / NumThreads);
+  State.Bounds.push_back(Size);
+  llvm_execute_in_parallel(sortSlice<Iter, Compare>, &State, NumThreads,
+                           NumThreads);
+
+  while (State.Bounds.size() > 2) {
+    unsigned NumSlices = State.Bounds.size() - 1;
+    llvm_execute_in_parallel(mergeSlices<Iter, Compare>, &State,
+                             NumSlices / 2, NumThreads);
+    // Every merged pair is now a single slice; an odd one out stays as is.
+    std::vector<size_t> Bounds;
+    for (unsigned i = 0; i < NumSlices; i += 2)
+      Bounds.push_back(State.Bounds[i]);
+    Bounds.push_back(Size);
+    State.Bounds.swap(Bounds);
+  }
+}
+
 namespace {
 class ELFObjectWriter : public MCObjectWriter {
   protected:
@@ -70,18 +140,44 @@ class ELFObjectWriter : public MCObjectWriter {
       MCSymbolData *SymbolData;
       uint64_t StringIndex;
       uint32_t SectionIndex;
+      // The sort key: the symbol name, and whether this is a file symbol.
+      StringRef Name;
+      bool IsFile;
 
-      // Support lexicographic sorting.
+      // Support lexicographic sorting. File symbols come first.
       bool operator<(const ELFSymbolData &RHS) const {
-        if (MCELF::GetType(*SymbolData) == ELF::STT_FILE)
-          return true;
-        if (MCELF::GetType(*RHS.SymbolData) == ELF::STT_FILE)
-          return false;
-        return SymbolData->getSymbol().getName() <
-               RHS.SymbolData->getSymbol().getName();
+        if (IsFile || RHS.IsFile)
+          return IsFile && !RHS.IsFile;
+        return Name < RHS.Name;
       }
     };
 
+    /// SymbolChunk - A run of symbols whose table entries are encoded into a
+    /// fragment of their own, possibly concurrently with other runs.
+    struct SymbolChunk {
+      ELFSymbolData *Begin, *End;
+      MCDataFragment *SymtabF, *ShndxF;
+    };
+
+    /// RelocationChunk - The relocations of one section and the fragment
+    /// they are encoded into.
+    struct RelocationChunk {
+      std::vector<ELFRelocationEntry> *Relocs;
+      MCDataFragment *F;
+    };
+
+    /// EncodeState - What the workers of WriteSymbolTable and
+    /// WriteRelocations share.  Every worker writes only its own fragment.
+    struct EncodeState {
+      ELFObjectWriter *Writer;
+      const MCAssembler *Asm;
+      const MCAsmLayout *Layout;
+      std::vector<SymbolChunk> Symbols;
+      std::vector<RelocationChunk> Relocations;
+    };
+    static void encodeSymbolChunk(void *Arg, unsigned I);
+    static void encodeRelocationChunk(void *Arg, unsigned I);
+
     /// The target specific ELF writer instance.
     llvm::OwningPtr<MCELFObjectTargetWriter> TargetObjectWriter;
 
@@ -246,8 +342,12 @@ class ELFObjectWriter : public MCObjectWriter {
                      const MCAsmLayout &Layout);
 
     typedef DenseMap<const MCSectionELF*, uint32_t> SectionIndexMapTy;
-    void WriteSymbolTable(MCDataFragment *SymtabF,
-                          MCDataFragment *ShndxF,
+    void AddSymbolChunks(std::vector<ELFSymbolData> &Symbols,
+                         MCSectionData &SymtabSD, MCSectionData *ShndxSD,
+                         std::vector<SymbolChunk> &Chunks);
+
+    void WriteSymbolTable(MCSectionData &SymtabSD,
+                          MCSectionData *ShndxSD,
                           const MCAssembler &Asm,
                           const MCAsmLayout &Layout,
                           const SectionIndexMapTy &SectionIndexMap);
@@ -321,7 +421,7 @@ class ELFObjectWriter : public MCObjectWriter {
 
     void WriteRelocationsFragment(const MCAssembler &Asm,
                                   MCDataFragment *F,
-                                  const MCSectionData *SD);
+                                  std::vector<ELFRelocationEntry> &Relocs);
 
     virtual bool
     IsSymbolRefDifferenceFullyResolvedImpl(const MCAssembler &Asm,
@@ -576,8 +676,31 @@ void ELFObjectWriter::WriteSymbol(MCDataFragment *SymtabF,
                    Size, Other, MSD.SectionIndex, IsReserved);
 }
 
-void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
-                                       MCDataFragment *ShndxF,
+void ELFObjectWriter::AddSymbolChunks(std::vector<ELFSymbolData> &Symbols,
+                                      MCSectionData &SymtabSD,
+                                      MCSectionData *ShndxSD,
+                                      std::vector<SymbolChunk> &Chunks) {
+  const unsigned ChunkSize = 4096;
+  for (unsigned i = 0, e = Symbols.size(); i < e; i += ChunkSize) {
+    SymbolChunk Chunk;
+    Chunk.Begin = &Symbols[i];
+    Chunk.End = Chunk.Begin + std::min(ChunkSize, e - i);
+    Chunk.SymtabF = new MCDataFragment(&SymtabSD);
+    Chunk.ShndxF = ShndxSD ? new MCDataFragment(ShndxSD) : 0;
+    Chunks.push_back(Chunk);
+  }
+}
+
+void ELFObjectWriter::encodeSymbolChunk(void *Arg, unsigned I) {
+  EncodeState &State = *static_cast<EncodeState *>(Arg);
+  SymbolChunk &Chunk = State.Symbols[I];
+  for (ELFSymbolData *MSD = Chunk.Begin; MSD != Chunk.End; ++MSD)
+    State.Writer->WriteSymbol(Chunk.SymtabF, Chunk.ShndxF, *MSD,
+                              *State.Layout);
+}
+
+void ELFObjectWriter::WriteSymbolTable(MCSectionData &SymtabSD,
+                                       MCSectionData *ShndxSD,
                                        const MCAssembler &Asm,
                                        const MCAsmLayout &Layout,
                                     const SectionIndexMapTy &SectionIndexMap) {
@@ -588,16 +711,22 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
   // FIXME: Make sure the start of the symbol table is aligned.
 
   // The first entry is the undefined symbol entry.
+  MCDataFragment *SymtabF = new MCDataFragment(&SymtabSD);
+  MCDataFragment *ShndxF = ShndxSD ? new MCDataFragment(ShndxSD) : 0;
   WriteSymbolEntry(SymtabF, ShndxF, 0, 0, 0, 0, 0, 0, false);
 
-  // Write the symbol table entries.
+  // The entries of the symbols are encoded below, a chunk at a time, into
+  // fragments that are laid out in symbol table order.
+  EncodeState State;
+  State.Writer = this;
+  State.Asm = &Asm;
+  State.Layout = &Layout;
+  AddSymbolChunks(LocalSymbolData, SymtabSD, ShndxSD, State.Symbols);
   LastLocalSymbolIndex = LocalSymbolData.size() + 1;
-  for (unsigned i = 0, e = LocalSymbolData.size(); i != e; ++i) {
-    ELFSymbolData &MSD = LocalSymbolData[i];
-    WriteSymbol(SymtabF, ShndxF, MSD, Layout);
-  }
 
   // Write out a symbol table entry for each regular section.
+  SymtabF = new MCDataFragment(&SymtabSD);
+  ShndxF = ShndxSD ? new MCDataFragment(ShndxSD) : 0;
   for (MCAssembler::const_iterator i = Asm.begin(), e = Asm.end(); i != e;
        ++i) {
     const MCSectionELF &Section =
@@ -614,24 +743,25 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
     LastLocalSymbolIndex++;
   }
 
+  AddSymbolChunks(ExternalSymbolData, SymtabSD, ShndxSD, State.Symbols);
   for (unsigned i = 0, e = ExternalSymbolData.size(); i != e; ++i) {
-    ELFSymbolData &MSD = ExternalSymbolData[i];
-    MCSymbolData &Data = *MSD.SymbolData;
+    MCSymbolData &Data = *ExternalSymbolData[i].SymbolData;
     assert(((Data.getFlags() & ELF_STB_Global) ||
             (Data.getFlags() & ELF_STB_Weak)) &&
            "External symbol requires STB_GLOBAL or STB_WEAK flag");
-    WriteSymbol(SymtabF, ShndxF, MSD, Layout);
     if (MCELF::GetBinding(Data) == ELF::STB_LOCAL)
       LastLocalSymbolIndex++;
   }
 
+  AddSymbolChunks(UndefinedSymbolData, SymtabSD, ShndxSD, State.Symbols);
   for (unsigned i = 0, e = UndefinedSymbolData.size(); i != e; ++i) {
-    ELFSymbolData &MSD = UndefinedSymbolData[i];
-    MCSymbolData &Data = *MSD.SymbolData;
-    WriteSymbol(SymtabF, ShndxF, MSD, Layout);
+    MCSymbolData &Data = *UndefinedSymbolData[i].SymbolData;
     if (MCELF::GetBinding(Data) == ELF::STB_LOCAL)
       LastLocalSymbolIndex++;
   }
+
+  llvm_execute_in_parallel(encodeSymbolChunk, &State, State.Symbols.size(),
+                           WriterThreads);
 }
 
 const MCSymbol *ELFObjectWriter::SymbolToReloc(const MCAssembler &Asm,
@@ -896,6 +1026,8 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
 
     ELFSymbolData MSD;
     MSD.SymbolData = it;
+    MSD.Name = Symbol.getName();
+    MSD.IsFile = MCELF::GetType(*it) == ELF::STT_FILE;
     const MCSymbol &RefSymbol = Symbol.AliasedSymbol();
 
     // Undefined symbols are global, but this is the first place we
@@ -958,9 +1090,12 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
   }
 
   // Symbols are required to be in lexicographic order.
-  array_pod_sort(LocalSymbolData.begin(), LocalSymbolData.end());
-  array_pod_sort(ExternalSymbolData.begin(), ExternalSymbolData.end());
-  array_pod_sort(UndefinedSymbolData.begin(), UndefinedSymbolData.end());
+  parallelStableSort(LocalSymbolData.begin(), LocalSymbolData.end(),
+                     std::less<ELFSymbolData>(), WriterThreads);
+  parallelStableSort(ExternalSymbolData.begin(), ExternalSymbolData.end(),
+                     std::less<ELFSymbolData>(), WriterThreads);
+  parallelStableSort(UndefinedSymbolData.begin(), UndefinedSymbolData.end(),
+                     std::less<ELFSymbolData>(), WriterThreads);
 
   // Set the symbol indices. Local symbols must come before all other
   // symbols with non-local bindings.
@@ -1019,8 +1154,20 @@ void ELFObjectWriter::CreateRelocationSections(MCAssembler &Asm,
   }
 }
 
+void ELFObjectWriter::encodeRelocationChunk(void *Arg, unsigned I) {
+  EncodeState &State = *static_cast<EncodeState *>(Arg);
+  RelocationChunk &Chunk = State.Relocations[I];
+  State.Writer->WriteRelocationsFragment(*State.Asm, Chunk.F, *Chunk.Relocs);
+}
+
 void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
                                        const RelMapTy &RelMap) {
+  // Create the fragments up front; the relocations of every section are
+  // then sorted and encoded independently.
+  EncodeState State;
+  State.Writer = this;
+  State.Asm = &Asm;
+  State.Layout = &Layout;
   for (MCAssembler::const_iterator it = Asm.begin(),
          ie = Asm.end(); it != ie; ++it) {
     const MCSectionData &SD = *it;
@@ -1033,9 +1180,14 @@ void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
     MCSectionData &RelaSD = Asm.getOrCreateSectionData(*RelaSection);
     RelaSD.setAlignment(is64Bit() ? 8 : 4);
 
-    MCDataFragment *F = new MCDataFragment(&RelaSD);
-    WriteRelocationsFragment(Asm, F, &*it);
+    RelocationChunk Chunk;
+    Chunk.Relocs = &Relocations[&SD];
+    Chunk.F = new MCDataFragment(&RelaSD);
+    State.Relocations.push_back(Chunk);
   }
+
+  llvm_execute_in_parallel(encodeRelocationChunk, &State,
+                           State.Relocations.size(), WriterThreads);
 }
 
 void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
@@ -1057,9 +1209,8 @@ void ELFObjectWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type,
 }
 
 void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
-                                               MCDataFragment *F,
-                                               const MCSectionData *SD) {
-  std::vector<ELFRelocationEntry> &Relocs = Relocations[SD];
+                                      MCDataFragment *F,
+                                      std::vector<ELFRelocationEntry> &Relocs) {
 
   // Sort the relocation entries. Most targets just sort by r_offset, but some
   // (e.g., MIPS) have additional constraints.
@@ -1121,6 +1272,14 @@ static int compareBySuffix(const MCSectionELF *const *a,
   return sizeB - sizeA;
 }
 
+namespace {
+  struct SuffixLess {
+    bool operator()(const MCSectionELF *A, const MCSectionELF *B) const {
+      return compareBySuffix(&A, &B) < 0;
+    }
+  };
+}
+
 void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
                                              MCAsmLayout &Layout,
                                              SectionIndexMapTy &SectionIndexMap,
@@ -1167,12 +1326,7 @@ void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
   StringTableIndex = SectionIndexMap.lookup(StrtabSection);
 
   // Symbol table
-  F = new MCDataFragment(&SymtabSD);
-  MCDataFragment *ShndxF = NULL;
-  if (NeedsSymtabShndx) {
-    ShndxF = new MCDataFragment(SymtabShndxSD);
-  }
-  WriteSymbolTable(F, ShndxF, Asm, Layout, SectionIndexMap);
+  WriteSymbolTable(SymtabSD, SymtabShndxSD, Asm, Layout, SectionIndexMap);
 
   F = new MCDataFragment(&StrtabSD);
   F->getContents().append(StringTable.begin(), StringTable.end());
@@ -1186,7 +1340,8 @@ void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
       static_cast<const MCSectionELF&>(it->getSection());
     Sections.push_back(&Section);
   }
-  array_pod_sort(Sections.begin(), Sections.end(), compareBySuffix);
+  parallelStableSort(Sections.begin(), Sections.end(), SuffixLess(),
+                     WriterThreads);
 
   // Section header string table.
   //
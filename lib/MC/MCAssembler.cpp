@@ -9,6 +9,7 @@
 
 #define DEBUG_TYPE "assembler"
 #include "llvm/MC/MCAssembler.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
@@ -28,6 +29,7 @@
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace llvm;
 
@@ -51,6 +53,8 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RevisitedFragments,
+          "Number of fragments revisited by incremental relaxation");
 }
 }
 
@@ -62,7 +66,7 @@ STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
 /* *** */
 
 MCAsmLayout::MCAsmLayout(MCAssembler &Asm)
-  : Assembler(Asm), LastValidFragment()
+  : Assembler(Asm), LastValidFragment(), IncrementalSection(0)
  {
   // Compute the section layout order. Virtual sections must go last.
   for (MCAssembler::iterator it = Asm.begin(), ie = Asm.end(); it != ie; ++it)
@@ -111,6 +115,14 @@ void MCAsmLayout::ensureValid(const MCFragment *F) const {
 }
 
 uint64_t MCAsmLayout::getFragmentOffset(const MCFragment *F) const {
+  if (F->getParent() == IncrementalSection) {
+    // The offset is the sum of the sizes of the fragments before F.
+    uint64_t Offset = 0;
+    for (unsigned i = F->getLayoutOrder(); i; i &= i - 1)
+      Offset += FragmentSizeTree[i - 1];
+    return Offset;
+  }
+
   ensureValid(F);
   assert(F->Offset != ~UINT64_C(0) && "Address not set!");
   return F->Offset;
@@ -525,6 +537,59 @@ void MCAsmLayout::layoutFragment(MCFragment *F) {
   }
 }
 
+void MCAsmLayout::beginIncrementalLayout(MCSectionData *SD) {
+  assert(!IncrementalSection && "Already laying out a section incrementally!");
+  assert(!Assembler.isBundlingEnabled() &&
+         "Incremental layout does not track bundle padding!");
+
+  getFragmentOffset(&SD->getFragmentList().back());
+  FragmentSizes.clear();
+  for (MCSectionData::iterator I = SD->begin(), IE = SD->end(); I != IE; ++I) {
+    const MCFragment *Next = I->getNextNode();
+    FragmentSizes.push_back(Next ? Next->Offset - I->Offset
+                                 : Assembler.computeFragmentSize(*this, *I));
+  }
+
+  // Build the Fenwick tree in linear time: every node adds itself into the
+  // next node whose range covers it.
+  unsigned N = FragmentSizes.size();
+  FragmentSizeTree = FragmentSizes;
+  for (unsigned i = 1; i <= N; ++i) {
+    unsigned Parent = i + (i & -i);
+    if (Parent <= N)
+      FragmentSizeTree[Parent - 1] += FragmentSizeTree[i - 1];
+  }
+  IncrementalSection = SD;
+}
+
+int64_t MCAsmLayout::resizeFragment(const MCFragment *F, uint64_t NewSize) {
+  assert(F->getParent() == IncrementalSection &&
+         "Fragment is not in the incremental section!");
+  unsigned Index = F->getLayoutOrder();
+  int64_t Delta = NewSize - FragmentSizes[Index];
+  if (!Delta)
+    return 0;
+  FragmentSizes[Index] = NewSize;
+  for (unsigned i = Index + 1, N = FragmentSizes.size(); i <= N; i += i & -i)
+    FragmentSizeTree[i - 1] += Delta;
+  return Delta;
+}
+
+void MCAsmLayout::endIncrementalLayout() {
+  assert(IncrementalSection && "Not laying out a section incrementally!");
+  MCSectionData *SD = const_cast<MCSectionData *>(IncrementalSection);
+  IncrementalSection = 0;
+
+  uint64_t Offset = 0;
+  for (MCSectionData::iterator I = SD->begin(), IE = SD->end(); I != IE; ++I) {
+    I->Offset = Offset;
+    Offset += FragmentSizes[I->getLayoutOrder()];
+  }
+  LastValidFragment[SD] = &SD->getFragmentList().back();
+  FragmentSizes.clear();
+  FragmentSizeTree.clear();
+}
+
 /// \brief Write the contents of a fragment to the given object writer. Expects
 ///        a MCEncodedFragment.
 static void writeFragmentContents(const MCFragment &F, MCObjectWriter *OW) {
@@ -937,6 +1002,24 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  switch(F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  }
+}
+
 bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
@@ -947,36 +1030,250 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
   // Attempt to relax all the fragments in the section.
   for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
     // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    bool RelaxedFrag = relaxFragment(Layout, *I);
+    if (RelaxedFrag && !FirstRelaxedFragment)
+      FirstRelaxedFragment = I;
+  }
+  if (FirstRelaxedFragment) {
+    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
+    return true;
+  }
+  return false;
+}
+
+namespace {
+/// A relaxable fragment and the range of fragments, by layout order, whose
+/// sizes its fixup values depend on.
+struct FragmentSpan {
+  unsigned Index, First, Last;
+  FragmentSpan(unsigned Index, unsigned First, unsigned Last)
+    : Index(Index), First(First), Last(Last) {}
+};
+
+/// FragmentSpanTree - A segment tree over the fragments of a section, holding
+/// every span in the O(log N) nodes that cover it exactly. The spans that
+/// contain a fragment are then the ones stored on the path from its leaf to
+/// the root.
+class FragmentSpanTree {
+  unsigned NumLeaves;
+  // The spans of node N are Entries[NodeBegin[N], NodeEnd[N]).
+  std::vector<unsigned> NodeBegin, NodeEnd, Entries;
+
+public:
+  FragmentSpanTree(unsigned NumFragments, ArrayRef<FragmentSpan> Spans)
+    : NumLeaves(NextPowerOf2(NumFragments)) {
+    // Count the entries of every node, then place them.
+    std::vector<unsigned> Count(2 * NumLeaves + 1);
+    for (unsigned i = 0, e = Spans.size(); i != e; ++i)
+      for (unsigned L = Spans[i].First + NumLeaves,
+             R = Spans[i].Last + NumLeaves + 1; L < R; L >>= 1, R >>= 1) {
+        if (L & 1)
+          ++Count[L++];
+        if (R & 1)
+          ++Count[--R];
+      }
+
+    NodeBegin.resize(2 * NumLeaves);
+    for (unsigned N = 1, e = 2 * NumLeaves; N != e; ++N)
+      NodeBegin[N] = NodeBegin[N - 1] + Count[N - 1];
+    NodeEnd = NodeBegin;
+    Entries.resize(NodeBegin.back() + Count[2 * NumLeaves - 1]);
+    for (unsigned i = 0, e = Spans.size(); i != e; ++i)
+      for (unsigned L = Spans[i].First + NumLeaves,
+             R = Spans[i].Last + NumLeaves + 1; L < R; L >>= 1, R >>= 1) {
+        if (L & 1)
+          Entries[NodeEnd[L++]++] = Spans[i].Index;
+        if (R & 1)
+          Entries[NodeEnd[--R]++] = Spans[i].Index;
+      }
+  }
+
+  /// collect - Append the fragments whose spans contain fragment \p Index
+  /// to \p Out, dropping the ones that are marked \p Done for good.
+  void collect(unsigned Index, const BitVector &Done,
+               SmallVectorImpl<unsigned> &Out) {
+    for (unsigned N = Index + NumLeaves; N; N >>= 1)
+      for (unsigned i = NodeBegin[N]; i != NodeEnd[N];) {
+        if (Done.test(Entries[i])) {
+          Entries[i] = Entries[--NodeEnd[N]];
+          continue;
+        }
+        Out.push_back(Entries[i++]);
+      }
+  }
+};
+}
+
+/// addSymbolRefs - Collect the symbols referenced by \p Expr. Returns false
+/// if the expression contains target specific parts that cannot be looked
+/// into.
+static bool addSymbolRefs(const MCExpr *Expr,
+                          SmallVectorImpl<const MCSymbol *> &Symbols) {
+  switch (Expr->getKind()) {
+  case MCExpr::Constant:
+    return true;
+  case MCExpr::SymbolRef:
+    Symbols.push_back(&cast<MCSymbolRefExpr>(Expr)->getSymbol());
+    return true;
+  case MCExpr::Unary:
+    return addSymbolRefs(cast<MCUnaryExpr>(Expr)->getSubExpr(), Symbols);
+  case MCExpr::Binary: {
+    const MCBinaryExpr *BE = cast<MCBinaryExpr>(Expr);
+    return addSymbolRefs(BE->getLHS(), Symbols) &&
+           addSymbolRefs(BE->getRHS(), Symbols);
+  }
+  case MCExpr::Target:
+    return false;
+  }
+  llvm_unreachable("Invalid assembly expression kind!");
+}
+
+/// getFragmentSpan - Compute the range of fragments of its own section that
+/// the fixups of \p F depend on. Returns false if they also depend on
+/// anything else, such as symbols in other sections or variables.
+static bool getFragmentSpan(const MCAssembler &Asm,
+                            const MCRelaxableFragment &F, unsigned &First,
+                            unsigned &Last) {
+  First = Last = F.getLayoutOrder();
+  SmallVector<const MCSymbol *, 4> Symbols;
+  for (MCRelaxableFragment::const_fixup_iterator it = F.fixup_begin(),
+       ie = F.fixup_end(); it != ie; ++it) {
+    if (!addSymbolRefs(it->getValue(), Symbols))
+      return false;
+
+    // Absolute values, and PC-relative ones that are rounded down to a word,
+    // also depend on everything before the fragment.
+    unsigned Flags = Asm.getBackend().getFixupKindInfo(it->getKind()).Flags;
+    if (!(Flags & MCFixupKindInfo::FKF_IsPCRel) ||
+        (Flags & MCFixupKindInfo::FKF_IsAlignedDownTo32Bits))
+      First = 0;
+  }
+
+  for (unsigned i = 0, e = Symbols.size(); i != e; ++i) {
+    const MCSymbol &Sym = Symbols[i]->AliasedSymbol();
+    if (Sym.isVariable() || !Sym.isDefined() || Sym.isAbsolute())
+      return false;
+    const MCFragment *SymF = Asm.getSymbolData(Sym).getFragment();
+    if (!SymF || SymF->getParent() != F.getParent())
+      return false;
+    First = std::min(First, SymF->getLayoutOrder());
+    Last = std::max(Last, SymF->getLayoutOrder());
+  }
+  return true;
+}
+
+bool MCAssembler::layoutSectionIncrementally(MCAsmLayout &Layout,
+                                             MCSectionData &SD) {
+  std::vector<MCFragment *> Fragments;
+  // Align and org fragments, whose sizes depend on their own offsets.
+  std::vector<unsigned> OffsetDependent;
+  // Fragments that depend on more than a span of this section. They are
+  // revisited whenever the worklist runs dry.
+  SmallVector<unsigned, 16> Unbounded;
+  std::vector<FragmentSpan> Spans;
+  SmallVector<unsigned, 64> Worklist;
+  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
+    unsigned Index = Fragments.size();
+    Fragments.push_back(I);
+    switch (I->getKind()) {
     default:
       break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
+    case MCFragment::FT_Relaxable: {
+      MCRelaxableFragment &RF = *cast<MCRelaxableFragment>(I);
+      if (!getBackend().mayNeedRelaxation(RF.getInst()))
+        break;
+      unsigned First, Last;
+      if (getFragmentSpan(*this, RF, First, Last))
+        Spans.push_back(FragmentSpan(Index, First, Last));
+      else
+        Unbounded.push_back(Index);
+      Worklist.push_back(Index);
       break;
-    case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+    }
+    case MCFragment::FT_Org:
+      OffsetDependent.push_back(Index);
+      Unbounded.push_back(Index);
       break;
-    case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+    case MCFragment::FT_Align:
+      OffsetDependent.push_back(Index);
       break;
+    case MCFragment::FT_Dwarf:
+    case MCFragment::FT_DwarfFrame:
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      Unbounded.push_back(Index);
       break;
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = I;
   }
-  if (FirstRelaxedFragment) {
-    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
-    return true;
+
+  // Sections with nothing to relax, as is usual with -mc-relax-all, are left
+  // to be laid out lazily.
+  if (Worklist.empty() && Unbounded.empty())
+    return false;
+
+  Layout.beginIncrementalLayout(&SD);
+  FragmentSpanTree SpanTree(Fragments.size(), Spans);
+  BitVector Done(Fragments.size());
+  BitVector Queued(Fragments.size());
+  for (unsigned i = 0, e = Worklist.size(); i != e; ++i)
+    Queued.set(Worklist[i]);
+  // Visit the fragments in layout order on the first round.
+  std::reverse(Worklist.begin(), Worklist.end());
+
+  bool WasResized = false;
+  SmallVector<unsigned, 16> Dependents;
+  for (bool Resized = true; Resized;) {
+    Resized = false;
+    for (unsigned i = 0, e = Unbounded.size(); i != e; ++i)
+      if (!Done.test(Unbounded[i]) && !Queued.test(Unbounded[i])) {
+        Queued.set(Unbounded[i]);
+        Worklist.push_back(Unbounded[i]);
+      }
+
+    while (!Worklist.empty()) {
+      unsigned Index = Worklist.pop_back_val();
+      Queued.reset(Index);
+      MCFragment &F = *Fragments[Index];
+      if (Done.test(Index))
+        continue;
+
+      ++stats::RevisitedFragments;
+      relaxFragment(Layout, F);
+      if (MCRelaxableFragment *RF = dyn_cast<MCRelaxableFragment>(&F))
+        if (!getBackend().mayNeedRelaxation(RF->getInst()))
+          Done.set(Index);
+      int64_t Delta = Layout.resizeFragment(&F, computeFragmentSize(Layout, F));
+
+      // Requeue everything that spans a resized fragment. Offset dependent
+      // fragments after it may grow or shrink in turn, until one of them
+      // absorbs the shift.
+      std::vector<unsigned>::iterator
+        OI = std::upper_bound(OffsetDependent.begin(), OffsetDependent.end(),
+                              Index),
+        OE = OffsetDependent.end();
+      for (int64_t Shift = 0;;) {
+        if (Delta) {
+          Resized = true;
+          Dependents.clear();
+          SpanTree.collect(Index, Done, Dependents);
+          for (unsigned i = 0, e = Dependents.size(); i != e; ++i)
+            if (!Queued.test(Dependents[i])) {
+              Queued.set(Dependents[i]);
+              Worklist.push_back(Dependents[i]);
+            }
+          Shift += Delta;
+        }
+        if (!Shift || OI == OE)
+          break;
+        Index = *OI++;
+        Delta = Layout.resizeFragment(Fragments[Index],
+                          computeFragmentSize(Layout, *Fragments[Index]));
+      }
+    }
+    WasResized |= Resized;
   }
-  return false;
+
+  Layout.endIncrementalLayout();
+  return WasResized;
 }
 
 bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
@@ -985,7 +1282,12 @@ bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
   bool WasRelaxed = false;
   for (iterator it = begin(), ie = end(); it != ie; ++it) {
     MCSectionData &SD = *it;
-    while (layoutSectionOnce(Layout, SD))
+    // Bundle padding is only known when fragments are laid out in order, so
+    // bundled sections are relaxed a whole pass at a time.
+    if (isBundlingEnabled()) {
+      while (layoutSectionOnce(Layout, SD))
+        WasRelaxed = true;
+    } else if (layoutSectionIncrementally(Layout, SD))
       WasRelaxed = true;
   }
 
@@ -9,6 +9,7 @@
 
 #include "llvm/MC/MCDisassembler.h"
 #include "llvm/MC/MCExternalSymbolizer.h"
+#include "llvm/Support/StringRefMemoryObject.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -16,6 +17,41 @@ using namespace llvm;
 MCDisassembler::~MCDisassembler() {
 }
 
+MCDisassembler::DecodeStatus
+MCDisassembler::getInstructionFromBytes(MCInst &Instr, uint64_t &Size,
+                                        ArrayRef<uint8_t> Bytes,
+                                        uint64_t Address,
+                                        raw_ostream &VStream,
+                                        raw_ostream &CStream) const {
+  StringRefMemoryObject Region(
+      StringRef(reinterpret_cast<const char *>(Bytes.data()), Bytes.size()),
+      Address);
+  return getInstruction(Instr, Size, Region, Address, VStream, CStream);
+}
+
+size_t MCDisassembler::getInstructions(std::vector<DecodedInst> &Insts,
+                                       ArrayRef<uint8_t> Bytes,
+                                       uint64_t Address,
+                                       raw_ostream &VStream,
+                                       raw_ostream &CStream,
+                                       size_t MaxInsts) const {
+  size_t NumInsts = 0;
+  uint64_t Index = 0;
+  while (Index < Bytes.size() && NumInsts != MaxInsts) {
+    if (NumInsts == Insts.size())
+      Insts.resize(NumInsts + 1);
+    DecodedInst &D = Insts[NumInsts++];
+    D.Inst.clear();
+    D.Address = Address + Index;
+    D.Status = getInstructionFromBytes(D.Inst, D.Size, Bytes.slice(Index),
+                                       D.Address, VStream, CStream);
+    if (D.Status == Fail && D.Size == 0)
+      D.Size = 1; // skip illegible bytes
+    Index += D.Size;
+  }
+  return NumInsts;
+}
+
 void
 MCDisassembler::setupForSymbolicDisassembly(
     LLVMOpInfoCallback GetOpInfo,
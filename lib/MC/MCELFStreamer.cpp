@@ -439,6 +439,20 @@ void MCELFStreamer::EmitInstToFragment(const MCInst &Inst) {
 
 void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
   MCAssembler &Assembler = getAssembler();
+
+  // If bundling is disabled, encode the instruction straight into the current
+  // data fragment (or a new such fragment if the current fragment is not a
+  // data fragment).
+  if (!Assembler.isBundlingEnabled()) {
+    MCDataFragment *DF = getOrCreateDataFragment();
+    unsigned FirstFixup = DF->getFixups().size();
+    appendEncodedInst(*DF, Inst);
+    for (unsigned i = FirstFixup, e = DF->getFixups().size(); i != e; ++i)
+      fixSymbolsInTLSFixups(DF->getFixups()[i].getValue());
+    DF->setHasInstructions(true);
+    return;
+  }
+
   SmallVector<MCFixup, 4> Fixups;
   SmallString<256> Code;
   raw_svector_ostream VecOS(Code);
@@ -448,13 +462,7 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
   for (unsigned i = 0, e = Fixups.size(); i != e; ++i)
     fixSymbolsInTLSFixups(Fixups[i].getValue());
 
-  // There are several possibilities here:
-  //
-  // If bundling is disabled, append the encoded instruction to the current data
-  // fragment (or create a new such fragment if the current fragment is not a
-  // data fragment).
-  //
-  // If bundling is enabled:
+  // With bundling enabled, there are several possibilities:
   // - If we're not in a bundle-locked group, emit the instruction into a
   //   fragment of its own. If there are no fixups registered for the
   //   instruction, emit a MCCompactEncodedInstFragment. Otherwise, emit a
@@ -464,38 +472,33 @@ void MCELFStreamer::EmitInstToData(const MCInst &Inst) {
   //   the same fragment. Be careful not to do that for the first instruction in
   //   the group, though.
   MCDataFragment *DF;
-
-  if (Assembler.isBundlingEnabled()) {
-    MCSectionData *SD = getCurrentSectionData();
-    if (SD->isBundleLocked() && !SD->isBundleGroupBeforeFirstInst())
-      // If we are bundle-locked, we re-use the current fragment.
-      // The bundle-locking directive ensures this is a new data fragment.
-      DF = cast<MCDataFragment>(getCurrentFragment());
-    else if (!SD->isBundleLocked() && Fixups.size() == 0) {
-      // Optimize memory usage by emitting the instruction to a
-      // MCCompactEncodedInstFragment when not in a bundle-locked group and
-      // there are no fixups registered.
-      MCCompactEncodedInstFragment *CEIF = new MCCompactEncodedInstFragment();
-      insert(CEIF);
-      CEIF->getContents().append(Code.begin(), Code.end());
-      return;
-    } else {
-      DF = new MCDataFragment();
-      insert(DF);
-      if (SD->getBundleLockState() == MCSectionData::BundleLockedAlignToEnd) {
-        // If this is a new fragment created for a bundle-locked group, and the
-        // group was marked as "align_to_end", set a flag in the fragment.
-        DF->setAlignToBundleEnd(true);
-      }
-    }
-
-    // We're now emitting an instruction in a bundle group, so this flag has
-    // to be turned off.
-    SD->setBundleGroupBeforeFirstInst(false);
+  MCSectionData *SD = getCurrentSectionData();
+  if (SD->isBundleLocked() && !SD->isBundleGroupBeforeFirstInst())
+    // If we are bundle-locked, we re-use the current fragment.
+    // The bundle-locking directive ensures this is a new data fragment.
+    DF = cast<MCDataFragment>(getCurrentFragment());
+  else if (!SD->isBundleLocked() && Fixups.size() == 0) {
+    // Optimize memory usage by emitting the instruction to a
+    // MCCompactEncodedInstFragment when not in a bundle-locked group and
+    // there are no fixups registered.
+    MCCompactEncodedInstFragment *CEIF = new MCCompactEncodedInstFragment();
+    insert(CEIF);
+    CEIF->getContents().append(Code.begin(), Code.end());
+    return;
   } else {
-    DF = getOrCreateDataFragment();
+    DF = new MCDataFragment();
+    insert(DF);
+    if (SD->getBundleLockState() == MCSectionData::BundleLockedAlignToEnd) {
+      // If this is a new fragment created for a bundle-locked group, and the
+      // group was marked as "align_to_end", set a flag in the fragment.
+      DF->setAlignToBundleEnd(true);
+    }
   }
 
+  // We're now emitting an instruction in a bundle group, so this flag has
+  // to be turned off.
+  SD->setBundleGroupBeforeFirstInst(false);
+
   // Add the fixups and data.
   for (unsigned i = 0, e = Fixups.size(); i != e; ++i) {
     Fixups[i].setOffset(Fixups[i].getOffset() + DF->getContents().size());
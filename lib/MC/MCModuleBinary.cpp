@@ -0,0 +1,515 @@
+//===- MCModuleBinary.cpp - MCModule binary serialization -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of the binary representation of
+// MCModule.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/MCModuleBinary.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/MC/MCAtom.h"
+#include "llvm/MC/MCFunction.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/Support/Endian.h"
+#include <cstring>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::support;
+
+namespace {
+
+const char FileMagic[8] = { 'M', 'C', 'M', 'O', 'D', 'U', 'L', 'E' };
+const uint32_t FileVersion = 1;
+
+// All the records are made of unaligned little-endian fields, so they have
+// no padding and can be read from anywhere in the buffer.
+
+struct FileHeader {
+  char Magic[8];
+  ulittle32_t Version;
+  ulittle32_t NumOpcodes;
+  ulittle32_t NumRegs;
+  ulittle32_t KeySize;
+  ulittle32_t NumAtoms;
+  ulittle32_t NumInsts;
+  ulittle32_t NumOperands;
+  ulittle32_t NumFunctions;
+  ulittle32_t NumBlocks;
+  ulittle32_t NumEdges;
+  ulittle64_t DataSize;
+  ulittle64_t NamesSize;
+};
+
+struct AtomEntry {
+  ulittle64_t Begin;
+  ulittle64_t End;
+  // The first instruction and the number of instructions of a text atom, or
+  // the offset and size of the contents of a data atom.
+  ulittle64_t First;
+  ulittle64_t Count;
+  ulittle32_t NameOffset;
+  ulittle32_t NameSize;
+  uint8_t Kind;
+};
+
+struct InstEntry {
+  ulittle32_t Opcode;
+  ulittle32_t FirstOperand;
+  uint8_t Size;
+  uint8_t NumOperands;
+};
+
+enum OperandKind { OK_Reg, OK_Imm, OK_FPImm };
+
+struct OperandEntry {
+  uint8_t Kind;
+  // The register number, the immediate, or the bits of the FP immediate.
+  ulittle64_t Value;
+};
+
+struct FunctionEntry {
+  ulittle32_t NameOffset;
+  ulittle32_t NameSize;
+  ulittle32_t FirstBlock;
+  ulittle32_t NumBlocks;
+};
+
+struct BlockEntry {
+  ulittle32_t Atom;
+  // The successors of the block, followed by its predecessors, as indices of
+  // blocks in the edge array.
+  ulittle32_t FirstEdge;
+  ulittle32_t NumSuccs;
+  ulittle32_t NumPreds;
+};
+
+class MCModule2Binary {
+  const MCModule &MCM;
+  std::vector<AtomEntry> Atoms;
+  std::vector<InstEntry> Insts;
+  std::vector<OperandEntry> Operands;
+  std::vector<FunctionEntry> Functions;
+  std::vector<BlockEntry> Blocks;
+  std::vector<ulittle32_t> Edges;
+  std::string Data;
+  std::string Names;
+  DenseMap<const MCAtom *, uint32_t> AtomIndex;
+  DenseMap<const MCBasicBlock *, uint32_t> BlockIndex;
+
+  void addName(StringRef Name, ulittle32_t &Offset, ulittle32_t &Size);
+  StringRef dumpAtom(const MCAtom *MCA);
+  StringRef dumpFunction(const MCFunction *MCF);
+  StringRef dumpEdges(const MCBasicBlock *MCBB, BlockEntry &BB);
+
+public:
+  MCModule2Binary(const MCModule &MCM) : MCM(MCM) {}
+  StringRef dump();
+  void write(raw_ostream &OS, StringRef Key, const MCInstrInfo &MII,
+             const MCRegisterInfo &MRI);
+};
+
+class Binary2MCModule {
+  MCModule &MCM;
+  StringRef Buffer;
+  uint64_t Offset;
+  const FileHeader *Hdr;
+  const AtomEntry *Atoms;
+  const InstEntry *Insts;
+  const OperandEntry *Operands;
+  const FunctionEntry *Functions;
+  const BlockEntry *Blocks;
+  const ulittle32_t *Edges;
+  StringRef Data;
+  StringRef Names;
+
+  template <typename T> const T *getArray(uint64_t Count);
+  StringRef getBytes(uint64_t Size);
+  bool getName(ulittle32_t Offset, ulittle32_t Size, StringRef &Name);
+
+public:
+  Binary2MCModule(MCModule &MCM, StringRef Buffer)
+    : MCM(MCM), Buffer(Buffer), Offset(0) {}
+  StringRef parse(StringRef Key, const MCInstrInfo &MII,
+                  const MCRegisterInfo &MRI);
+};
+
+} // end unnamed namespace
+
+void MCModule2Binary::addName(StringRef Name, ulittle32_t &Offset,
+                              ulittle32_t &Size) {
+  Offset = Names.size();
+  Size = Name.size();
+  Names += Name;
+}
+
+StringRef MCModule2Binary::dump() {
+  for (MCModule::const_atom_iterator AI = MCM.atom_begin(), AE = MCM.atom_end();
+       AI != AE; ++AI) {
+    StringRef Err = dumpAtom(*AI);
+    if (!Err.empty())
+      return Err;
+  }
+  for (MCModule::const_func_iterator FI = MCM.func_begin(), FE = MCM.func_end();
+       FI != FE; ++FI) {
+    StringRef Err = dumpFunction(*FI);
+    if (!Err.empty())
+      return Err;
+  }
+  // Edges can only be written once every block has its index.
+  for (MCModule::const_func_iterator FI = MCM.func_begin(), FE = MCM.func_end();
+       FI != FE; ++FI) {
+    for (MCFunction::const_iterator BBI = (*FI)->begin(), BBE = (*FI)->end();
+         BBI != BBE; ++BBI) {
+      StringRef Err = dumpEdges(*BBI, Blocks[BlockIndex[*BBI]]);
+      if (!Err.empty())
+        return Err;
+    }
+  }
+  if (Names.size() > UINT32_MAX || Insts.size() > UINT32_MAX ||
+      Operands.size() > UINT32_MAX || Edges.size() > UINT32_MAX)
+    return "Module is too large for the binary format.";
+  return "";
+}
+
+StringRef MCModule2Binary::dumpAtom(const MCAtom *MCA) {
+  // Only write what the reader can recreate as is.
+  if (!Atoms.empty() && MCA->getBeginAddr() <= Atoms.back().End)
+    return "Atoms must be sorted and can't overlap!";
+  AtomIndex[MCA] = Atoms.size();
+  Atoms.resize(Atoms.size() + 1);
+  AtomEntry &A = Atoms.back();
+  A.Begin = MCA->getBeginAddr();
+  A.End = MCA->getEndAddr();
+  A.Kind = MCA->getKind();
+  addName(MCA->getName(), A.NameOffset, A.NameSize);
+  if (const MCTextAtom *TA = dyn_cast<MCTextAtom>(MCA)) {
+    A.First = Insts.size();
+    A.Count = TA->size();
+    uint64_t NextInstAddress = MCA->getBeginAddr();
+    for (MCTextAtom::const_iterator II = TA->begin(), IE = TA->end(); II != IE;
+         ++II) {
+      const MCInst &MI = II->Inst;
+      if (II->Address != NextInstAddress || II->Size == 0 ||
+          II->Address + II->Size - 1 > MCA->getEndAddr())
+        return "Instructions don't fit in their atom!";
+      NextInstAddress += II->Size;
+      if (II->Size > UINT8_MAX || MI.getNumOperands() > UINT8_MAX)
+        return "Instruction is too large for the binary format.";
+      Insts.resize(Insts.size() + 1);
+      InstEntry &I = Insts.back();
+      I.Opcode = MI.getOpcode();
+      I.FirstOperand = Operands.size();
+      I.Size = II->Size;
+      I.NumOperands = MI.getNumOperands();
+      for (unsigned oi = 0, oe = MI.getNumOperands(); oi != oe; ++oi) {
+        const MCOperand &MCOp = MI.getOperand(oi);
+        Operands.resize(Operands.size() + 1);
+        OperandEntry &Op = Operands.back();
+        if (MCOp.isReg()) {
+          Op.Kind = OK_Reg;
+          Op.Value = MCOp.getReg();
+        } else if (MCOp.isImm()) {
+          Op.Kind = OK_Imm;
+          Op.Value = MCOp.getImm();
+        } else if (MCOp.isFPImm()) {
+          double FPImm = MCOp.getFPImm();
+          uint64_t Bits;
+          memcpy(&Bits, &FPImm, sizeof(Bits));
+          Op.Kind = OK_FPImm;
+          Op.Value = Bits;
+        } else {
+          return "Only register and immediate operands can be written.";
+        }
+      }
+    }
+  } else if (const MCDataAtom *DA = dyn_cast<MCDataAtom>(MCA)) {
+    ArrayRef<MCData> Contents = DA->getData();
+    A.First = Data.size();
+    A.Count = Contents.size();
+    Data.append(Contents.begin(), Contents.end());
+  } else {
+    llvm_unreachable("Unknown atom type.");
+  }
+  return "";
+}
+
+StringRef MCModule2Binary::dumpFunction(const MCFunction *MCF) {
+  Functions.resize(Functions.size() + 1);
+  FunctionEntry &F = Functions.back();
+  addName(MCF->getName(), F.NameOffset, F.NameSize);
+  F.FirstBlock = Blocks.size();
+  F.NumBlocks = MCF->end() - MCF->begin();
+  for (MCFunction::const_iterator BBI = MCF->begin(), BBE = MCF->end();
+       BBI != BBE; ++BBI) {
+    DenseMap<const MCAtom *, uint32_t>::const_iterator It =
+      AtomIndex.find((*BBI)->getInsts());
+    if (It == AtomIndex.end())
+      return "Basic block isn't backed by an atom of the module!";
+    BlockIndex[*BBI] = Blocks.size();
+    Blocks.resize(Blocks.size() + 1);
+    Blocks.back().Atom = It->second;
+  }
+  return "";
+}
+
+StringRef MCModule2Binary::dumpEdges(const MCBasicBlock *MCBB,
+                                     BlockEntry &BB) {
+  BB.FirstEdge = Edges.size();
+  BB.NumSuccs = MCBB->succ_end() - MCBB->succ_begin();
+  BB.NumPreds = MCBB->pred_end() - MCBB->pred_begin();
+  for (MCBasicBlock::succ_const_iterator SI = MCBB->succ_begin(),
+                                         SE = MCBB->succ_end();
+       SI != SE; ++SI) {
+    DenseMap<const MCBasicBlock *, uint32_t>::const_iterator It =
+      BlockIndex.find(*SI);
+    if (It == BlockIndex.end())
+      return "Successor basic block isn't in any function!";
+    Edges.push_back(ulittle32_t());
+    Edges.back() = It->second;
+  }
+  for (MCBasicBlock::pred_const_iterator PI = MCBB->pred_begin(),
+                                         PE = MCBB->pred_end();
+       PI != PE; ++PI) {
+    DenseMap<const MCBasicBlock *, uint32_t>::const_iterator It =
+      BlockIndex.find(*PI);
+    if (It == BlockIndex.end())
+      return "Predecessor basic block isn't in any function!";
+    Edges.push_back(ulittle32_t());
+    Edges.back() = It->second;
+  }
+  return "";
+}
+
+template <typename T>
+static void writeArray(raw_ostream &OS, const std::vector<T> &V) {
+  if (!V.empty())
+    OS.write(reinterpret_cast<const char *>(&V[0]), V.size() * sizeof(T));
+}
+
+void MCModule2Binary::write(raw_ostream &OS, StringRef Key,
+                            const MCInstrInfo &MII,
+                            const MCRegisterInfo &MRI) {
+  FileHeader Hdr;
+  memcpy(Hdr.Magic, FileMagic, sizeof(FileMagic));
+  Hdr.Version = FileVersion;
+  Hdr.NumOpcodes = MII.getNumOpcodes();
+  Hdr.NumRegs = MRI.getNumRegs();
+  Hdr.KeySize = Key.size();
+  Hdr.NumAtoms = Atoms.size();
+  Hdr.NumInsts = Insts.size();
+  Hdr.NumOperands = Operands.size();
+  Hdr.NumFunctions = Functions.size();
+  Hdr.NumBlocks = Blocks.size();
+  Hdr.NumEdges = Edges.size();
+  Hdr.DataSize = Data.size();
+  Hdr.NamesSize = Names.size();
+  OS.write(reinterpret_cast<const char *>(&Hdr), sizeof(Hdr));
+  OS << Key;
+  writeArray(OS, Atoms);
+  writeArray(OS, Insts);
+  writeArray(OS, Operands);
+  writeArray(OS, Functions);
+  writeArray(OS, Blocks);
+  writeArray(OS, Edges);
+  OS << Data << Names;
+}
+
+template <typename T> const T *Binary2MCModule::getArray(uint64_t Count) {
+  // Count is at most a 32-bit value, so this can't overflow.
+  uint64_t Size = Count * sizeof(T);
+  if (Size > Buffer.size() - Offset)
+    return 0;
+  const T *Array = reinterpret_cast<const T *>(Buffer.data() + Offset);
+  Offset += Size;
+  return Array;
+}
+
+StringRef Binary2MCModule::getBytes(uint64_t Size) {
+  if (Size > Buffer.size() - Offset)
+    return StringRef();
+  StringRef Bytes = Buffer.substr(Offset, Size);
+  Offset += Size;
+  return Bytes;
+}
+
+bool Binary2MCModule::getName(ulittle32_t NameOffset, ulittle32_t NameSize,
+                              StringRef &Name) {
+  if (NameOffset > Names.size() || NameSize > Names.size() - NameOffset)
+    return false;
+  Name = Names.substr(NameOffset, NameSize);
+  return true;
+}
+
+StringRef Binary2MCModule::parse(StringRef Key, const MCInstrInfo &MII,
+                                 const MCRegisterInfo &MRI) {
+  Hdr = getArray<FileHeader>(1);
+  if (!Hdr || memcmp(Hdr->Magic, FileMagic, sizeof(FileMagic)) != 0)
+    return "Not a binary MCModule.";
+  if (Hdr->Version != FileVersion)
+    return "Unsupported binary MCModule version.";
+  if (Hdr->NumOpcodes != MII.getNumOpcodes() ||
+      Hdr->NumRegs != MRI.getNumRegs())
+    return "Binary MCModule was written for another target.";
+  StringRef FileKey = getBytes(Hdr->KeySize);
+  if (FileKey.size() != Hdr->KeySize)
+    return "Binary MCModule has an invalid size.";
+  if (FileKey != Key)
+    return "Binary MCModule was written with another key.";
+
+  Atoms = getArray<AtomEntry>(Hdr->NumAtoms);
+  Insts = getArray<InstEntry>(Hdr->NumInsts);
+  Operands = getArray<OperandEntry>(Hdr->NumOperands);
+  Functions = getArray<FunctionEntry>(Hdr->NumFunctions);
+  Blocks = getArray<BlockEntry>(Hdr->NumBlocks);
+  Edges = getArray<ulittle32_t>(Hdr->NumEdges);
+  Data = getBytes(Hdr->DataSize);
+  Names = getBytes(Hdr->NamesSize);
+  if (!Atoms || !Insts || !Operands || !Functions || !Blocks || !Edges ||
+      Data.size() != Hdr->DataSize || Names.size() != Hdr->NamesSize ||
+      Offset != Buffer.size())
+    return "Binary MCModule has an invalid size.";
+
+  std::vector<MCTextAtom *> TextAtoms(Hdr->NumAtoms);
+  for (uint32_t ai = 0, ae = Hdr->NumAtoms; ai != ae; ++ai) {
+    const AtomEntry &A = Atoms[ai];
+    uint64_t Begin = A.Begin, End = A.End;
+    if (Begin > End || (ai != 0 && Begin <= Atoms[ai - 1].End))
+      return "Atoms must be sorted and can't overlap!";
+    StringRef Name;
+    if (!getName(A.NameOffset, A.NameSize, Name))
+      return "Invalid atom name.";
+    uint64_t First = A.First, Count = A.Count;
+    switch (A.Kind) {
+    case MCAtom::TextAtom: {
+      if (First > Hdr->NumInsts || Count > Hdr->NumInsts - First)
+        return "Invalid atom instructions.";
+      MCTextAtom *TA = MCM.createTextAtom(Begin, End);
+      TA->setName(Name);
+      TextAtoms[ai] = TA;
+      uint64_t Size = 0;
+      for (uint64_t ii = First, ie = First + Count; ii != ie; ++ii) {
+        const InstEntry &I = Insts[ii];
+        uint32_t FirstOp = I.FirstOperand;
+        if (I.Opcode >= Hdr->NumOpcodes)
+          return "Invalid instruction opcode.";
+        if (FirstOp > Hdr->NumOperands ||
+            I.NumOperands > Hdr->NumOperands - FirstOp)
+          return "Invalid instruction operands.";
+        Size += I.Size;
+        if (I.Size == 0 || Size > End - Begin + 1)
+          return "Instructions don't fit in their atom!";
+        MCInst MI;
+        MI.setOpcode(I.Opcode);
+        for (uint32_t oi = FirstOp, oe = FirstOp + I.NumOperands; oi != oe;
+             ++oi) {
+          const OperandEntry &Op = Operands[oi];
+          uint64_t Value = Op.Value;
+          switch (Op.Kind) {
+          case OK_Reg:
+            if (Value >= Hdr->NumRegs)
+              return "Invalid register.";
+            MI.addOperand(MCOperand::CreateReg(Value));
+            break;
+          case OK_Imm:
+            MI.addOperand(MCOperand::CreateImm(Value));
+            break;
+          case OK_FPImm: {
+            double FPImm;
+            memcpy(&FPImm, &Value, sizeof(FPImm));
+            MI.addOperand(MCOperand::CreateFPImm(FPImm));
+            break;
+          }
+          default:
+            return "Invalid operand kind.";
+          }
+        }
+        TA->addInst(MI, I.Size);
+      }
+      break;
+    }
+    case MCAtom::DataAtom: {
+      if (First > Data.size() || Count > Data.size() - First ||
+          Count > End - Begin + 1)
+        return "Invalid atom data.";
+      MCDataAtom *DA = MCM.createDataAtom(Begin, End);
+      DA->setName(Name);
+      for (uint64_t i = First, e = First + Count; i != e; ++i)
+        DA->addData((uint8_t)Data[i]);
+      break;
+    }
+    default:
+      return "Invalid atom kind.";
+    }
+  }
+
+  std::vector<MCBasicBlock *> BBs;
+  BBs.reserve(Hdr->NumBlocks);
+  for (uint32_t fi = 0, fe = Hdr->NumFunctions; fi != fe; ++fi) {
+    const FunctionEntry &F = Functions[fi];
+    StringRef Name;
+    if (!getName(F.NameOffset, F.NameSize, Name))
+      return "Invalid function name.";
+    // The blocks of the functions follow each other.
+    if (F.FirstBlock != BBs.size() ||
+        F.NumBlocks > Hdr->NumBlocks - BBs.size())
+      return "Invalid function basic blocks.";
+    MCFunction *MCFN = MCM.createFunction(Name);
+    for (uint32_t bi = F.FirstBlock, be = bi + F.NumBlocks; bi != be; ++bi) {
+      uint32_t Atom = Blocks[bi].Atom;
+      if (Atom >= Hdr->NumAtoms || !TextAtoms[Atom])
+        return "Basic block isn't backed by a text atom!";
+      BBs.push_back(&MCFN->createBlock(*TextAtoms[Atom]));
+    }
+  }
+  if (BBs.size() != Hdr->NumBlocks)
+    return "Basic block doesn't belong to any function!";
+
+  for (uint32_t bi = 0, be = Hdr->NumBlocks; bi != be; ++bi) {
+    const BlockEntry &BB = Blocks[bi];
+    uint32_t FirstEdge = BB.FirstEdge;
+    uint64_t NumEdges = uint64_t(BB.NumSuccs) + BB.NumPreds;
+    if (FirstEdge > Hdr->NumEdges || NumEdges > Hdr->NumEdges - FirstEdge)
+      return "Invalid basic block edges.";
+    for (uint32_t ei = FirstEdge, ee = FirstEdge + NumEdges; ei != ee; ++ei) {
+      uint32_t Other = Edges[ei];
+      if (Other >= Hdr->NumBlocks)
+        return "Invalid basic block edge.";
+      if (ei - FirstEdge < BB.NumSuccs)
+        BBs[bi]->addSuccessor(BBs[Other]);
+      else
+        BBs[bi]->addPredecessor(BBs[Other]);
+    }
+  }
+  return "";
+}
+
+StringRef llvm::mcmodule2binary(raw_ostream &OS, const MCModule &MCM,
+                                StringRef Key, const MCInstrInfo &MII,
+                                const MCRegisterInfo &MRI) {
+  MCModule2Binary Dumper(MCM);
+  StringRef Err = Dumper.dump();
+  if (!Err.empty())
+    return Err;
+  Dumper.write(OS, Key, MII, MRI);
+  return "";
+}
+
+StringRef llvm::binary2mcmodule(OwningPtr<MCModule> &MCM, StringRef Buffer,
+                                StringRef Key, const MCInstrInfo &MII,
+                                const MCRegisterInfo &MRI) {
+  MCM.reset(new MCModule);
+  Binary2MCModule Parser(*MCM, Buffer);
+  StringRef Err = Parser.parse(Key, MII, MRI);
+  if (!Err.empty())
+    MCM.reset();
+  return Err;
+}
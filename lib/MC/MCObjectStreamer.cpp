@@ -74,6 +74,22 @@ MCDataFragment *MCObjectStreamer::getOrCreateDataFragment() const {
   return F;
 }
 
+void MCObjectStreamer::appendEncodedInst(MCEncodedFragmentWithFixups &F,
+                                         const MCInst &Inst) {
+  SmallVectorImpl<MCFixup> &Fixups = F.getFixups();
+  unsigned FirstFixup = Fixups.size();
+  uint64_t Offset = F.getContents().size();
+  {
+    raw_svector_ostream VecOS(F.getContents());
+    getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
+  }
+
+  // The emitter places fixups relative to the start of the instruction.
+  if (Offset)
+    for (unsigned i = FirstFixup, e = Fixups.size(); i != e; ++i)
+      Fixups[i].setOffset(Fixups[i].getOffset() + Offset);
+}
+
 const MCExpr *MCObjectStreamer::AddValueSymbols(const MCExpr *Value) {
   switch (Value->getKind()) {
   case MCExpr::Target:
@@ -236,12 +252,7 @@ void MCObjectStreamer::EmitInstToFragment(const MCInst &Inst) {
   // during relaxation.
   MCRelaxableFragment *IF = new MCRelaxableFragment(Inst);
   insert(IF);
-
-  SmallString<128> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, IF->getFixups());
-  VecOS.flush();
-  IF->getContents().append(Code.begin(), Code.end());
+  appendEncodedInst(*IF, Inst);
 }
 
 #ifndef NDEBUG
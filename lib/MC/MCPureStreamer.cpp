@@ -196,31 +196,11 @@ void MCPureStreamer::EmitInstToFragment(const MCInst &Inst) {
   //
   // FIXME: Revisit this design decision when relaxation is done, we may be
   // able to get away with not storing any extra data in the MCInst.
-  SmallVector<MCFixup, 4> Fixups;
-  SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-  VecOS.flush();
-
-  IF->getContents() = Code;
-  IF->getFixups() = Fixups;
+  appendEncodedInst(*IF, Inst);
 }
 
 void MCPureStreamer::EmitInstToData(const MCInst &Inst) {
-  MCDataFragment *DF = getOrCreateDataFragment();
-
-  SmallVector<MCFixup, 4> Fixups;
-  SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
-  getAssembler().getEmitter().EncodeInstruction(Inst, VecOS, Fixups);
-  VecOS.flush();
-
-  // Add the fixups and data.
-  for (unsigned i = 0, e = Fixups.size(); i != e; ++i) {
-    Fixups[i].setOffset(Fixups[i].getOffset() + DF->getContents().size());
-    DF->getFixups().push_back(Fixups[i]);
-  }
-  DF->getContents().append(Code.begin(), Code.end());
+  appendEncodedInst(*getOrCreateDataFragment(), Inst);
 }
 
 void MCPureStreamer::FinishImpl() {
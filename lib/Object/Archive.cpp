@@ -17,11 +17,14 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include <algorithm>
 
 using namespace llvm;
 using namespace object;
 
 static const char *const Magic = "!<arch>\n";
+static const char *const ThinMagic = "!<thin>\n";
 
 void Archive::anchor() { }
 
@@ -80,13 +83,20 @@ unsigned ArchiveMemberHeader::getGID() const {
 }
 
 Archive::Child::Child(const Archive *Parent, const char *Start)
-    : Parent(Parent) {
+    : Parent(Parent), IsThinMember(false) {
   if (!Start)
     return;
 
   const ArchiveMemberHeader *Header =
       reinterpret_cast<const ArchiveMemberHeader *>(Start);
-  Data = StringRef(Start, sizeof(ArchiveMemberHeader) + Header->getSize());
+  // The symbol and string tables of a thin archive are stored in it like in
+  // any other archive, but its members are just a header.
+  if (Parent->IsThin) {
+    StringRef Name = Header->getName();
+    IsThinMember = Name != "/" && Name != "//";
+  }
+  Data = StringRef(Start, sizeof(ArchiveMemberHeader) +
+                              (IsThinMember ? 0 : Header->getSize()));
 
   // Setup StartOfFile and PaddingBytes.
   StartOfFile = sizeof(ArchiveMemberHeader);
@@ -144,8 +154,12 @@ error_code Archive::Child::getName(StringRef &Result) const {
                    + Parent->StringTable->getSize()))
       return object_error::parse_failed;
 
-    // GNU long file names end with a /.
-    if (Parent->kind() == K_GNU) {
+    // GNU long file names end with a /. The names of thin archive members
+    // are paths, so only a / that ends the line counts.
+    if (Parent->IsThin) {
+      StringRef::size_type End = StringRef(addr).find("/\n");
+      Result = StringRef(addr, End);
+    } else if (Parent->kind() == K_GNU) {
       StringRef::size_type End = StringRef(addr).find('/');
       Result = StringRef(addr, End);
     } else {
@@ -168,16 +182,30 @@ error_code Archive::Child::getName(StringRef &Result) const {
   return object_error::success;
 }
 
+StringRef Archive::Child::getBuffer() const {
+  if (!IsThinMember)
+    return StringRef(Data.data() + StartOfFile, getSize());
+  StringRef Name, Result;
+  if (getName(Name) || Parent->getThinMember(Data.data(), Name, Result))
+    return StringRef();
+  return Result;
+}
+
 error_code Archive::Child::getMemoryBuffer(OwningPtr<MemoryBuffer> &Result,
                                            bool FullPath) const {
   StringRef Name;
   if (error_code ec = getName(Name))
     return ec;
+  StringRef Buffer;
+  if (!IsThinMember)
+    Buffer = getBuffer();
+  else if (error_code ec = Parent->getThinMember(Data.data(), Name, Buffer))
+    return ec;
   SmallString<128> Path;
   Result.reset(MemoryBuffer::getMemBuffer(
-      getBuffer(), FullPath ? (Twine(Parent->getFileName()) + "(" + Name + ")")
-                                  .toStringRef(Path)
-                            : Name,
+      Buffer, FullPath ? (Twine(Parent->getFileName()) + "(" + Name + ")")
+                             .toStringRef(Path)
+                       : Name,
       false));
   return error_code::success();
 }
@@ -194,11 +222,18 @@ error_code Archive::Child::getAsBinary(OwningPtr<Binary> &Result) const {
 }
 
 Archive::Archive(MemoryBuffer *source, error_code &ec)
-  : Binary(Binary::ID_Archive, source), SymbolTable(end_children()) {
+  : Binary(Binary::ID_Archive, source), SymbolTable(end_children()),
+    IsThin(false), HasSymbolIndex(false) {
   // Check for sufficient magic.
   assert(source);
-  if (source->getBufferSize() < 8 ||
-      StringRef(source->getBufferStart(), 8) != Magic) {
+  if (source->getBufferSize() < 8) {
+    ec = object_error::invalid_file_type;
+    return;
+  }
+  StringRef Buffer = source->getBuffer();
+  if (Buffer.startswith(ThinMagic)) {
+    IsThin = true;
+  } else if (!Buffer.startswith(Magic)) {
     ec = object_error::invalid_file_type;
     return;
   }
@@ -309,6 +344,35 @@ Archive::Archive(MemoryBuffer *source, error_code &ec)
   ec = object_error::success;
 }
 
+Archive::~Archive() {
+  for (DenseMap<const char *, MemoryBuffer *>::iterator I = ThinMembers.begin(),
+                                                         E = ThinMembers.end();
+       I != E; ++I)
+    delete I->second;
+}
+
+std::string Archive::getThinMemberPath(StringRef Name) const {
+  if (sys::path::is_absolute(Name))
+    return Name;
+  SmallString<128> Path(sys::path::parent_path(getFileName()));
+  sys::path::append(Path, Name);
+  return Path.str();
+}
+
+error_code Archive::getThinMember(const char *Start, StringRef Name,
+                                  StringRef &Result) const {
+  MemoryBuffer *&Buffer = ThinMembers[Start];
+  if (!Buffer) {
+    OwningPtr<MemoryBuffer> File;
+    if (error_code ec = MemoryBuffer::getFile(getThinMemberPath(Name), File,
+                                              -1, false))
+      return ec;
+    Buffer = File.take();
+  }
+  Result = Buffer->getBuffer();
+  return object_error::success;
+}
+
 Archive::child_iterator Archive::begin_children(bool SkipInternal) const {
   if (Data->getBufferSize() == 8) // empty archive.
     return end_children();
@@ -427,22 +491,47 @@ Archive::symbol_iterator Archive::end_symbols() const {
     Symbol(this, symbol_count, 0));
 }
 
+namespace {
+struct SymbolIndexLess {
+  bool operator()(const std::pair<StringRef, uint32_t> &LHS,
+                  const std::pair<StringRef, uint32_t> &RHS) const {
+    return LHS.first < RHS.first;
+  }
+  bool operator()(const std::pair<StringRef, uint32_t> &LHS,
+                  StringRef RHS) const {
+    return LHS.first < RHS;
+  }
+};
+}
+
 Archive::child_iterator Archive::findSym(StringRef name) const {
-  Archive::symbol_iterator bs = begin_symbols();
-  Archive::symbol_iterator es = end_symbols();
-  Archive::child_iterator result;
-  
-  StringRef symname;
-  for (; bs != es; ++bs) {
-    if (bs->getName(symname))
-        return end_children();
-    if (symname == name) {
-      if (bs->getMember(result))
-        return end_children();
-      return result;
+  if (!HasSymbolIndex) {
+    HasSymbolIndex = true;
+    StringRef symname;
+    uint32_t Index = 0;
+    for (Archive::symbol_iterator bs = begin_symbols(), es = end_symbols();
+         bs != es; ++bs, ++Index) {
+      if (bs->getName(symname))
+        break;
+      SymbolIndex.push_back(std::make_pair(symname, Index));
     }
+    // Keep the symbols with the same name in table order, so that the first
+    // member defining a symbol is found as before.
+    std::stable_sort(SymbolIndex.begin(), SymbolIndex.end(),
+                     SymbolIndexLess());
   }
-  return end_children();
+
+  std::vector<std::pair<StringRef, uint32_t> >::const_iterator I =
+      std::lower_bound(SymbolIndex.begin(), SymbolIndex.end(), name,
+                       SymbolIndexLess());
+  if (I == SymbolIndex.end() || I->first != name)
+    return end_children();
+
+  const char *Strings = SymbolTable->getBuffer().begin();
+  Archive::child_iterator result;
+  if (Symbol(this, I->second, I->first.data() - Strings).getMember(result))
+    return end_children();
+  return result;
 }
 
 bool Archive::hasSymbolTable() const {
@@ -186,6 +186,39 @@ void MallocSlabAllocator::Deallocate(MemSlab *Slab) {
   Allocator.Deallocate(Slab);
 }
 
+RecyclingSlabAllocator::~RecyclingSlabAllocator() {
+  clear();
+}
+
+MemSlab *RecyclingSlabAllocator::Allocate(size_t Size) {
+  if (Size != SlabSize || !FreeSlabs)
+    return Allocator.Allocate(Size);
+  MemSlab *Slab = FreeSlabs;
+  FreeSlabs = Slab->NextPtr;
+  --NumFreeSlabs;
+  Slab->NextPtr = 0;
+  return Slab;
+}
+
+void RecyclingSlabAllocator::Deallocate(MemSlab *Slab) {
+  if (Slab->Size != SlabSize || NumFreeSlabs == MaxFreeSlabs) {
+    Allocator.Deallocate(Slab);
+    return;
+  }
+  Slab->NextPtr = FreeSlabs;
+  FreeSlabs = Slab;
+  ++NumFreeSlabs;
+}
+
+void RecyclingSlabAllocator::clear() {
+  while (FreeSlabs) {
+    MemSlab *Slab = FreeSlabs;
+    FreeSlabs = Slab->NextPtr;
+    Allocator.Deallocate(Slab);
+  }
+  NumFreeSlabs = 0;
+}
+
 void PrintRecyclerStats(size_t Size,
                         size_t Align,
                         size_t FreeListSize) {
@@ -866,7 +866,8 @@ error_code has_magic(const Twine &path, const Twine &magic, bool &result) {
       break;
     case '!':
       if (Magic.size() >= 8)
-        if (memcmp(Magic.data(),"!<arch>\n",8) == 0)
+        if (memcmp(Magic.data(),"!<arch>\n",8) == 0 ||
+            memcmp(Magic.data(),"!<thin>\n",8) == 0)
           return file_magic::archive;
       break;
 
@@ -63,8 +63,59 @@ void llvm::llvm_release_global_lock() {
   if (multithreaded_mode) global_lock->release();
 }
 
+namespace {
+/// ParallelInfo - The work shared by the threads of one
+/// llvm_execute_in_parallel() call.
+struct ParallelInfo {
+  void (*UserFn)(void *, unsigned);
+  void *UserData;
+  unsigned NumTasks;
+  volatile sys::cas_flag NextTask;
+};
+}
+
+/// ExecuteInParallel_Worker - Run tasks until there are none left.
+static void ExecuteInParallel_Worker(void *Arg) {
+  ParallelInfo *PI = reinterpret_cast<ParallelInfo*>(Arg);
+  for (;;) {
+    unsigned Task = sys::AtomicIncrement(&PI->NextTask) - 1;
+    if (Task >= PI->NumTasks)
+      return;
+    PI->UserFn(PI->UserData, Task);
+  }
+}
+
 #if LLVM_ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H)
 #include <pthread.h>
+#include <vector>
+
+static void *ExecuteInParallel_Dispatch(void *Arg) {
+  ExecuteInParallel_Worker(Arg);
+  return 0;
+}
+
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  ParallelInfo Info = { Fn, UserData, NumTasks, 0 };
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+  // Start the helpers; if a thread cannot be created the remaining ones just
+  // share the work.
+  std::vector<pthread_t> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    pthread_t Thread;
+    if (::pthread_create(&Thread, 0, ExecuteInParallel_Dispatch, &Info) != 0)
+      break;
+    Threads.push_back(Thread);
+  }
+
+  ExecuteInParallel_Worker(&Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    ::pthread_join(Threads[i], 0);
+}
 
 struct ThreadInfo {
   void (*UserFn)(void *);
@@ -105,6 +156,7 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/Windows.h"
 #include <process.h>
+#include <vector>
 
 struct ThreadInfo {
   void (*func)(void*);
@@ -136,6 +188,31 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  ParallelInfo Info = { Fn, UserData, NumTasks, 0 };
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+  struct ThreadInfo param = { ExecuteInParallel_Worker, &Info };
+  std::vector<HANDLE> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    HANDLE hThread = (HANDLE)::_beginthreadex(NULL, 0, ThreadCallback,
+                                              &param, 0, NULL);
+    if (!hThread)
+      break;
+    Threads.push_back(hThread);
+  }
+
+  ExecuteInParallel_Worker(&Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i) {
+    (void)::WaitForSingleObject(Threads[i], INFINITE);
+    ::CloseHandle(Threads[i]);
+  }
+}
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -144,4 +221,12 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  (void) NumThreads;
+  for (unsigned i = 0; i != NumTasks; ++i)
+    Fn(UserData, i);
+}
+
 #endif
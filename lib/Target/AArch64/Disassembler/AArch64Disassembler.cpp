@@ -56,7 +56,20 @@ public:
                               raw_ostream &vStream,
                               raw_ostream &cStream) const;
 
+  /// See MCDisassembler.
+  DecodeStatus getInstructionFromBytes(MCInst &instr,
+                                       uint64_t &size,
+                                       ArrayRef<uint8_t> bytes,
+                                       uint64_t address,
+                                       raw_ostream &vStream,
+                                       raw_ostream &cStream) const;
+
   const MCRegisterInfo *getRegInfo() const { return RegInfo.get(); }
+
+private:
+  /// Decodes the 4 bytes of an instruction.
+  DecodeStatus decodeWord(MCInst &MI, uint64_t &Size, const uint8_t *Bytes,
+                          uint64_t Address) const;
 };
 
 }
@@ -247,6 +260,28 @@ DecodeStatus AArch64Disassembler::getInstruction(MCInst &MI, uint64_t &Size,
     return MCDisassembler::Fail;
   }
 
+  return decodeWord(MI, Size, bytes, Address);
+}
+
+DecodeStatus
+AArch64Disassembler::getInstructionFromBytes(MCInst &MI, uint64_t &Size,
+                                             ArrayRef<uint8_t> Bytes,
+                                             uint64_t Address,
+                                             raw_ostream &os,
+                                             raw_ostream &cs) const {
+  CommentStream = &cs;
+
+  if (Bytes.size() < 4) {
+    Size = 0;
+    return MCDisassembler::Fail;
+  }
+
+  return decodeWord(MI, Size, Bytes.data(), Address);
+}
+
+DecodeStatus AArch64Disassembler::decodeWord(MCInst &MI, uint64_t &Size,
+                                             const uint8_t *bytes,
+                                             uint64_t Address) const {
   // Encoded as a small-endian 32-bit word in the stream.
   uint32_t insn = (bytes[3] << 24) |
     (bytes[2] << 16) |
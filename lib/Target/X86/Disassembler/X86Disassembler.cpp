@@ -107,6 +107,26 @@ static void logger(void* arg, const char* log) {
   vStream << log << "\n";
 }  
   
+/// finishInstruction - Translates a decoded instruction into an MCInst, or
+///   reports the failure to decode one.
+///
+/// @param ret      - The result of the decoder.
+/// @param address  - The address of the first byte of the instruction.
+static MCDisassembler::DecodeStatus
+finishInstruction(MCInst &instr, uint64_t &size,
+                  InternalInstruction &internalInstr, int ret,
+                  uint64_t address, const MCDisassembler *Dis) {
+  if (ret) {
+    size = internalInstr.readerCursor - address;
+    return MCDisassembler::Fail;
+  }
+  else {
+    size = internalInstr.length;
+    return (!translateInstruction(instr, internalInstr, Dis)) ?
+            MCDisassembler::Success : MCDisassembler::Fail;
+  }
+}
+
 //
 // Public interface for the disassembler
 //
@@ -135,17 +155,38 @@ X86GenericDisassembler::getInstruction(MCInst &instr,
                               address,
                               fMode);
 
-  if (ret) {
-    size = internalInstr.readerCursor - address;
-    return Fail;
-  }
-  else {
-    size = internalInstr.length;
-    return (!translateInstruction(instr, internalInstr, this)) ?
-            Success : Fail;
-  }
+  return finishInstruction(instr, size, internalInstr, ret, address, this);
 }
 
+MCDisassembler::DecodeStatus
+X86GenericDisassembler::getInstructionFromBytes(MCInst &instr,
+                                                uint64_t &size,
+                                                ArrayRef<uint8_t> bytes,
+                                                uint64_t address,
+                                                raw_ostream &vStream,
+                                                raw_ostream &cStream) const {
+  CommentStream = &cStream;
+
+  InternalInstruction internalInstr;
+
+  dlog_t loggerFn = logger;
+  if (&vStream == &nulls())
+    loggerFn = 0; // Disable logging completely if it's going to nulls().
+
+  int ret = decodeInstructionFromBuffer(&internalInstr,
+                                        bytes.data(),
+                                        bytes.size(),
+                                        address,
+                                        loggerFn,
+                                        (void*)&vStream,
+                                        (const void*)MII,
+                                        address,
+                                        fMode);
+
+  return finishInstruction(instr, size, internalInstr, ret, address, this);
+}
+
+
 //
 // Private code that translates from struct InternalInstructions to MCInsts.
 //
@@ -157,7 +198,7 @@ X86GenericDisassembler::getInstruction(MCInst &instr,
 /// @param reg        - The Reg to append.
 static void translateRegister(MCInst &mcInst, Reg reg) {
 #define ENTRY(x) X86::x,
-  uint8_t llvmRegnums[] = {
+  static const uint8_t llvmRegnums[] = {
     ALL_REGS
     0
   };
@@ -120,6 +120,14 @@ public:
                               raw_ostream &vStream,
                               raw_ostream &cStream) const;
 
+  /// getInstructionFromBytes - See MCDisassembler.
+  DecodeStatus getInstructionFromBytes(MCInst &instr,
+                                       uint64_t &size,
+                                       ArrayRef<uint8_t> bytes,
+                                       uint64_t address,
+                                       raw_ostream &vStream,
+                                       raw_ostream &cStream) const;
+
 private:
   DisassemblerMode              fMode;
 };
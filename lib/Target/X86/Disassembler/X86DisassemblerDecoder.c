@@ -14,6 +14,7 @@
  *===----------------------------------------------------------------------===*/
 
 #include <stdarg.h>   /* for va_*()       */
+#include <stddef.h>   /* for offsetof()   */
 #include <stdio.h>    /* for vsnprintf()  */
 #include <stdlib.h>   /* for exit()       */
 #include <string.h>   /* for memset()     */
@@ -177,6 +178,27 @@ static const struct InstructionSpecifier *specifierForUID(InstrUID uid) {
   return &INSTRUCTIONS_SYM[uid];
 }
 
+/*
+ * readByte - Reads the byte at address, from the instruction's buffer if it
+ *   has one and through the reader function otherwise.
+ *
+ * @param insn    - The instruction to read for.
+ * @param byte    - A pointer to the byte to be filled in.
+ * @param address - The address of the byte.
+ * @return        - 0 if the read was successful; nonzero otherwise.
+ */
+static int readByte(struct InternalInstruction* insn, uint8_t* byte,
+                    uint64_t address) {
+  if (insn->bytes) {
+    /* Addresses below bytesBase wrap around and fail the check too. */
+    if (address - insn->bytesBase >= insn->bytesSize)
+      return -1;
+    *byte = insn->bytes[address - insn->bytesBase];
+    return 0;
+  }
+  return insn->reader(insn->readerArg, byte, address);
+}
+
 /*
  * consumeByte - Uses the reader function provided by the user to consume one
  *   byte from the instruction's memory and advance the cursor.
@@ -188,7 +210,7 @@ static const struct InstructionSpecifier *specifierForUID(InstrUID uid) {
  * @return      - 0 if the read was successful; nonzero otherwise.
  */
 static int consumeByte(struct InternalInstruction* insn, uint8_t* byte) {
-  int ret = insn->reader(insn->readerArg, byte, insn->readerCursor);
+  int ret = readByte(insn, byte, insn->readerCursor);
 
   if (!ret)
     ++(insn->readerCursor);
@@ -204,7 +226,7 @@ static int consumeByte(struct InternalInstruction* insn, uint8_t* byte) {
  * @return      - See consumeByte().
  */
 static int lookAtByte(struct InternalInstruction* insn, uint8_t* byte) {
-  return insn->reader(insn->readerArg, byte, insn->readerCursor);
+  return readByte(insn, byte, insn->readerCursor);
 }
 
 static void unconsumeByte(struct InternalInstruction* insn) {
@@ -217,9 +239,9 @@ static void unconsumeByte(struct InternalInstruction* insn) {
     unsigned offset;                                              \
     for (offset = 0; offset < sizeof(type); ++offset) {           \
       uint8_t byte;                                               \
-      int ret = insn->reader(insn->readerArg,                     \
-                             &byte,                               \
-                             insn->readerCursor + offset);        \
+      int ret = readByte(insn,                                    \
+                         &byte,                                   \
+                         insn->readerCursor + offset);            \
       if (ret)                                                    \
         return ret;                                               \
       combined = combined | ((uint64_t)byte << (offset * 8));     \
@@ -1691,6 +1713,56 @@ static int readOperands(struct InternalInstruction* insn) {
   return 0;
 }
 
+/*
+ * readInstruction - Decodes the instruction at insn->startLocation once the
+ *   reader or the buffer of insn has been set up.
+ *
+ * @param insn    - The instruction to decode.
+ * @param miiArg  - See decodeInstruction().
+ * @return        - See decodeInstruction().
+ */
+static int readInstruction(struct InternalInstruction* insn,
+                           const void* miiArg) {
+  if (readPrefixes(insn)       ||
+      readOpcode(insn)         ||
+      getID(insn, miiArg)      ||
+      insn->instructionID == 0 ||
+      readOperands(insn))
+    return -1;
+
+  insn->operands = &x86OperandSets[insn->spec->operands][0];
+
+  insn->length = insn->readerCursor - insn->startLocation;
+
+  dbgprintf(insn, "Read from 0x%llx to 0x%llx: length %zu",
+            insn->startLocation, insn->readerCursor, insn->length);
+
+  if (insn->length > 15)
+    dbgprintf(insn, "Instruction exceeds 15-byte limit");
+
+  return 0;
+}
+
+/*
+ * initInstruction - Clears insn for decoding the instruction at startLoc.
+ *   prefixLocations is only read where prefixPresent is set, so it is left
+ *   alone rather than cleared for every instruction.
+ */
+static void initInstruction(struct InternalInstruction* insn,
+                            dlog_t logger,
+                            void* loggerArg,
+                            uint64_t startLoc,
+                            DisassemblerMode mode) {
+  memset(insn, 0, offsetof(struct InternalInstruction, prefixLocations));
+
+  insn->dlog = logger;
+  insn->dlogArg = loggerArg;
+  insn->startLocation = startLoc;
+  insn->readerCursor = startLoc;
+  insn->mode = mode;
+  insn->numImmediatesConsumed = 0;
+}
+
 /*
  * decodeInstruction - Reads and interprets a full instruction provided by the
  *   user.
@@ -1719,33 +1791,33 @@ int decodeInstruction(struct InternalInstruction* insn,
                       const void* miiArg,
                       uint64_t startLoc,
                       DisassemblerMode mode) {
-  memset(insn, 0, sizeof(struct InternalInstruction));
-
+  initInstruction(insn, logger, loggerArg, startLoc, mode);
   insn->reader = reader;
   insn->readerArg = readerArg;
-  insn->dlog = logger;
-  insn->dlogArg = loggerArg;
-  insn->startLocation = startLoc;
-  insn->readerCursor = startLoc;
-  insn->mode = mode;
-  insn->numImmediatesConsumed = 0;
-
-  if (readPrefixes(insn)       ||
-      readOpcode(insn)         ||
-      getID(insn, miiArg)      ||
-      insn->instructionID == 0 ||
-      readOperands(insn))
-    return -1;
-
-  insn->operands = &x86OperandSets[insn->spec->operands][0];
-
-  insn->length = insn->readerCursor - insn->startLocation;
-
-  dbgprintf(insn, "Read from 0x%llx to 0x%llx: length %zu",
-            startLoc, insn->readerCursor, insn->length);
-
-  if (insn->length > 15)
-    dbgprintf(insn, "Instruction exceeds 15-byte limit");
+  return readInstruction(insn, miiArg);
+}
 
-  return 0;
+/*
+ * decodeInstructionFromBuffer - Like decodeInstruction, but reads the
+ *   instruction's bytes straight from a buffer.
+ *
+ * @param bytes     - The bytes to decode from.
+ * @param size      - The number of bytes in the buffer.
+ * @param base      - The address of the first byte in the buffer.
+ * @return          - See decodeInstruction().
+ */
+int decodeInstructionFromBuffer(struct InternalInstruction* insn,
+                                const uint8_t* bytes,
+                                uint64_t size,
+                                uint64_t base,
+                                dlog_t logger,
+                                void* loggerArg,
+                                const void* miiArg,
+                                uint64_t startLoc,
+                                DisassemblerMode mode) {
+  initInstruction(insn, logger, loggerArg, startLoc, mode);
+  insn->bytes = bytes;
+  insn->bytesBase = base;
+  insn->bytesSize = size;
+  return readInstruction(insn, miiArg);
 }
@@ -515,6 +515,11 @@ struct InternalInstruction {
   const void* readerArg;
   /* The address of the next byte to read via the reader */
   uint64_t readerCursor;
+  /* If not NULL, the bytes are read straight from this buffer instead of
+     through the reader; bytesBase is the address of its first byte */
+  const uint8_t* bytes;
+  uint64_t bytesBase;
+  uint64_t bytesSize;
 
   /* Logger interface (C) */
   dlog_t dlog;
@@ -534,8 +539,6 @@ struct InternalInstruction {
 
   /* 1 if the prefix byte corresponding to the entry is present; 0 if not */
   uint8_t prefixPresent[0x100];
-  /* contains the location (for use with the reader) of the prefix byte */
-  uint64_t prefixLocations[0x100];
   /* The value of the VEX/XOP prefix, if present */
   uint8_t vexXopPrefix[3];
   /* The length of the VEX prefix (0 if not present) */
@@ -629,6 +632,11 @@ struct InternalInstruction {
   SIBBase                       sibBase;
 
   const struct OperandSpecifier *operands;
+
+  /* contains the location (for use with the reader) of the prefix byte.  Only
+     meaningful where prefixPresent is set, so it is last and is not cleared
+     between instructions */
+  uint64_t prefixLocations[0x100];
 };
 
 /* decodeInstruction - Decode one instruction and store the decoding results in
@@ -656,6 +664,23 @@ int decodeInstruction(struct InternalInstruction* insn,
                       uint64_t startLoc,
                       DisassemblerMode mode);
 
+/* decodeInstructionFromBuffer - Like decodeInstruction, but reads the bytes
+ *   straight from a buffer instead of calling a reader for each of them.
+ * @param bytes     - The bytes to decode from.
+ * @param size      - The number of bytes in the buffer.
+ * @param base      - The address of the first byte in the buffer.
+ * @return          - See decodeInstruction().
+ */
+int decodeInstructionFromBuffer(struct InternalInstruction* insn,
+                                const uint8_t* bytes,
+                                uint64_t size,
+                                uint64_t base,
+                                dlog_t logger,
+                                void* loggerArg,
+                                const void* miiArg,
+                                uint64_t startLoc,
+                                DisassemblerMode mode);
+
 /* x86DisassemblerDebug - C-accessible function for printing a message to
  *   debugs()
  * @param file  - The name of the file printing the debug message.
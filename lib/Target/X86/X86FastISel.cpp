@@ -77,7 +77,8 @@ public:
 private:
   bool X86FastEmitCompare(const Value *LHS, const Value *RHS, EVT VT);
 
-  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR);
+  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR,
+                       bool Aligned = false);
 
   bool X86FastEmitStore(EVT VT, const Value *Val, const X86AddressMode &AM,
                         bool Aligned = false);
@@ -113,6 +114,8 @@ private:
   bool X86SelectFPExt(const Instruction *I);
   bool X86SelectFPTrunc(const Instruction *I);
 
+  bool X86SelectBitCast(const Instruction *I);
+
   bool X86VisitIntrinsicCall(const IntrinsicInst &I);
   bool X86SelectCall(const Instruction *I);
 
@@ -179,7 +182,7 @@ bool X86FastISel::isTypeLegal(Type *Ty, MVT &VT, bool AllowI1) {
 /// The address is either pre-computed, i.e. Ptr, or a GlobalAddress, i.e. GV.
 /// Return true and the result register by reference if it is possible.
 bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
-                                  unsigned &ResultReg) {
+                                  unsigned &ResultReg, bool Aligned) {
   // Get opcode and regclass of the output for the given load instruction.
   unsigned Opc = 0;
   const TargetRegisterClass *RC = NULL;
@@ -224,6 +227,30 @@ bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
   case MVT::f80:
     // No f80 support yet.
     return false;
+  case MVT::v4f32:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVAPSrm : X86::MOVAPSrm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVUPSrm : X86::MOVUPSrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v2f64:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVAPDrm : X86::MOVAPDrm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVUPDrm : X86::MOVUPDrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v4i32:
+  case MVT::v2i64:
+  case MVT::v8i16:
+  case MVT::v16i8:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVDQArm : X86::MOVDQArm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVDQUrm : X86::MOVDQUrm;
+    RC  = &X86::VR128RegClass;
+    break;
   }
 
   ResultReg = createResultReg(RC);
@@ -902,9 +929,13 @@ bool X86FastISel::X86SelectRet(const Instruction *I) {
 ///
 bool X86FastISel::X86SelectLoad(const Instruction *I)  {
   // Atomic loads need special handling.
-  if (cast<LoadInst>(I)->isAtomic())
+  const LoadInst *LI = cast<LoadInst>(I);
+  if (LI->isAtomic())
     return false;
 
+  unsigned LABIAlignment = TD.getABITypeAlignment(LI->getType());
+  bool Aligned = LI->getAlignment() == 0 || LI->getAlignment() >= LABIAlignment;
+
   MVT VT;
   if (!isTypeLegal(I->getType(), VT, /*AllowI1=*/true))
     return false;
@@ -914,7 +945,7 @@ bool X86FastISel::X86SelectLoad(const Instruction *I)  {
     return false;
 
   unsigned ResultReg = 0;
-  if (X86FastEmitLoad(VT, AM, ResultReg)) {
+  if (X86FastEmitLoad(VT, AM, ResultReg, Aligned)) {
     UpdateValueMap(I, ResultReg);
     return true;
   }
@@ -1487,22 +1518,58 @@ bool X86FastISel::X86SelectSelect(const Instruction *I) {
   if (!isTypeLegal(I->getType(), VT))
     return false;
 
-  // We only use cmov here, if we don't have a cmov instruction bail.
-  if (!Subtarget->hasCMov()) return false;
+  // Vector conditions select per element.
+  if (!I->getOperand(0)->getType()->isIntegerTy(1))
+    return false;
 
+  // Use cmov where there is one.  Everything else gets one of the CMOV_*
+  // pseudos, which ExpandISelPseudos turns into a branch sequence.
   unsigned Opc = 0;
   const TargetRegisterClass *RC = NULL;
-  if (VT == MVT::i16) {
-    Opc = X86::CMOVE16rr;
+  switch (VT.SimpleTy) {
+  default: return false;
+  case MVT::i8:
+    Opc = X86::CMOV_GR8;
+    RC = &X86::GR8RegClass;
+    break;
+  case MVT::i16:
+    Opc = Subtarget->hasCMov() ? X86::CMOVE16rr : X86::CMOV_GR16;
     RC = &X86::GR16RegClass;
-  } else if (VT == MVT::i32) {
-    Opc = X86::CMOVE32rr;
+    break;
+  case MVT::i32:
+    Opc = Subtarget->hasCMov() ? X86::CMOVE32rr : X86::CMOV_GR32;
     RC = &X86::GR32RegClass;
-  } else if (VT == MVT::i64) {
+    break;
+  case MVT::i64:
+    if (!Subtarget->hasCMov()) return false;
     Opc = X86::CMOVE64rr;
     RC = &X86::GR64RegClass;
-  } else {
-    return false;
+    break;
+  case MVT::f32:
+    if (!X86ScalarSSEf32) return false;
+    Opc = X86::CMOV_FR32;
+    RC = &X86::FR32RegClass;
+    break;
+  case MVT::f64:
+    if (!X86ScalarSSEf64) return false;
+    Opc = X86::CMOV_FR64;
+    RC = &X86::FR64RegClass;
+    break;
+  case MVT::v4f32:
+    Opc = X86::CMOV_V4F32;
+    RC = &X86::VR128RegClass;
+    break;
+  case MVT::v2f64:
+    Opc = X86::CMOV_V2F64;
+    RC = &X86::VR128RegClass;
+    break;
+  case MVT::v4i32:
+  case MVT::v2i64:
+  case MVT::v8i16:
+  case MVT::v16i8:
+    Opc = X86::CMOV_V2I64;
+    RC = &X86::VR128RegClass;
+    break;
   }
 
   unsigned Op0Reg = getRegForValue(I->getOperand(0));
@@ -1515,8 +1582,12 @@ bool X86FastISel::X86SelectSelect(const Instruction *I) {
   BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8rr))
     .addReg(Op0Reg).addReg(Op0Reg);
   unsigned ResultReg = createResultReg(RC);
-  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(Opc), ResultReg)
-    .addReg(Op1Reg).addReg(Op2Reg);
+  MachineInstrBuilder MIB =
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(Opc), ResultReg)
+      .addReg(Op1Reg).addReg(Op2Reg);
+  // The pseudos take the condition code as an operand.
+  if (TII.get(Opc).usesCustomInsertionHook())
+    MIB.addImm(X86::COND_E);
   UpdateValueMap(I, ResultReg);
   return true;
 }
@@ -1605,6 +1676,30 @@ bool X86FastISel::X86SelectTrunc(const Instruction *I) {
   return true;
 }
 
+/// X86SelectBitCast - Bitcasts between vector types that live in the same
+/// register class are plain copies, which the generic code does not know.
+bool X86FastISel::X86SelectBitCast(const Instruction *I) {
+  MVT SrcVT, DstVT;
+  if (!I->getType()->isVectorTy() ||
+      !isTypeLegal(I->getOperand(0)->getType(), SrcVT) ||
+      !isTypeLegal(I->getType(), DstVT))
+    return false;
+
+  const TargetRegisterClass *RC = TLI.getRegClassFor(DstVT);
+  if (TLI.getRegClassFor(SrcVT) != RC)
+    return false;
+
+  unsigned Reg = getRegForValue(I->getOperand(0));
+  if (Reg == 0)
+    return false;
+
+  unsigned ResultReg = createResultReg(RC);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
+          ResultReg).addReg(Reg);
+  UpdateValueMap(I, ResultReg);
+  return true;
+}
+
 bool X86FastISel::IsMemcpySmall(uint64_t Len) {
   return Len <= (Subtarget->is64Bit() ? 32 : 16);
 }
@@ -1678,6 +1773,20 @@ bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
 
     return DoSelectCall(&I, "memcpy");
   }
+  case Intrinsic::memmove: {
+    const MemMoveInst &MMI = cast<MemMoveInst>(I);
+    if (MMI.isVolatile())
+      return false;
+
+    unsigned SizeWidth = Subtarget->is64Bit() ? 64 : 32;
+    if (!MMI.getLength()->getType()->isIntegerTy(SizeWidth))
+      return false;
+
+    if (MMI.getSourceAddressSpace() > 255 || MMI.getDestAddressSpace() > 255)
+      return false;
+
+    return DoSelectCall(&I, "memmove");
+  }
   case Intrinsic::memset: {
     const MemSetInst &MSI = cast<MemSetInst>(I);
 
@@ -1856,8 +1965,10 @@ bool X86FastISel::X86SelectCall(const Instruction *I) {
   if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(CI))
     return X86VisitIntrinsicCall(*II);
 
-  // Allow SelectionDAG isel to handle tail calls.
-  if (cast<CallInst>(I)->isTailCall())
+  // Allow SelectionDAG isel to handle tail calls.  The tail marker is only
+  // a hint, so calls that cannot become tail calls are ordinary calls.
+  if (cast<CallInst>(I)->isTailCall() &&
+      isInTailCallPosition(ImmutableCallSite(CI), TLI))
     return false;
 
   return DoSelectCall(I, 0);
@@ -2346,6 +2457,8 @@ X86FastISel::TargetSelectInstruction(const Instruction *I)  {
     return X86SelectFPExt(I);
   case Instruction::FPTrunc:
     return X86SelectFPTrunc(I);
+  case Instruction::BitCast:
+    return X86SelectBitCast(I);
   case Instruction::IntToPtr: // Deliberate fall-through.
   case Instruction::PtrToInt: {
     EVT SrcVT = TLI.getValueType(I->getOperand(0)->getType());
@@ -2416,6 +2529,22 @@ unsigned X86FastISel::TargetMaterializeConstant(const Constant *C) {
   case MVT::f80:
     // No f80 support yet.
     return 0;
+  case MVT::v4f32:
+  case MVT::v2f64:
+  case MVT::v4i32:
+  case MVT::v2i64:
+  case MVT::v8i16:
+  case MVT::v16i8:
+    // Vector constants are loaded from an aligned constant pool entry.
+    Opc = Subtarget->hasAVX() ? X86::VMOVAPSrm : X86::MOVAPSrm;
+    RC  = &X86::VR128RegClass;
+    if (C->isNullValue()) {
+      unsigned ResultReg = createResultReg(RC);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::V_SET0),
+              ResultReg);
+      return ResultReg;
+    }
+    break;
   }
 
   // Materialize addresses with LEA instructions.
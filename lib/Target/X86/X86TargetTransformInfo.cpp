@@ -341,11 +341,72 @@ unsigned X86TTI::getArithmeticInstrCost(unsigned Opcode, Type *Ty,
 
 unsigned X86TTI::getShuffleCost(ShuffleKind Kind, Type *Tp, int Index,
                                 Type *SubTp) const {
-  // We only estimate the cost of reverse shuffles.
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(Tp);
+
+  if (Kind == SK_Alternate) {
+    // Alternating elements are a single blend on SSE4.1 and AVX.
+    static const CostTblEntry<MVT::SimpleValueType> AVX2AltShuffleTbl[] = {
+      { ISD::VECTOR_SHUFFLE, MVT::v4i64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v8i32, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v16i16, 1 },
+    };
+
+    static const CostTblEntry<MVT::SimpleValueType> AVX1AltShuffleTbl[] = {
+      { ISD::VECTOR_SHUFFLE, MVT::v4f64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v8f32, 1 },
+    };
+
+    static const CostTblEntry<MVT::SimpleValueType> SSE41AltShuffleTbl[] = {
+      { ISD::VECTOR_SHUFFLE, MVT::v2f64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v2i64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v4f32, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v4i32, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v8i16, 1 },
+    };
+
+    // Without blends, pairs are merged with movsd and quads with two shufps.
+    static const CostTblEntry<MVT::SimpleValueType> SSE2AltShuffleTbl[] = {
+      { ISD::VECTOR_SHUFFLE, MVT::v2f64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v2i64, 1 },
+      { ISD::VECTOR_SHUFFLE, MVT::v4f32, 2 },
+      { ISD::VECTOR_SHUFFLE, MVT::v4i32, 2 },
+    };
+
+    if (ST->hasAVX2()) {
+      int Idx = CostTableLookup(AVX2AltShuffleTbl, ISD::VECTOR_SHUFFLE,
+                                LT.second);
+      if (Idx != -1)
+        return LT.first * AVX2AltShuffleTbl[Idx].Cost;
+    }
+
+    if (ST->hasAVX()) {
+      int Idx = CostTableLookup(AVX1AltShuffleTbl, ISD::VECTOR_SHUFFLE,
+                                LT.second);
+      if (Idx != -1)
+        return LT.first * AVX1AltShuffleTbl[Idx].Cost;
+    }
+
+    if (ST->hasSSE41()) {
+      int Idx = CostTableLookup(SSE41AltShuffleTbl, ISD::VECTOR_SHUFFLE,
+                                LT.second);
+      if (Idx != -1)
+        return LT.first * SSE41AltShuffleTbl[Idx].Cost;
+    }
+
+    if (ST->hasSSE2()) {
+      int Idx = CostTableLookup(SSE2AltShuffleTbl, ISD::VECTOR_SHUFFLE,
+                                LT.second);
+      if (Idx != -1)
+        return LT.first * SSE2AltShuffleTbl[Idx].Cost;
+    }
+
+    return TargetTransformInfo::getShuffleCost(Kind, Tp, Index, SubTp);
+  }
+
+  // Otherwise we only estimate the cost of reverse shuffles.
   if (Kind != SK_Reverse)
     return TargetTransformInfo::getShuffleCost(Kind, Tp, Index, SubTp);
 
-  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(Tp);
   unsigned Cost = 1;
   if (LT.second.getSizeInBits() > 128)
     Cost = 3; // Extract + insert + copy.
@@ -0,0 +1,252 @@
+//===- HotColdSplitting.cpp - Outline cold regions of functions -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass uses block frequency information to find regions of a function
+// which are rarely executed (error handling, assertion failures, paths marked
+// unlikely through llvm.expect or branch weight metadata) and outlines them
+// into separate functions placed in a dedicated text section.  The hot part of
+// each function then shrinks and packs more densely in the instruction cache.
+//
+// A cold region is the subtree of the dominator tree rooted at a cold block,
+// provided every block in the subtree is cold as well.  Such a region has a
+// single entry, which is what the CodeExtractor requires.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "hotcoldsplit"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/CodeExtractor.h"
+using namespace llvm;
+
+STATISTIC(NumColdRegions, "Number of cold regions outlined");
+STATISTIC(NumColdBlocks, "Number of cold blocks moved out of hot functions");
+STATISTIC(NumColdInsts,
+          "Number of cold instructions moved out of hot functions");
+
+static cl::opt<unsigned>
+ColdFreqRatio("hotcoldsplit-cold-ratio", cl::init(16), cl::Hidden,
+              cl::desc("A block is cold if it runs at most 1/N times as "
+                       "often as the function entry"));
+
+static cl::opt<unsigned>
+MinColdRegionSize("hotcoldsplit-min-size", cl::init(4), cl::Hidden,
+                  cl::desc("Minimum number of instructions in a cold region "
+                           "for it to be worth outlining"));
+
+static cl::opt<std::string>
+ColdSectionName("hotcoldsplit-section", cl::init(".text.unlikely"),
+                cl::Hidden,
+                cl::desc("Section in which outlined cold code is placed"));
+
+namespace {
+  struct HotColdSplitting : public ModulePass {
+    static char ID; // Pass identification, replacement for typeid
+    HotColdSplitting() : ModulePass(ID) {
+      initializeHotColdSplittingPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequired<BlockFrequencyInfo>();
+    }
+
+    bool runOnModule(Module &M);
+
+  private:
+    typedef SmallVector<BasicBlock *, 8> BlockList;
+
+    bool isCold(const BasicBlock *BB, const BlockFrequencyInfo &BFI,
+                uint64_t EntryFreq) const;
+    bool collectColdRegion(DomTreeNode *Root, const BlockFrequencyInfo &BFI,
+                           uint64_t EntryFreq, BlockList &Region) const;
+    bool splitFunction(Function &F);
+  };
+}
+
+char HotColdSplitting::ID = 0;
+INITIALIZE_PASS_BEGIN(HotColdSplitting, "hotcoldsplit",
+                      "Hot/cold function splitting", false, false)
+INITIALIZE_PASS_DEPENDENCY(BlockFrequencyInfo)
+INITIALIZE_PASS_END(HotColdSplitting, "hotcoldsplit",
+                    "Hot/cold function splitting", false, false)
+
+ModulePass *llvm::createHotColdSplittingPass() {
+  return new HotColdSplitting();
+}
+
+/// isCold - Return true if BB executes at most 1/ColdFreqRatio times as often
+/// as the entry block of its function.
+bool HotColdSplitting::isCold(const BasicBlock *BB,
+                              const BlockFrequencyInfo &BFI,
+                              uint64_t EntryFreq) const {
+  uint64_t Freq = BFI.getBlockFreq(BB).getFrequency();
+  // Guard the multiplication below against overflow; anything this frequent
+  // is certainly not cold.
+  if (Freq > UINT64_MAX / ColdFreqRatio)
+    return false;
+  return Freq * ColdFreqRatio <= EntryFreq;
+}
+
+/// collectColdRegion - Gather the dominator subtree rooted at Root into Region.
+/// Return false if any block of the subtree is not cold, or cannot be moved to
+/// another function.
+bool HotColdSplitting::collectColdRegion(DomTreeNode *Root,
+                                         const BlockFrequencyInfo &BFI,
+                                         uint64_t EntryFreq,
+                                         BlockList &Region) const {
+  SmallVector<DomTreeNode *, 8> Worklist;
+  Worklist.push_back(Root);
+  while (!Worklist.empty()) {
+    DomTreeNode *N = Worklist.pop_back_val();
+    BasicBlock *BB = N->getBlock();
+    if (!isCold(BB, BFI, EntryFreq) || BB->isLandingPad())
+      return false;
+
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+      // These have to stay in the function they were written in.
+      if (isa<AllocaInst>(I) || isa<InvokeInst>(I) || isa<ResumeInst>(I) ||
+          isa<IndirectBrInst>(I))
+        return false;
+      if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(I))
+        if (II->getIntrinsicID() == Intrinsic::vastart ||
+            II->getIntrinsicID() == Intrinsic::vaend)
+          return false;
+    }
+
+    Region.push_back(BB);
+    Worklist.append(N->begin(), N->end());
+  }
+
+  // Every block but the header must only be entered from within the region.
+  // This only fails when unreachable code branches into the subtree.
+  SmallPtrSet<BasicBlock *, 8> InRegion(Region.begin(), Region.end());
+  for (unsigned i = 1, e = Region.size(); i != e; ++i)
+    for (pred_iterator PI = pred_begin(Region[i]), PE = pred_end(Region[i]);
+         PI != PE; ++PI)
+      if (!InRegion.count(*PI))
+        return false;
+  return true;
+}
+
+bool HotColdSplitting::splitFunction(Function &F) {
+  // Functions that are already cold as a whole belong in the cold section
+  // anyway; splitting them buys nothing.
+  if (F.hasFnAttribute(Attribute::Cold))
+    return false;
+
+  BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfo>(F);
+  uint64_t EntryFreq = BFI.getBlockFreq(&F.getEntryBlock()).getFrequency();
+
+  DominatorTree DT;
+  DT.runOnFunction(F);
+
+  // Walk the dominator tree top down.  The first cold block found on a path
+  // from the root is the candidate region header; if its whole subtree is
+  // cold, it is outlined as one region, otherwise keep looking below it.
+  std::vector<BlockList> Regions;
+  SmallVector<DomTreeNode *, 16> Worklist;
+  Worklist.push_back(DT.getRootNode());
+  while (!Worklist.empty()) {
+    DomTreeNode *N = Worklist.pop_back_val();
+    if (N != DT.getRootNode() && isCold(N->getBlock(), BFI, EntryFreq)) {
+      BlockList Region;
+      if (collectColdRegion(N, BFI, EntryFreq, Region)) {
+        Regions.push_back(Region);
+        continue;
+      }
+    }
+    Worklist.append(N->begin(), N->end());
+  }
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Regions.size(); i != e; ++i) {
+    BlockList &Region = Regions[i];
+
+    unsigned NumInsts = 0;
+    for (unsigned j = 0, je = Region.size(); j != je; ++j)
+      NumInsts += Region[j]->size();
+    if (NumInsts < MinColdRegionSize)
+      continue;
+
+    // A region that neither returns nor branches back into the hot code, such
+    // as a path ending in abort(), stays noreturn once outlined.
+    SmallPtrSet<BasicBlock *, 8> InRegion(Region.begin(), Region.end());
+    bool NoReturn = true;
+    for (unsigned j = 0, je = Region.size(); j != je && NoReturn; ++j) {
+      TerminatorInst *TI = Region[j]->getTerminator();
+      if (isa<ReturnInst>(TI))
+        NoReturn = false;
+      for (unsigned s = 0, se = TI->getNumSuccessors(); s != se; ++s)
+        if (!InRegion.count(TI->getSuccessor(s)))
+          NoReturn = false;
+    }
+
+    // Extraction rewrites the CFG, so the dominator tree is recomputed for
+    // each region.  The regions are disjoint subtrees, so the sets collected
+    // above stay valid.
+    DominatorTree RegionDT;
+    RegionDT.runOnFunction(F);
+    Function *Outlined = CodeExtractor(Region, &RegionDT).extractCodeRegion();
+    if (!Outlined)
+      continue;
+
+    DEBUG(dbgs() << "HotColdSplitting: outlined " << Region.size()
+                 << " cold blocks of " << F.getName() << " into "
+                 << Outlined->getName() << "\n");
+
+    Outlined->addFnAttr(Attribute::Cold);
+    Outlined->addFnAttr(Attribute::NoInline);
+    Outlined->addFnAttr(Attribute::OptimizeForSize);
+    if (!ColdSectionName.empty())
+      Outlined->setSection(ColdSectionName);
+
+    // The extractor ends the call block with a return; nothing executes after
+    // a noreturn call, so say so instead.
+    if (NoReturn) {
+      Outlined->setDoesNotReturn();
+      CallInst *CI = cast<CallInst>(*Outlined->use_begin());
+      CI->setDoesNotReturn();
+      BasicBlock *CallBB = CI->getParent();
+      CallBB->getTerminator()->eraseFromParent();
+      new UnreachableInst(F.getContext(), CallBB);
+    }
+
+    ++NumColdRegions;
+    NumColdBlocks += Region.size();
+    NumColdInsts += NumInsts;
+    Changed = true;
+  }
+
+  return Changed;
+}
+
+bool HotColdSplitting::runOnModule(Module &M) {
+  // Extraction adds new functions to the module; only visit the ones that
+  // existed beforehand.
+  std::vector<Function *> Worklist;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (!I->isDeclaration())
+      Worklist.push_back(I);
+
+  bool Changed = false;
+  for (unsigned i = 0, e = Worklist.size(); i != e; ++i)
+    Changed |= splitFunction(*Worklist[i]);
+  return Changed;
+}
@@ -50,6 +50,10 @@ UseGVNAfterVectorization("use-gvn-after-vectorization",
   cl::init(false), cl::Hidden,
   cl::desc("Run GVN instead of Early CSE after vectorization passes"));
 
+static cl::opt<bool>
+RunHotColdSplitting("hot-cold-split", cl::init(false), cl::Hidden,
+  cl::desc("Outline cold regions of functions into a separate section"));
+
 static cl::opt<bool> UseNewSROA("use-new-sroa",
   cl::init(true), cl::Hidden,
   cl::desc("Enable the new, experimental SROA pass"));
@@ -252,6 +256,11 @@ void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
     MPM.add(createCFGSimplificationPass());
   }
 
+  // Outline cold code once the function bodies have their final shape, so
+  // that the block frequencies reflect inlining and loop transformations.
+  if (RunHotColdSplitting && !DisableUnitAtATime)
+    MPM.add(createHotColdSplittingPass());
+
   if (!DisableUnitAtATime) {
     // FIXME: We shouldn't bother with this anymore.
     MPM.add(createStripDeadPrototypesPass()); // Get rid of dead prototypes
@@ -0,0 +1,257 @@
+//===- SampleProfile.cpp - Incorporate sampled branch profiles into the IR ===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass reads a textual profile of branch and call counts, typically
+// produced by post-processing the output of a sampling profiler such as perf,
+// and annotates the IR with it:
+//
+//  * Conditional branches and switches receive "branch_weights" metadata,
+//    which BranchProbabilityInfo, and through it block frequencies and
+//    MachineBlockPlacement, take in preference to static heuristics.
+//  * Direct calls receive a single-operand "branch_weights" node holding the
+//    number of times the call was executed.  The code generator uses these to
+//    lay out functions along hot call edges.
+//
+// Instructions are matched to profile records through the source line in
+// their debug location, so the input must be compiled with line tables.
+//
+// The profile format is line oriented.  Blank lines and lines starting with
+// '#' are ignored.  Every other line is one of:
+//
+//   function <name>
+//   branch <line> <count of successor 0> <count of successor 1> ...
+//   call <line> <callee name> <count>
+//
+// 'branch' and 'call' records belong to the nearest preceding 'function'.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "sample-profile"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <map>
+using namespace llvm;
+
+STATISTIC(NumBranchesAnnotated, "Number of branches annotated from a profile");
+STATISTIC(NumCallsAnnotated, "Number of calls annotated from a profile");
+
+static cl::opt<std::string>
+SampleProfileFile("sample-profile-file", cl::init(""),
+                  cl::value_desc("filename"),
+                  cl::desc("Profile file loaded by -sample-profile"),
+                  cl::Hidden);
+
+namespace {
+  /// FunctionProfile - The counts recorded for one function, keyed by source
+  /// line.
+  struct FunctionProfile {
+    DenseMap<unsigned, SmallVector<uint64_t, 2> > Branches;
+    std::map<std::pair<unsigned, std::string>, uint64_t> Calls;
+  };
+
+  class SampleProfileLoader : public FunctionPass {
+  public:
+    static char ID; // Pass identification, replacement for typeid
+
+    /// Read the profile from Name, or from -sample-profile-file when Name is
+    /// empty.
+    explicit SampleProfileLoader(StringRef Name = "")
+      : FunctionPass(ID),
+        Filename(Name.empty() ? SampleProfileFile : Name.str()) {
+      initializeSampleProfileLoaderPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool doInitialization(Module &M);
+    virtual bool runOnFunction(Function &F);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.setPreservesCFG();
+    }
+
+  private:
+    bool parseProfile(const MemoryBuffer &Buffer, LLVMContext &Ctx);
+    bool parseError(LLVMContext &Ctx, unsigned LineNo, const Twine &Msg) const;
+
+    std::string Filename;
+    StringMap<FunctionProfile> Profiles;
+  };
+}
+
+char SampleProfileLoader::ID = 0;
+INITIALIZE_PASS(SampleProfileLoader, "sample-profile",
+                "Annotate branch and call weights from a sampled profile",
+                false, false)
+
+FunctionPass *llvm::createSampleProfileLoaderPass(StringRef Name) {
+  return new SampleProfileLoader(Name);
+}
+
+/// parseError - A profile is only a hint, so a malformed one is reported as a
+/// warning and ignored as a whole.  Always returns false.
+bool SampleProfileLoader::parseError(LLVMContext &Ctx, unsigned LineNo,
+                                     const Twine &Msg) const {
+  Ctx.emitWarning(Filename + ":" + Twine(LineNo) + ": " + Msg +
+                  ", ignoring the profile");
+  return false;
+}
+
+/// parseProfile - Read the profile in Buffer into Profiles.  Returns false if
+/// it is malformed.
+bool SampleProfileLoader::parseProfile(const MemoryBuffer &Buffer,
+                                       LLVMContext &Ctx) {
+  SmallVector<StringRef, 16> Lines;
+  Buffer.getBuffer().split(Lines, "\n");
+
+  FunctionProfile *Current = 0;
+  for (unsigned i = 0, e = Lines.size(); i != e; ++i) {
+    unsigned LineNo = i + 1;
+    StringRef Line = Lines[i].trim();
+    if (Line.empty() || Line[0] == '#')
+      continue;
+
+    SmallVector<StringRef, 8> Fields;
+    SplitString(Line, Fields);
+
+    if (Fields[0] == "function") {
+      if (Fields.size() != 2)
+        return parseError(Ctx, LineNo, "expected 'function <name>'");
+      Current = &Profiles[Fields[1]];
+      continue;
+    }
+
+    if (!Current)
+      return parseError(Ctx, LineNo, "record outside of a function");
+
+    unsigned SrcLine;
+    if (Fields.size() < 2 || Fields[1].getAsInteger(10, SrcLine))
+      return parseError(Ctx, LineNo, "expected a source line number");
+
+    if (Fields[0] == "branch") {
+      if (Fields.size() < 4)
+        return parseError(Ctx, LineNo,
+                          "a branch needs at least two successor counts");
+      SmallVector<uint64_t, 2> &Counts = Current->Branches[SrcLine];
+      Counts.clear();
+      for (unsigned j = 2, je = Fields.size(); j != je; ++j) {
+        uint64_t Count;
+        if (Fields[j].getAsInteger(10, Count))
+          return parseError(Ctx, LineNo,
+                            "invalid branch count '" + Fields[j] + "'");
+        Counts.push_back(Count);
+      }
+    } else if (Fields[0] == "call") {
+      uint64_t Count;
+      if (Fields.size() != 4 || Fields[3].getAsInteger(10, Count))
+        return parseError(Ctx, LineNo,
+                          "expected 'call <line> <callee> <count>'");
+      Current->Calls[std::make_pair(SrcLine, Fields[2].str())] += Count;
+    } else {
+      return parseError(Ctx, LineNo, "unknown record '" + Fields[0] + "'");
+    }
+  }
+  return true;
+}
+
+bool SampleProfileLoader::doInitialization(Module &M) {
+  if (Filename.empty())
+    return false;
+
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(Filename, Buffer)) {
+    M.getContext().emitWarning("could not open profile file '" + Filename +
+                               "': " + EC.message() + ", ignoring it");
+    return false;
+  }
+  if (!parseProfile(*Buffer, M.getContext()))
+    Profiles.clear();
+  return false;
+}
+
+/// scaleWeights - Branch weights are 32-bit; scale a set of 64-bit counts down
+/// uniformly so the largest fits, preserving their ratios.
+static void scaleWeights(ArrayRef<uint64_t> Counts,
+                         SmallVectorImpl<uint32_t> &Weights) {
+  uint64_t Max = 0;
+  for (unsigned i = 0, e = Counts.size(); i != e; ++i)
+    Max = std::max(Max, Counts[i]);
+  uint64_t Scale = Max / UINT32_MAX + 1;
+  for (unsigned i = 0, e = Counts.size(); i != e; ++i)
+    Weights.push_back(Counts[i] / Scale);
+}
+
+bool SampleProfileLoader::runOnFunction(Function &F) {
+  StringMap<FunctionProfile>::iterator PI = Profiles.find(F.getName());
+  if (PI == Profiles.end())
+    return false;
+  const FunctionProfile &Profile = PI->getValue();
+
+  LLVMContext &Ctx = F.getContext();
+  MDBuilder MDB(Ctx);
+  bool Changed = false;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    TerminatorInst *TI = BB->getTerminator();
+    if ((isa<BranchInst>(TI) || isa<SwitchInst>(TI)) &&
+        TI->getNumSuccessors() > 1 && !TI->getDebugLoc().isUnknown()) {
+      DenseMap<unsigned, SmallVector<uint64_t, 2> >::const_iterator I =
+        Profile.Branches.find(TI->getDebugLoc().getLine());
+      if (I != Profile.Branches.end() &&
+          I->second.size() == TI->getNumSuccessors()) {
+        SmallVector<uint32_t, 2> Weights;
+        scaleWeights(I->second, Weights);
+        TI->setMetadata(LLVMContext::MD_prof,
+                        MDB.createBranchWeights(Weights));
+        ++NumBranchesAnnotated;
+        Changed = true;
+      }
+    }
+
+    for (BasicBlock::iterator II = BB->begin(), IE = BB->end(); II != IE;
+         ++II) {
+      CallInst *CI = dyn_cast<CallInst>(II);
+      if (!CI || CI->getDebugLoc().isUnknown())
+        continue;
+      Function *Callee = CI->getCalledFunction();
+      if (!Callee || Callee->isIntrinsic())
+        continue;
+
+      std::map<std::pair<unsigned, std::string>, uint64_t>::const_iterator I =
+        Profile.Calls.find(std::make_pair(CI->getDebugLoc().getLine(),
+                                          Callee->getName().str()));
+      if (I == Profile.Calls.end())
+        continue;
+
+      SmallVector<uint32_t, 1> Weights;
+      scaleWeights(I->second, Weights);
+      CI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(Weights));
+      ++NumCallsAnnotated;
+      Changed = true;
+    }
+  }
+
+  DEBUG(if (Changed)
+          dbgs() << "SampleProfile: annotated " << F.getName() << "\n");
+  return Changed;
+}
@@ -0,0 +1,229 @@
+//===- SplitModule.cpp - Split a module into partitions -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ModuleSplitter class, which divides the function
+// definitions of a module into partitions for separate code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "split-module"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace llvm;
+
+namespace {
+  /// SizeOrder - Order functions by decreasing size, and by their position
+  /// in the module among functions of equal size.
+  struct SizeOrder {
+    bool operator()(const std::pair<unsigned, unsigned> &A,
+                    const std::pair<unsigned, unsigned> &B) const {
+      if (A.first != B.first)
+        return A.first > B.first;
+      return A.second < B.second;
+    }
+  };
+}
+
+/// getFunctionSize - Return the number of instructions in F.
+static unsigned getFunctionSize(const Function &F) {
+  unsigned Size = 0;
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    Size += BB->size();
+  return Size;
+}
+
+/// nameUnnamedGlobal - Unnamed globals get a different name in every object
+/// file, so they could not be referenced across partitions.
+static void nameUnnamedGlobal(GlobalValue *GV) {
+  if (!GV->hasName())
+    GV->setName("__llvm_split");
+}
+
+ModuleSplitter::ModuleSplitter(Module &M, unsigned N)
+  : NumPartitions(N ? N : 1) {
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    nameUnnamedGlobal(I);
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    nameUnnamedGlobal(I);
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I)
+    nameUnnamedGlobal(I);
+
+  // The target of an alias has to be defined in the same object file as the
+  // alias, so such functions stay in partition 0 with the aliases.
+  SmallPtrSet<const Function *, 8> Pinned;
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I)
+    if (const Function *F =
+            dyn_cast_or_null<Function>(I->resolveAliasedGlobal(false)))
+      Pinned.insert(F);
+
+  // Hand out the remaining functions greedily, largest first, each one to
+  // the partition with the least code so far.
+  std::vector<unsigned> Load(NumPartitions, 0);
+  std::vector<Function *> Functions;
+  std::vector<std::pair<unsigned, unsigned> > Order;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
+    if (I->isDeclaration())
+      continue;
+    unsigned Size = getFunctionSize(*I);
+    if (Pinned.count(I)) {
+      FunctionPartition[I->getName()] = 0;
+      Load[0] += Size;
+      continue;
+    }
+    Order.push_back(std::make_pair(Size, (unsigned)Functions.size()));
+    Functions.push_back(I);
+  }
+  std::sort(Order.begin(), Order.end(), SizeOrder());
+
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    unsigned P = std::min_element(Load.begin(), Load.end()) - Load.begin();
+    FunctionPartition[Functions[Order[i].second]->getName()] = P;
+    Load[P] += Order[i].first;
+  }
+
+  DEBUG(for (unsigned P = 0; P != NumPartitions; ++P)
+          dbgs() << "SplitModule: partition " << P << " has " << Load[P]
+                 << " instructions\n");
+
+  // Give local symbols that are referenced from another partition external
+  // linkage.  They stay hidden, so they do not escape the linked image.
+  SmallVector<GlobalValue *, 16> Locals;
+  for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I)
+    if (I->hasLocalLinkage())
+      Locals.push_back(I);
+  for (Module::global_iterator I = M.global_begin(), E = M.global_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage())
+      Locals.push_back(I);
+  for (Module::alias_iterator I = M.alias_begin(), E = M.alias_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage())
+      Locals.push_back(I);
+
+  for (unsigned i = 0, e = Locals.size(); i != e; ++i) {
+    GlobalValue *GV = Locals[i];
+    unsigned Home = 0;
+    if (Function *F = dyn_cast<Function>(GV))
+      if (!F->isDeclaration())
+        Home = getPartition(F);
+
+    // Walk the users, looking through constant expressions, and check which
+    // partitions they end up in.
+    bool External = false;
+    SmallVector<const Value *, 8> Worklist;
+    SmallPtrSet<const Value *, 8> Visited;
+    Worklist.push_back(GV);
+    while (!Worklist.empty() && !External) {
+      const Value *V = Worklist.pop_back_val();
+      for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+           UI != UE; ++UI) {
+        const User *U = *UI;
+        unsigned UserPartition;
+        if (const Instruction *Inst = dyn_cast<Instruction>(U)) {
+          UserPartition = getPartition(Inst->getParent()->getParent());
+        } else if (isa<GlobalValue>(U)) {
+          // Initializers of global variables and aliasees.
+          UserPartition = 0;
+        } else if (isa<Constant>(U)) {
+          if (Visited.insert(U))
+            Worklist.push_back(U);
+          continue;
+        } else {
+          External = true;
+          break;
+        }
+        if (UserPartition != Home) {
+          External = true;
+          break;
+        }
+      }
+    }
+
+    if (External) {
+      DEBUG(dbgs() << "SplitModule: externalizing " << GV->getName() << "\n");
+      GV->setLinkage(GlobalValue::ExternalLinkage);
+      GV->setVisibility(GlobalValue::HiddenVisibility);
+    }
+  }
+}
+
+unsigned ModuleSplitter::getPartition(const Function *F) const {
+  StringMap<unsigned>::const_iterator I = FunctionPartition.find(F->getName());
+  assert(I != FunctionPartition.end() && "Function was not partitioned!");
+  return I->getValue();
+}
+
+void ModuleSplitter::extractPartition(Module &M, unsigned I) const {
+  // Local functions of other partitions are only used there, so they can go
+  // once the bodies are gone.
+  SmallVector<Function *, 16> DeadLocals;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration() || getPartition(F) == I)
+      continue;
+    if (F->hasLocalLinkage())
+      DeadLocals.push_back(F);
+    F->deleteBody();
+  }
+  for (unsigned i = 0, e = DeadLocals.size(); i != e; ++i)
+    if (DeadLocals[i]->use_empty())
+      DeadLocals[i]->eraseFromParent();
+
+  if (I == 0)
+    return;
+
+  // Everything but functions is defined by partition 0.
+  M.setModuleInlineAsm("");
+
+  for (Module::alias_iterator GA = M.alias_begin(), E = M.alias_end();
+       GA != E;) {
+    GlobalAlias *Alias = GA++;
+    Type *Ty = cast<PointerType>(Alias->getType())->getElementType();
+    GlobalValue *Decl;
+    if (FunctionType *FTy = dyn_cast<FunctionType>(Ty))
+      Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", &M);
+    else
+      Decl = new GlobalVariable(M, Ty, false, GlobalValue::ExternalLinkage, 0,
+                                "", 0, GlobalVariable::NotThreadLocal,
+                                Alias->getType()->getAddressSpace());
+    Decl->setVisibility(Alias->getVisibility());
+    Decl->takeName(Alias);
+    Alias->replaceAllUsesWith(Decl);
+    Alias->eraseFromParent();
+  }
+
+  SmallVector<GlobalVariable *, 16> DeadVars;
+  for (Module::global_iterator GV = M.global_begin(), E = M.global_end();
+       GV != E; ++GV) {
+    if (GV->isDeclaration())
+      continue;
+    // Special variables such as llvm.used and llvm.global_ctors are only
+    // needed once, and so are local variables that were not externalized.
+    if (GV->hasLocalLinkage() || GV->getName().startswith("llvm."))
+      DeadVars.push_back(GV);
+    GV->setInitializer(0);
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+  }
+  for (unsigned i = 0, e = DeadVars.size(); i != e; ++i)
+    if (DeadVars[i]->use_empty())
+      DeadVars[i]->eraseFromParent();
+}
@@ -113,6 +113,19 @@ TinyTripCountVectorThreshold("vectorizer-min-trip-count", cl::init(16),
                                       "trip count that is smaller than this "
                                       "value."));
 
+static cl::opt<bool>
+EnablePredicatedMemAccesses("enable-predicated-mem-accesses", cl::init(true),
+                            cl::Hidden,
+                            cl::desc("Enable vectorization of loads and stores "
+                                     "in conditional blocks by predicating "
+                                     "them."));
+
+static cl::opt<bool>
+EnableInterleavedMemAccesses("enable-interleaved-mem-accesses", cl::init(true),
+                             cl::Hidden,
+                             cl::desc("Enable vectorization of interleaved "
+                                      "(strided) loads and stores."));
+
 /// We don't unroll loops with a known constant trip count below this number.
 static const unsigned TinyTripCountUnrollThreshold = 128;
 
@@ -126,6 +139,9 @@ static const unsigned MaxVectorWidth = 64;
 /// Maximum vectorization unroll count.
 static const unsigned MaxUnrollFactor = 16;
 
+/// Maximum stride, in elements, of an interleaved access group.
+static const unsigned MaxInterleaveFactor = 4;
+
 /// The cost of a loop that is considered 'small' by the unroller.
 static const unsigned SmallLoopCost = 20;
 
@@ -224,13 +240,32 @@ protected:
   void updateAnalysis();
 
   /// This instruction is un-vectorizable. Implement it as a sequence
-  /// of scalars.
-  virtual void scalarizeInstruction(Instruction *Instr);
+  /// of scalars. If \p IfPredicateMemOp is set, the instruction is a load or
+  /// store that may only execute when its block does, and each scalar copy is
+  /// guarded by a branch on its lane of the block mask.
+  virtual void scalarizeInstruction(Instruction *Instr,
+                                    bool IfPredicateMemOp = false);
+
+  /// Split the vector loop body at the insertion point so that the code
+  /// emitted next only executes if the i1 value \p Cmp is true.
+  /// \return the new conditional block.
+  BasicBlock *createPredicatedBlock(Value *Cmp);
+
+  /// End the conditional block \p CondBlock created by createPredicatedBlock
+  /// and continue emitting code in a new block that both paths branch to.
+  /// \return the new block.
+  BasicBlock *closePredicatedBlock(BasicBlock *CondBlock, Value *Cmp);
 
   /// Vectorize Load and Store instructions,
   virtual void vectorizeMemoryInstruction(Instruction *Instr,
                                   LoopVectorizationLegality *Legal);
 
+  /// Vectorize the interleave group of the load or store \p Instr as one wide
+  /// access per part plus shuffles. Emits the whole group when \p Instr is
+  /// its insert position and nothing for the other members.
+  void vectorizeInterleaveGroup(Instruction *Instr,
+                                LoopVectorizationLegality *Legal);
+
   /// Create a broadcast instruction. This method generates a broadcast
   /// instruction (shuffle) for loop invariant values and for the induction
   /// value. If this is the induction variable then we extend it to N, N+1, ...
@@ -328,8 +363,9 @@ protected:
   BasicBlock *LoopMiddleBlock;
   ///The ExitBlock of the scalar loop.
   BasicBlock *LoopExitBlock;
-  ///The vector loop body.
-  BasicBlock *LoopVectorBody;
+  ///The vector loop body. Predicated loads and stores split it into several
+  ///blocks; the first one is the loop header and the last one the latch.
+  SmallVector<BasicBlock *, 4> LoopVectorBody;
   ///The scalar loop body.
   BasicBlock *LoopScalarBody;
   /// A list of all bypass blocks. The first block is the entry of the loop.
@@ -354,7 +390,8 @@ public:
     InnerLoopVectorizer(OrigLoop, SE, LI, DT, DL, TLI, 1, UnrollFactor) { }
 
 private:
-  virtual void scalarizeInstruction(Instruction *Instr);
+  virtual void scalarizeInstruction(Instruction *Instr,
+                                    bool IfPredicateMemOp = false);
   virtual void vectorizeMemoryInstruction(Instruction *Instr,
                                           LoopVectorizationLegality *Legal);
   virtual Value *getBroadcastInstrs(Value *V);
@@ -390,6 +427,13 @@ static void setDebugLocFromInst(IRBuilder<> &B, const Value *Ptr) {
     B.SetCurrentDebugLocation(DebugLoc());
 }
 
+/// Returns the pointer operand of the load or store \p I.
+static Value *getMemInstPointerOperand(Instruction *I) {
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    return LI->getPointerOperand();
+  return cast<StoreInst>(I)->getPointerOperand();
+}
+
 /// LoopVectorizationLegality checks if it is legal to vectorize a loop, and
 /// to what vectorization factor.
 /// This class does not look at the profitability of vectorization, only the
@@ -532,6 +576,30 @@ public:
   /// induction descriptor.
   typedef MapVector<PHINode*, InductionInfo> InductionList;
 
+  /// An interleave group is a set of loads, or a set of stores, that together
+  /// access every element of an array of Factor-element tuples, such as
+  /// a[2*i] and a[2*i+1]. All members have a stride of Factor elements and
+  /// member K accesses element K of each tuple. The group is vectorized as a
+  /// single wide access plus shuffles that (de)interleave the members.
+  struct InterleaveGroup {
+    InterleaveGroup() : Factor(0), InsertPos(0) {}
+    /// The stride in elements, which is also the number of members.
+    unsigned Factor;
+    /// The members, indexed by the tuple element they access.
+    SmallVector<Instruction*, 4> Members;
+    /// The member at whose position the whole group is emitted: the first
+    /// load or the last store in program order.
+    Instruction *InsertPos;
+
+    /// Returns the index of the member \p I within its tuple.
+    unsigned getIndex(const Instruction *I) const {
+      for (unsigned i = 0; i < Factor; ++i)
+        if (Members[i] == I)
+          return i;
+      llvm_unreachable("Not a member of the interleave group");
+    }
+  };
+
   /// Returns true if it is legal to vectorize this loop.
   /// This does not mean that it is profitable to vectorize this
   /// loop, only that it is legal to do so.
@@ -581,6 +649,19 @@ public:
 
   unsigned getMaxSafeDepDistBytes() { return MaxSafeDepDistBytes; }
 
+  /// Returns true if the load or store \p I is in a conditional block and has
+  /// to be predicated instead of executing unconditionally.
+  bool isMaskRequired(const Instruction *I) { return MaskedOp.count(I); }
+
+  /// Returns the interleave group that the load or store \p I belongs to, or
+  /// null if it is not part of one.
+  const InterleaveGroup *getInterleaveGroup(Instruction *I) {
+    DenseMap<Instruction*, unsigned>::iterator It = InterleaveMembers.find(I);
+    if (It == InterleaveMembers.end())
+      return 0;
+    return &InterleaveGroups[It->second];
+  }
+
 private:
   /// Check if a single basic block loop is vectorizable.
   /// At this point we know that this is a loop with a constant trip count
@@ -593,6 +674,15 @@ private:
   /// Returns true if the loop is vectorizable
   bool canVectorizeMemory();
 
+  /// Find the groups of strided loads and stores that can be vectorized as
+  /// interleaved wide accesses. This must only be called once the memory
+  /// dependences of the loop are known to be safe.
+  void collectInterleaveGroups();
+
+  /// Returns true if the memory accesses \p A and \p B can be swapped within
+  /// one iteration of the loop without changing its result.
+  bool canReorderMemAccesses(Instruction *A, Instruction *B);
+
   /// Return true if we can vectorize this loop using the IF-conversion
   /// transformation.
   bool canVectorizeWithIfConvert();
@@ -661,6 +751,15 @@ private:
   bool HasFunNoNaNAttr;
 
   unsigned MaxSafeDepDistBytes;
+
+  /// Holds the loads and stores in conditional blocks that must not execute
+  /// for the iterations in which their block does not.
+  SmallPtrSet<const Instruction*, 8> MaskedOp;
+
+  /// Holds the interleave groups found in the loop.
+  SmallVector<InterleaveGroup, 4> InterleaveGroups;
+  /// Maps each member of an interleave group to the group's index.
+  DenseMap<Instruction*, unsigned> InterleaveMembers;
 };
 
 /// LoopVectorizationCostModel - estimates the expected speedups due to
@@ -1029,7 +1128,10 @@ LoopVectorizationLegality::RuntimePointerCheck::insert(ScalarEvolution *SE,
 Value *InnerLoopVectorizer::getBroadcastInstrs(Value *V) {
   // We need to place the broadcast of invariant variables outside the loop.
   Instruction *Instr = dyn_cast<Instruction>(V);
-  bool NewInstr = (Instr && Instr->getParent() == LoopVectorBody);
+  bool NewInstr = (Instr && std::find(LoopVectorBody.begin(),
+                                      LoopVectorBody.end(),
+                                      Instr->getParent()) !=
+                   LoopVectorBody.end());
   bool Invariant = OrigLoop->isLoopInvariant(V) && !NewInstr;
 
   // Place the code for broadcasting invariant variables in the new preheader.
@@ -1165,8 +1267,130 @@ Value *InnerLoopVectorizer::reverseVector(Value *Vec) {
 }
 
 
+/// \brief Concatenate two vectors. The second vector may be shorter than the
+/// first one and is padded with undef elements.
+static Value *concatenateTwoVectors(IRBuilder<> &Builder, Value *V1,
+                                    Value *V2) {
+  unsigned NumElts1 = V1->getType()->getVectorNumElements();
+  unsigned NumElts2 = V2->getType()->getVectorNumElements();
+  assert(NumElts1 >= NumElts2 && "Unexpected vector lengths");
+
+  if (NumElts1 > NumElts2) {
+    SmallVector<Constant*, 16> Mask;
+    for (unsigned i = 0; i < NumElts2; ++i)
+      Mask.push_back(Builder.getInt32(i));
+    Constant *Undef = UndefValue::get(Builder.getInt32Ty());
+    Mask.append(NumElts1 - NumElts2, Undef);
+    V2 = Builder.CreateShuffleVector(V2, UndefValue::get(V2->getType()),
+                                     ConstantVector::get(Mask));
+  }
+
+  SmallVector<Constant*, 16> Mask;
+  for (unsigned i = 0; i < NumElts1 + NumElts2; ++i)
+    Mask.push_back(Builder.getInt32(i));
+  return Builder.CreateShuffleVector(V1, V2, ConstantVector::get(Mask));
+}
+
+/// \brief Concatenate the vectors in \p Vecs, which all have the same type.
+static Value *concatenateVectors(IRBuilder<> &Builder, ArrayRef<Value*> Vecs) {
+  SmallVector<Value*, 8> List(Vecs.begin(), Vecs.end());
+  while (List.size() > 1) {
+    SmallVector<Value*, 8> Next;
+    for (unsigned i = 0, e = List.size(); i + 1 < e; i += 2)
+      Next.push_back(concatenateTwoVectors(Builder, List[i], List[i + 1]));
+    if (List.size() % 2)
+      Next.push_back(List.back());
+    List.swap(Next);
+  }
+  return List[0];
+}
+
+void InnerLoopVectorizer::vectorizeInterleaveGroup(Instruction *Instr,
+                                             LoopVectorizationLegality *Legal) {
+  const LoopVectorizationLegality::InterleaveGroup *Group =
+    Legal->getInterleaveGroup(Instr);
+  assert(Group && "Not an interleaved access");
+  if (Instr != Group->InsertPos)
+    return;
+
+  unsigned Factor = Group->Factor;
+  Instruction *Leader = Group->Members[0];
+  Value *Ptr = getMemInstPointerOperand(Instr);
+  Type *ScalarTy = Ptr->getType()->getPointerElementType();
+  Type *WideTy = VectorType::get(ScalarTy, Factor * VF);
+  unsigned AddressSpace = Ptr->getType()->getPointerAddressSpace();
+  // The wide access starts at the address of the first tuple element.
+  unsigned Alignment = isa<LoadInst>(Leader) ?
+    cast<LoadInst>(Leader)->getAlignment() :
+    cast<StoreInst>(Leader)->getAlignment();
+  if (!Alignment)
+    Alignment = DL->getABITypeAlignment(ScalarTy);
+
+  // Take the address of this member in the first lane and step back to the
+  // first element of its tuple.
+  setDebugLocFromInst(Builder, Ptr);
+  Value *TuplePtr = Builder.CreateExtractElement(getVectorValue(Ptr)[0],
+                                                 Builder.getInt32(0));
+  TuplePtr = Builder.CreateGEP(TuplePtr,
+                               Builder.getInt32(-(int)Group->getIndex(Instr)));
+
+  setDebugLocFromInst(Builder, Instr);
+  Constant *UndefWide = UndefValue::get(WideTy);
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    // Calculate the pointer for the specific unroll-part.
+    Value *PartPtr = Builder.CreateGEP(TuplePtr,
+                                       Builder.getInt32(Part * VF * Factor));
+    Value *VecPtr = Builder.CreateBitCast(PartPtr,
+                                          WideTy->getPointerTo(AddressSpace));
+
+    if (isa<LoadInst>(Instr)) {
+      // Load all tuples at once and pick out the elements of each member.
+      LoadInst *WideLoad = Builder.CreateLoad(VecPtr, "wide.vec");
+      WideLoad->setAlignment(Alignment);
+      for (unsigned i = 0; i < Factor; ++i) {
+        SmallVector<Constant*, 16> Mask;
+        for (unsigned j = 0; j < VF; ++j)
+          Mask.push_back(Builder.getInt32(i + j * Factor));
+        WidenMap.get(Group->Members[i])[Part] =
+          Builder.CreateShuffleVector(WideLoad, UndefWide,
+                                      ConstantVector::get(Mask),
+                                      "strided.vec");
+      }
+      continue;
+    }
+
+    // Concatenate the stored values of all members, interleave them and
+    // store all tuples at once.
+    SmallVector<Value*, 4> StoredVals;
+    for (unsigned i = 0; i < Factor; ++i) {
+      StoreInst *SI = cast<StoreInst>(Group->Members[i]);
+      StoredVals.push_back(getVectorValue(SI->getValueOperand())[Part]);
+    }
+    Value *Concat = concatenateVectors(Builder, StoredVals);
+
+    SmallVector<Constant*, 16> Mask;
+    for (unsigned j = 0; j < VF; ++j)
+      for (unsigned i = 0; i < Factor; ++i)
+        Mask.push_back(Builder.getInt32(i * VF + j));
+    Value *Interleaved =
+      Builder.CreateShuffleVector(Concat, UndefValue::get(Concat->getType()),
+                                  ConstantVector::get(Mask),
+                                  "interleaved.vec");
+    Builder.CreateStore(Interleaved, VecPtr)->setAlignment(Alignment);
+  }
+}
+
 void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
                                              LoopVectorizationLegality *Legal) {
+  // Interleaved accesses are emitted together with the rest of their group.
+  if (Legal->getInterleaveGroup(Instr))
+    return vectorizeInterleaveGroup(Instr, Legal);
+
+  // Accesses that may only execute when their block does are scalarized and
+  // predicated.
+  if (Legal->isMaskRequired(Instr))
+    return scalarizeInstruction(Instr, true);
+
   // Attempt to issue a wide load.
   LoadInst *LI = dyn_cast<LoadInst>(Instr);
   StoreInst *SI = dyn_cast<StoreInst>(Instr);
@@ -1299,11 +1523,47 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
   }
 }
 
-void InnerLoopVectorizer::scalarizeInstruction(Instruction *Instr) {
+BasicBlock *InnerLoopVectorizer::createPredicatedBlock(Value *Cmp) {
+  BasicBlock::iterator InsertPt = Builder.GetInsertPoint();
+  BasicBlock *CondBlock =
+    Builder.GetInsertBlock()->splitBasicBlock(InsertPt, "pred.if");
+  LI->getLoopFor(LoopVectorBody[0])->addBasicBlockToLoop(CondBlock,
+                                                         LI->getBase());
+  LoopVectorBody.push_back(CondBlock);
+  Builder.SetInsertPoint(InsertPt);
+  return CondBlock;
+}
+
+BasicBlock *InnerLoopVectorizer::closePredicatedBlock(BasicBlock *CondBlock,
+                                                      Value *Cmp) {
+  BasicBlock::iterator InsertPt = Builder.GetInsertPoint();
+  BasicBlock *ContBlock = CondBlock->splitBasicBlock(InsertPt,
+                                                     "pred.continue");
+  LI->getLoopFor(LoopVectorBody[0])->addBasicBlockToLoop(ContBlock,
+                                                         LI->getBase());
+  LoopVectorBody.push_back(ContBlock);
+  Builder.SetInsertPoint(InsertPt);
+
+  // Skip the conditional block if the condition is false.
+  BasicBlock *IfBlock = CondBlock->getSinglePredecessor();
+  Instruction *OldBr = IfBlock->getTerminator();
+  BranchInst::Create(CondBlock, ContBlock, Cmp, OldBr);
+  OldBr->eraseFromParent();
+  return ContBlock;
+}
+
+void InnerLoopVectorizer::scalarizeInstruction(Instruction *Instr,
+                                               bool IfPredicateMemOp) {
   assert(!Instr->getType()->isAggregateType() && "Can't handle vectors");
   // Holds vector parameters or scalars, in case of uniform vals.
   SmallVector<VectorParts, 4> Params;
 
+  // Predicated instructions only execute for the lanes in which their block
+  // does.
+  VectorParts Cond;
+  if (IfPredicateMemOp)
+    Cond = createBlockInMask(Instr->getParent());
+
   setDebugLocFromInst(Builder, Instr);
 
   // Find all of the vectorized parameters.
@@ -1348,6 +1608,15 @@ void InnerLoopVectorizer::scalarizeInstruction(Instruction *Instr) {
   for (unsigned Part = 0; Part < UF; ++Part) {
     // For each scalar that we create:
     for (unsigned Width = 0; Width < VF; ++Width) {
+      // Guard this lane with a branch on its bit of the mask.
+      Value *Cmp = 0;
+      BasicBlock *CondBlock = 0;
+      Value *PrevResult = VecResults[Part];
+      if (IfPredicateMemOp) {
+        Cmp = Builder.CreateExtractElement(Cond[Part], Builder.getInt32(Width));
+        CondBlock = createPredicatedBlock(Cmp);
+      }
+
       Instruction *Cloned = Instr->clone();
       if (!IsVoidRetTy)
         Cloned->setName(Instr->getName() + ".cloned");
@@ -1368,6 +1637,16 @@ void InnerLoopVectorizer::scalarizeInstruction(Instruction *Instr) {
       if (!IsVoidRetTy)
         VecResults[Part] = Builder.CreateInsertElement(VecResults[Part], Cloned,
                                                        Builder.getInt32(Width));
+
+      if (IfPredicateMemOp) {
+        closePredicatedBlock(CondBlock, Cmp);
+        if (!IsVoidRetTy) {
+          PHINode *Phi = Builder.CreatePHI(VecResults[Part]->getType(), 2);
+          Phi->addIncoming(PrevResult, CondBlock->getSinglePredecessor());
+          Phi->addIncoming(VecResults[Part], CondBlock);
+          VecResults[Part] = Phi;
+        }
+      }
     }
   }
 }
@@ -1783,7 +2062,7 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   LoopScalarPreHeader = ScalarPH;
   LoopMiddleBlock = MiddleBlock;
   LoopExitBlock = ExitBlock;
-  LoopVectorBody = VecBody;
+  LoopVectorBody.push_back(VecBody);
   LoopScalarBody = OldBasicBlock;
 }
 
@@ -2135,7 +2414,8 @@ InnerLoopVectorizer::vectorizeLoop(LoopVectorizationLegality *Legal) {
       // first unroll part.
       Value *StartVal = (part == 0) ? VectorStart : Identity;
       cast<PHINode>(VecRdxPhi[part])->addIncoming(StartVal, VecPreheader);
-      cast<PHINode>(VecRdxPhi[part])->addIncoming(Val[part], LoopVectorBody);
+      cast<PHINode>(VecRdxPhi[part])->addIncoming(Val[part],
+                                                  LoopVectorBody.back());
     }
 
     // Before each round, move the insertion point right between
@@ -2154,7 +2434,7 @@ InnerLoopVectorizer::vectorizeLoop(LoopVectorizationLegality *Legal) {
       Value *StartVal = (part == 0) ? VectorStart : Identity;
       for (unsigned I = 0, E = LoopBypassBlocks.size(); I != E; ++I)
         NewPhi->addIncoming(StartVal, LoopBypassBlocks[I]);
-      NewPhi->addIncoming(RdxExitVal[part], LoopVectorBody);
+      NewPhi->addIncoming(RdxExitVal[part], LoopVectorBody.back());
       RdxParts.push_back(NewPhi);
     }
 
@@ -2325,7 +2605,7 @@ void InnerLoopVectorizer::widenPHIInstruction(Instruction *PN,
       Type *VecTy = (VF == 1) ? PN->getType() :
       VectorType::get(PN->getType(), VF);
       Entry[part] = PHINode::Create(VecTy, 2, "vec.phi",
-                                    LoopVectorBody-> getFirstInsertionPt());
+                                    LoopVectorBody[0]->getFirstInsertionPt());
     }
     PV->push_back(P);
     return;
@@ -2676,7 +2956,12 @@ void InnerLoopVectorizer::updateAnalysis() {
   for (unsigned I = 1, E = LoopBypassBlocks.size(); I != E; ++I)
     DT->addNewBlock(LoopBypassBlocks[I], LoopBypassBlocks[I-1]);
   DT->addNewBlock(LoopVectorPreHeader, LoopBypassBlocks.back());
-  DT->addNewBlock(LoopVectorBody, LoopVectorPreHeader);
+  DT->addNewBlock(LoopVectorBody[0], LoopVectorPreHeader);
+  // Predicated loads and stores add pairs of blocks: a conditional block and
+  // the block where both paths join. Both are dominated by the block that
+  // branches to them.
+  for (unsigned I = 1, E = LoopVectorBody.size(); I != E; ++I)
+    DT->addNewBlock(LoopVectorBody[I], LoopVectorBody[I % 2 ? I - 1 : I - 2]);
   DT->addNewBlock(LoopMiddleBlock, LoopBypassBlocks.front());
   DT->addNewBlock(LoopScalarPreHeader, LoopMiddleBlock);
   DT->changeImmediateDominator(LoopScalarBody, LoopScalarPreHeader);
@@ -3483,13 +3768,33 @@ static int isStridedPtr(ScalarEvolution *SE, DataLayout *DL, Value *Ptr,
   // If the SCEV could wrap but we have an inbounds gep with a unit stride we
   // know we can't "wrap around the address space". In case of address space
   // zero we know that this won't happen without triggering undefined behavior.
-  if (!IsNoWrapAddRec && (IsInBoundsGEP || IsInAddressSpaceZero) &&
-      Stride != 1 && Stride != -1)
+  // An inbounds gep off a loop invariant base stays within a single object
+  // and so cannot wrap either. We rely on this for the strides of interleaved
+  // accesses such as a[2*i] and a[2*i+1].
+  bool IsInBoundsGEPOfInvariant = IsInBoundsGEP &&
+    EnableInterleavedMemAccesses && std::abs(Stride) <= MaxInterleaveFactor &&
+    SE->isLoopInvariant(
+      SE->getSCEV(cast<GetElementPtrInst>(Ptr)->getPointerOperand()), Lp);
+  if (!IsNoWrapAddRec && !IsInBoundsGEPOfInvariant &&
+      (IsInBoundsGEP || IsInAddressSpaceZero) && Stride != 1 && Stride != -1)
     return 0;
 
   return Stride;
 }
 
+/// \brief Check whether two accesses of \p TypeByteSize bytes, whose addresses
+/// both advance by \p StrideBytes every iteration and start \p Distance bytes
+/// apart, can never touch the same memory. This is the case for the members
+/// of an interleaved access such as a[2*i] and a[2*i+1].
+static bool isDisjointStridedAccess(int64_t Distance, uint64_t StrideBytes,
+                                    uint64_t TypeByteSize) {
+  int64_t Rem = Distance % (int64_t)StrideBytes;
+  if (Rem < 0)
+    Rem += StrideBytes;
+  return (uint64_t)Rem >= TypeByteSize &&
+    StrideBytes - (uint64_t)Rem >= TypeByteSize;
+}
+
 bool MemoryDepChecker::couldPreventStoreLoadForward(unsigned Distance,
                                                     unsigned TypeByteSize) {
   // If loads occur at a distance that is not a multiple of a feasible vector
@@ -3586,8 +3891,19 @@ bool MemoryDepChecker::isDependent(const MemAccessInfo &A, unsigned AIdx,
   Type *BTy = BPtr->getType()->getPointerElementType();
   unsigned TypeByteSize = DL->getTypeAllocSize(ATy);
 
-  // Negative distances are not plausible dependencies.
+  // Accesses with the same stride whose distance is not a multiple of that
+  // stride never overlap, e.g. a[2*i] and a[2*i+1].
   const APInt &Val = C->getValue()->getValue();
+  if (TypeByteSize == DL->getTypeAllocSize(BTy) &&
+      Val.getMinSignedBits() <= 64 &&
+      isDisjointStridedAccess(Val.getSExtValue(),
+                              std::abs(StrideAPtr) * TypeByteSize,
+                              TypeByteSize)) {
+    DEBUG(dbgs() << "LV: Strided accesses never overlap: NoDep\n");
+    return false;
+  }
+
+  // Negative distances are not plausible dependencies.
   if (Val.isNegative()) {
     bool IsTrueDataDependence = (AIsWrite && !BIsWrite);
     if (IsTrueDataDependence &&
@@ -3619,6 +3935,14 @@ bool MemoryDepChecker::isDependent(const MemAccessInfo &A, unsigned AIdx,
 
   unsigned Distance = (unsigned) Val.getZExtValue();
 
+  // The checks below and the VF limit taken from MaxSafeDepDistBytes count one
+  // element per iteration. For strided accesses only every Stride-th element
+  // is accessed, so turn the distance into whole iterations first: A[2*i+4] =
+  // A[2*i] is 16 bytes apart but only 2 iterations.
+  unsigned Stride = std::abs(StrideAPtr);
+  if (Stride > 1)
+    Distance = Distance / (Stride * TypeByteSize) * TypeByteSize;
+
   // Bail out early if passed-in parameters make vectorization not feasible.
   unsigned ForcedFactor = VectorizationFactor ? VectorizationFactor : 1;
   unsigned ForcedUnroll = VectorizationUnroll ? VectorizationUnroll : 1;
@@ -3757,6 +4081,7 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
   // care if the pointers are *restrict*.
   if (!Stores.size()) {
     DEBUG(dbgs() << "LV: Found a read-only loop!\n");
+    collectInterleaveGroups();
     return true;
   }
 
@@ -3873,9 +4198,173 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
   DEBUG(dbgs() << "LV: We" << (NeedRTCheck ? "" : " don't") <<
         " need a runtime memory check.\n");
 
+  if (CanVecMem)
+    collectInterleaveGroups();
+
   return CanVecMem;
 }
 
+bool LoopVectorizationLegality::canReorderMemAccesses(Instruction *A,
+                                                      Instruction *B) {
+  // Two reads are independent.
+  if (!A->mayWriteToMemory() && !B->mayWriteToMemory())
+    return true;
+
+  Value *APtr = getMemInstPointerOperand(A);
+  Value *BPtr = getMemInstPointerOperand(B);
+  const SCEVConstant *Dist =
+    dyn_cast<SCEVConstant>(SE->getMinusSCEV(SE->getSCEV(BPtr),
+                                            SE->getSCEV(APtr)));
+
+  // Accesses to different underlying objects are either known not to alias
+  // or covered by the runtime check. Accesses to the same object that could
+  // alias would have been rejected by the dependence checker.
+  if (!Dist)
+    return GetUnderlyingObject(APtr, DL) != GetUnderlyingObject(BPtr, DL);
+
+  int StrideA = isStridedPtr(SE, DL, APtr, TheLoop);
+  int StrideB = isStridedPtr(SE, DL, BPtr, TheLoop);
+  uint64_t TypeByteSize =
+    DL->getTypeAllocSize(APtr->getType()->getPointerElementType());
+  const APInt &Val = Dist->getValue()->getValue();
+  return StrideA && StrideA == StrideB &&
+    TypeByteSize ==
+      DL->getTypeAllocSize(BPtr->getType()->getPointerElementType()) &&
+    Val.getMinSignedBits() <= 64 &&
+    isDisjointStridedAccess(Val.getSExtValue(),
+                            std::abs(StrideA) * TypeByteSize, TypeByteSize);
+}
+
+void LoopVectorizationLegality::collectInterleaveGroups() {
+  if (!EnableInterleavedMemAccesses)
+    return;
+
+  // A candidate group holds its members, in program order, with their offsets
+  // in elements from the first member.
+  typedef SmallVector<std::pair<int64_t, Instruction*>, 4> Candidate;
+
+  for (Loop::block_iterator bb = TheLoop->block_begin(),
+       be = TheLoop->block_end(); bb != be; ++bb) {
+    // Accesses in predicated blocks must stay scalar.
+    if (blockNeedsPredication(*bb))
+      continue;
+
+    SmallVector<Candidate, 8> Candidates;
+    for (BasicBlock::iterator it = (*bb)->begin(), e = (*bb)->end(); it != e;
+         ++it) {
+      if (!isa<LoadInst>(it) && !isa<StoreInst>(it))
+        continue;
+
+      // The group is addressed through the scalarized GEP of a member, and
+      // the wide access must not contain padding between the elements.
+      Value *Ptr = getMemInstPointerOperand(it);
+      Type *Ty = Ptr->getType()->getPointerElementType();
+      if (!isa<GetElementPtrInst>(Ptr) || !Ty->isSized() ||
+          DL->getTypeAllocSizeInBits(Ty) != DL->getTypeSizeInBits(Ty))
+        continue;
+
+      const SCEVAddRecExpr *AR =
+        dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Ptr));
+      if (!AR || AR->getLoop() != TheLoop)
+        continue;
+      int Stride = isStridedPtr(SE, DL, Ptr, TheLoop);
+      if (Stride < 2 || Stride > (int)MaxInterleaveFactor)
+        continue;
+
+      // Join the first candidate group that this access fits into.
+      int64_t Size = DL->getTypeAllocSize(Ty);
+      bool Added = false;
+      for (unsigned i = 0, e = Candidates.size(); i != e && !Added; ++i) {
+        Candidate &C = Candidates[i];
+        Instruction *First = C[0].second;
+        Value *FirstPtr = getMemInstPointerOperand(First);
+        if (isa<StoreInst>(First) != isa<StoreInst>(it) ||
+            FirstPtr->getType() != Ptr->getType() ||
+            isStridedPtr(SE, DL, FirstPtr, TheLoop) != Stride)
+          continue;
+
+        const SCEVConstant *Dist =
+          dyn_cast<SCEVConstant>(SE->getMinusSCEV(AR, SE->getSCEV(FirstPtr)));
+        if (!Dist || Dist->getValue()->getValue().getMinSignedBits() > 64)
+          continue;
+        int64_t DistVal = Dist->getValue()->getSExtValue();
+        if (DistVal % Size)
+          continue;
+
+        // All members have to fit into one tuple, once each.
+        int64_t Offset = DistVal / Size;
+        int64_t Min = Offset, Max = Offset;
+        bool Duplicate = false;
+        for (unsigned j = 0, je = C.size(); j != je; ++j) {
+          Min = std::min(Min, C[j].first);
+          Max = std::max(Max, C[j].first);
+          Duplicate |= C[j].first == Offset;
+        }
+        if (Duplicate || Max - Min >= Stride)
+          continue;
+
+        C.push_back(std::make_pair(Offset, &*it));
+        Added = true;
+      }
+
+      if (!Added) {
+        Candidates.push_back(Candidate());
+        Candidates.back().push_back(std::make_pair(0, &*it));
+      }
+    }
+
+    for (unsigned i = 0, e = Candidates.size(); i != e; ++i) {
+      Candidate &C = Candidates[i];
+      unsigned Factor =
+        isStridedPtr(SE, DL, getMemInstPointerOperand(C[0].second), TheLoop);
+      // Only complete groups are vectorized; a gap would make the wide
+      // access touch memory that the loop does not.
+      if (C.size() != Factor)
+        continue;
+
+      InterleaveGroup G;
+      G.Factor = Factor;
+      G.Members.resize(Factor);
+      int64_t Min = C[0].first;
+      for (unsigned j = 1; j < Factor; ++j)
+        Min = std::min(Min, C[j].first);
+      for (unsigned j = 0; j < Factor; ++j)
+        G.Members[C[j].first - Min] = C[j].second;
+      bool IsLoad = isa<LoadInst>(C[0].second);
+      G.InsertPos = IsLoad ? C[0].second : C.back().second;
+
+      // Every member is moved to the insert position. Make sure this does
+      // not reorder it with a conflicting access.
+      bool CanReorder = true;
+      for (unsigned j = 0; j < Factor && CanReorder; ++j) {
+        Instruction *M = C[j].second;
+        if (M == G.InsertPos)
+          continue;
+        BasicBlock::iterator It = IsLoad ? G.InsertPos : M;
+        BasicBlock::iterator End = IsLoad ? M : G.InsertPos;
+        for (++It; It != End && CanReorder; ++It) {
+          if ((!isa<LoadInst>(It) && !isa<StoreInst>(It)) ||
+              std::find(G.Members.begin(), G.Members.end(), &*It) !=
+              G.Members.end())
+            continue;
+          CanReorder = canReorderMemAccesses(M, It);
+        }
+      }
+      if (!CanReorder) {
+        DEBUG(dbgs() << "LV: Can't move the members of the interleave group "
+              << "of " << *G.InsertPos << " together\n");
+        continue;
+      }
+
+      DEBUG(dbgs() << "LV: Found an interleave group of factor " << Factor
+            << " at " << *G.InsertPos << "\n");
+      for (unsigned j = 0; j < Factor; ++j)
+        InterleaveMembers[G.Members[j]] = InterleaveGroups.size();
+      InterleaveGroups.push_back(G);
+    }
+  }
+}
+
 static bool hasMultipleUsesOf(Instruction *I,
                               SmallPtrSet<Instruction *, 8> &Insts) {
   unsigned NumUses = 0;
@@ -4215,15 +4704,28 @@ bool LoopVectorizationLegality::blockNeedsPredication(BasicBlock *BB)  {
 bool LoopVectorizationLegality::blockCanBePredicated(BasicBlock *BB,
                                             SmallPtrSet<Value *, 8>& SafePtrs) {
   for (BasicBlock::iterator it = BB->begin(), e = BB->end(); it != e; ++it) {
-    // We might be able to hoist the load.
+    // We might be able to hoist the load. Otherwise it may fault and has to
+    // be predicated.
     if (it->mayReadFromMemory()) {
       LoadInst *LI = dyn_cast<LoadInst>(it);
-      if (!LI || !SafePtrs.count(LI->getPointerOperand()))
+      if (!LI)
         return false;
+      if (!SafePtrs.count(LI->getPointerOperand())) {
+        if (!EnablePredicatedMemAccesses)
+          return false;
+        MaskedOp.insert(LI);
+      }
     }
 
-    // We don't predicate stores at the moment.
-    if (it->mayWriteToMemory() || it->mayThrow())
+    // Stores are always predicated.
+    if (it->mayWriteToMemory()) {
+      if (!isa<StoreInst>(it) || !EnablePredicatedMemAccesses)
+        return false;
+      MaskedOp.insert(it);
+      continue;
+    }
+
+    if (it->mayThrow())
       return false;
 
     // The instructions below can trap.
@@ -4758,12 +5260,30 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
       return TTI.getAddressComputationCost(VectorTy) +
         TTI.getMemoryOpCost(I->getOpcode(), VectorTy, Alignment, AS);
 
+    // Interleaved loads/stores. The whole group is charged to the member at
+    // which it is emitted: one wide access plus the shuffles, estimated as
+    // Factor - 1 permutes per member.
+    if (const LoopVectorizationLegality::InterleaveGroup *Group =
+          Legal->getInterleaveGroup(I)) {
+      if (I != Group->InsertPos)
+        return 0;
+      unsigned Factor = Group->Factor;
+      Type *WideTy = VectorType::get(ValTy, VF * Factor);
+      unsigned Cost = TTI.getAddressComputationCost(WideTy);
+      Cost += TTI.getMemoryOpCost(I->getOpcode(), WideTy, Alignment, AS);
+      Cost += Factor * (Factor - 1) *
+        TTI.getShuffleCost(TargetTransformInfo::SK_Reverse, VectorTy, 0);
+      return Cost;
+    }
+
     // Scalarized loads/stores.
     int ConsecutiveStride = Legal->isConsecutivePtr(Ptr);
     bool Reverse = ConsecutiveStride < 0;
     unsigned ScalarAllocatedSize = DL->getTypeAllocSize(ValTy);
     unsigned VectorElementSize = DL->getTypeStoreSize(VectorTy)/VF;
-    if (!ConsecutiveStride || ScalarAllocatedSize != VectorElementSize) {
+    bool IsPredicated = Legal->isMaskRequired(I);
+    if (!ConsecutiveStride || ScalarAllocatedSize != VectorElementSize ||
+        IsPredicated) {
       bool IsComplexComputation =
         isLikelyComplexAddressComputation(Ptr, Legal, SE, TheLoop);
       unsigned Cost = 0;
@@ -4784,6 +5304,16 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
       Cost += VF * TTI.getAddressComputationCost(PtrTy, IsComplexComputation);
       Cost += VF * TTI.getMemoryOpCost(I->getOpcode(), ValTy->getScalarType(),
                                        Alignment, AS);
+
+      // Predicated accesses also extract each bit of the mask and branch on
+      // it.
+      if (IsPredicated) {
+        Type *MaskTy = ToVectorTy(Type::getInt1Ty(I->getContext()), VF);
+        for (unsigned i = 0; i < VF; ++i)
+          Cost += TTI.getVectorInstrCost(Instruction::ExtractElement, MaskTy,
+                                         i);
+        Cost += VF * TTI.getCFInstrCost(Instruction::Br);
+      }
       return Cost;
     }
 
@@ -4877,6 +5407,13 @@ namespace llvm {
 }
 
 bool LoopVectorizationCostModel::isConsecutiveLoadOrStore(Instruction *Inst) {
+  // Interleaved accesses are emitted as wide loads and stores, predicated
+  // ones are scalarized.
+  if (Legal->getInterleaveGroup(Inst))
+    return true;
+  if (Legal->isMaskRequired(Inst))
+    return false;
+
   // Check for a store.
   if (StoreInst *ST = dyn_cast<StoreInst>(Inst))
     return Legal->isConsecutivePtr(ST->getPointerOperand()) != 0;
@@ -4889,11 +5426,17 @@ bool LoopVectorizationCostModel::isConsecutiveLoadOrStore(Instruction *Inst) {
 }
 
 
-void InnerLoopUnroller::scalarizeInstruction(Instruction *Instr) {
+void InnerLoopUnroller::scalarizeInstruction(Instruction *Instr,
+                                             bool IfPredicateMemOp) {
   assert(!Instr->getType()->isAggregateType() && "Can't handle vectors");
   // Holds vector parameters or scalars, in case of uniform vals.
   SmallVector<VectorParts, 4> Params;
 
+  // Predicated instructions only execute when their block does.
+  VectorParts Cond;
+  if (IfPredicateMemOp)
+    Cond = createBlockInMask(Instr->getParent());
+
   setDebugLocFromInst(Builder, Instr);
 
   // Find all of the vectorized parameters.
@@ -4938,6 +5481,11 @@ void InnerLoopUnroller::scalarizeInstruction(Instruction *Instr) {
   for (unsigned Part = 0; Part < UF; ++Part) {
     // For each scalar that we create:
 
+    // Guard the copy with a branch on the block mask.
+    BasicBlock *CondBlock = 0;
+    if (IfPredicateMemOp)
+      CondBlock = createPredicatedBlock(Cond[Part]);
+
     Instruction *Cloned = Instr->clone();
       if (!IsVoidRetTy)
         Cloned->setName(Instr->getName() + ".cloned");
@@ -4954,13 +5502,23 @@ void InnerLoopUnroller::scalarizeInstruction(Instruction *Instr) {
       // so that future users will be able to use it.
       if (!IsVoidRetTy)
         VecResults[Part] = Cloned;
+
+      if (IfPredicateMemOp) {
+        closePredicatedBlock(CondBlock, Cond[Part]);
+        if (!IsVoidRetTy) {
+          PHINode *Phi = Builder.CreatePHI(Cloned->getType(), 2);
+          Phi->addIncoming(UndefVec, CondBlock->getSinglePredecessor());
+          Phi->addIncoming(Cloned, CondBlock);
+          VecResults[Part] = Phi;
+        }
+      }
   }
 }
 
 void
 InnerLoopUnroller::vectorizeMemoryInstruction(Instruction *Instr,
-                                              LoopVectorizationLegality*) {
-  return scalarizeInstruction(Instr);
+                                              LoopVectorizationLegality *Legal) {
+  return scalarizeInstruction(Instr, Legal->isMaskRequired(Instr));
 }
 
 Value *InnerLoopUnroller::reverseVector(Value *Vec) {
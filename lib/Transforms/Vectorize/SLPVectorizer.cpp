@@ -148,8 +148,40 @@ static bool isSplat(ArrayRef<Value *> VL) {
   return true;
 }
 
+/// \returns the opcode that can be paired with \p Op in an alternating
+/// bundle, such as add/sub, or zero.
+static unsigned getAltOpcode(unsigned Op) {
+  switch (Op) {
+  case Instruction::FAdd:
+    return Instruction::FSub;
+  case Instruction::FSub:
+    return Instruction::FAdd;
+  case Instruction::Add:
+    return Instruction::Sub;
+  case Instruction::Sub:
+    return Instruction::Add;
+  default:
+    return 0;
+  }
+}
+
+/// \returns True if the even lanes of \p VL all use the opcode \p Op and
+/// the odd lanes all use its alternate opcode.
+static bool isAltShuffle(ArrayRef<Value *> VL, unsigned Op) {
+  unsigned AltOp = getAltOpcode(Op);
+  if (!AltOp || VL.size() < 2)
+    return false;
+  for (int i = 0, e = VL.size(); i < e; i++) {
+    Instruction *I = dyn_cast<Instruction>(VL[i]);
+    if (!I || I->getOpcode() != (i & 1 ? AltOp : Op))
+      return false;
+  }
+  return true;
+}
+
 /// \returns The opcode if all of the Instructions in \p VL have the same
-/// opcode, or zero.
+/// opcode, ShuffleVector if they alternate between two opcodes that can be
+/// blended, such as add/sub, or zero.
 static unsigned getSameOpcode(ArrayRef<Value *> VL) {
   Instruction *I0 = dyn_cast<Instruction>(VL[0]);
   if (!I0)
@@ -157,8 +189,11 @@ static unsigned getSameOpcode(ArrayRef<Value *> VL) {
   unsigned Opcode = I0->getOpcode();
   for (int i = 1, e = VL.size(); i < e; i++) {
     Instruction *I = dyn_cast<Instruction>(VL[i]);
-    if (!I || Opcode != I->getOpcode())
+    if (!I || Opcode != I->getOpcode()) {
+      if (isAltShuffle(VL, Opcode))
+        return Instruction::ShuffleVector;
       return 0;
+    }
   }
   return Opcode;
 }
@@ -902,6 +937,22 @@ void BoUpSLP::buildTree_rec(ArrayRef<Value *> VL, unsigned Depth) {
       }
       return;
     }
+    case Instruction::ShuffleVector: {
+      // An alternating sequence such as add/sub is vectorized as one vector
+      // operation per opcode, blended together by a shuffle.
+      newTreeEntry(VL, true);
+      DEBUG(dbgs() << "SLP: added a ShuffleVector op.\n");
+
+      for (unsigned i = 0, e = VL0->getNumOperands(); i < e; ++i) {
+        ValueList Operands;
+        // Prepare the operand vector.
+        for (unsigned j = 0; j < VL.size(); ++j)
+          Operands.push_back(cast<Instruction>(VL[j])->getOperand(i));
+
+        buildTree_rec(Operands, Depth + 1);
+      }
+      return;
+    }
     case Instruction::Store: {
       // Check if the stores are consecutive or of we need to swizzle them.
       for (unsigned i = 0, e = VL.size() - 1; i < e; ++i)
@@ -950,7 +1001,7 @@ int BoUpSLP::getEntryCost(TreeEntry *E) {
   assert(getSameOpcode(VL) && getSameType(VL) && getSameBlock(VL) &&
          "Invalid VL");
   Instruction *VL0 = cast<Instruction>(VL[0]);
-  unsigned Opcode = VL0->getOpcode();
+  unsigned Opcode = getSameOpcode(VL);
   switch (Opcode) {
     case Instruction::PHI: {
       return 0;
@@ -1026,6 +1077,19 @@ int BoUpSLP::getEntryCost(TreeEntry *E) {
       int VecLdCost = TTI->getMemoryOpCost(Instruction::Load, ScalarTy, 1, 0);
       return VecLdCost - ScalarLdCost;
     }
+    case Instruction::ShuffleVector: {
+      unsigned Op0 = VL0->getOpcode();
+      unsigned Op1 = getAltOpcode(Op0);
+      int ScalarCost = 0;
+      for (unsigned i = 0, e = VL.size(); i < e; ++i)
+        ScalarCost += TTI->getArithmeticInstrCost(i & 1 ? Op1 : Op0, ScalarTy);
+      // Both vector operations are computed in full, then blended.
+      int VecCost = TTI->getArithmeticInstrCost(Op0, VecTy);
+      VecCost += TTI->getArithmeticInstrCost(Op1, VecTy);
+      VecCost += TTI->getShuffleCost(TargetTransformInfo::SK_Alternate, VecTy,
+                                     0);
+      return VecCost - ScalarCost;
+    }
     case Instruction::Store: {
       // We know that we can merge the stores. Calculate the cost.
       int ScalarStCost = VecTy->getNumElements() *
@@ -1306,8 +1370,8 @@ Value *BoUpSLP::vectorizeTree(TreeEntry *E) {
     return Gather(E->Scalars, VecTy);
   }
 
-  unsigned Opcode = VL0->getOpcode();
-  assert(Opcode == getSameOpcode(E->Scalars) && "Invalid opcode");
+  unsigned Opcode = getSameOpcode(E->Scalars);
+  assert(Opcode && "Invalid opcode");
 
   switch (Opcode) {
     case Instruction::PHI: {
@@ -1473,6 +1537,37 @@ Value *BoUpSLP::vectorizeTree(TreeEntry *E) {
       E->VectorizedValue = V;
       return V;
     }
+    case Instruction::ShuffleVector: {
+      ValueList LHSVL, RHSVL;
+      for (int i = 0, e = E->Scalars.size(); i < e; ++i) {
+        LHSVL.push_back(cast<Instruction>(E->Scalars[i])->getOperand(0));
+        RHSVL.push_back(cast<Instruction>(E->Scalars[i])->getOperand(1));
+      }
+      setInsertPointAfterBundle(E->Scalars);
+
+      Value *LHS = vectorizeTree(LHSVL);
+      Value *RHS = vectorizeTree(RHSVL);
+
+      if (Value *V = alreadyVectorized(E->Scalars))
+        return V;
+
+      // Compute both operations on all lanes: the even lanes are taken from
+      // the first and the odd lanes from the second.
+      unsigned Op0 = VL0->getOpcode();
+      Value *V0 = Builder.CreateBinOp(
+          static_cast<Instruction::BinaryOps>(Op0), LHS, RHS);
+      Value *V1 = Builder.CreateBinOp(
+          static_cast<Instruction::BinaryOps>(getAltOpcode(Op0)), LHS, RHS);
+
+      SmallVector<Constant *, 8> Mask;
+      unsigned e = E->Scalars.size();
+      for (unsigned i = 0; i < e; ++i)
+        Mask.push_back(Builder.getInt32(i & 1 ? e + i : i));
+
+      Value *V = Builder.CreateShuffleVector(V0, V1, ConstantVector::get(Mask));
+      E->VectorizedValue = V;
+      return V;
+    }
     case Instruction::Load: {
       // Loads are inserted at the head of the tree because we don't want to
       // sink them all the way down past store instructions.
@@ -1821,31 +1916,42 @@ bool SLPVectorizer::vectorizeStoreChain(ArrayRef<Value *> Chain,
   if (!isPowerOf2_32(Sz) || VF < 2)
     return false;
 
+  // Stores that were vectorized (and erased) by a wider tree.
+  SmallVector<bool, 16> Vectorized(ChainLen, false);
+
   bool Changed = false;
   // Look for profitable vectorizable trees at all offsets, starting at zero.
-  for (unsigned i = 0, e = ChainLen; i < e; ++i) {
-    if (i + VF > e)
-      break;
-    DEBUG(dbgs() << "SLP: Analyzing " << VF << " stores at offset " << i
-          << "\n");
-    ArrayRef<Value *> Operands = Chain.slice(i, VF);
+  // Whatever is left over, such as the tail of a chain of three stores, is
+  // retried with narrower vectors.
+  for (; VF >= 2; VF /= 2) {
+    for (unsigned i = 0, e = ChainLen; i < e; ++i) {
+      if (i + VF > e)
+        break;
+      if (std::find(Vectorized.begin() + i, Vectorized.begin() + i + VF,
+                    true) != Vectorized.begin() + i + VF)
+        continue;
+      DEBUG(dbgs() << "SLP: Analyzing " << VF << " stores at offset " << i
+            << "\n");
+      ArrayRef<Value *> Operands = Chain.slice(i, VF);
 
-    R.buildTree(Operands);
+      R.buildTree(Operands);
 
-    int Cost = R.getTreeCost();
+      int Cost = R.getTreeCost();
 
-    DEBUG(dbgs() << "SLP: Found cost=" << Cost << " for VF=" << VF << "\n");
-    if (Cost < CostThreshold) {
-      DEBUG(dbgs() << "SLP: Decided to vectorize cost=" << Cost << "\n");
-      R.vectorizeTree();
+      DEBUG(dbgs() << "SLP: Found cost=" << Cost << " for VF=" << VF << "\n");
+      if (Cost < CostThreshold) {
+        DEBUG(dbgs() << "SLP: Decided to vectorize cost=" << Cost << "\n");
+        R.vectorizeTree();
+        std::fill(Vectorized.begin() + i, Vectorized.begin() + i + VF, true);
 
-      // Move to the next bundle.
-      i += VF - 1;
-      Changed = true;
+        // Move to the next bundle.
+        i += VF - 1;
+        Changed = true;
+      }
     }
   }
 
-    return Changed;
+  return Changed;
 }
 
 bool SLPVectorizer::vectorizeStores(ArrayRef<StoreInst *> Stores,
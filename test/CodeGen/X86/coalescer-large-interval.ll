@@ -0,0 +1,333 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -verify-coalescing \
+; RUN:   -large-interval-size-threshold=4 -large-interval-freq-threshold=3 | FileCheck %s
+;
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -verify-coalescing \
+; RUN:   -print-after=simple-register-coalescing -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -verify-coalescing \
+; RUN:   -large-interval-size-threshold=4 -large-interval-freq-threshold=3 \
+; RUN:   -print-after=simple-register-coalescing -o /dev/null 2>&1 \
+; RUN:   | FileCheck %s -check-prefix=SMALL
+;
+; A scan limit of 0 makes every trim after an erased copy fall back to
+; recomputing the live range, which must give the same code.
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -verify-coalescing \
+; RUN:   -large-interval-size-threshold=4 -large-interval-freq-threshold=3 \
+; RUN:   -coalescer-max-shrink-scan=0 | FileCheck %s -check-prefix=FALLBACK
+;
+; The PHI collects one value per switch case, so its interval keeps growing
+; as the copies feeding it are joined.  After a few joins the coalescer stops
+; growing it; the remaining copies must still produce valid code.
+
+; CHECK-LABEL: f:
+; CHECK: callq use
+; CHECK: ret
+
+declare void @use(i64)
+
+define i64 @f(i64 %x, i64 %y, i32 %s) {
+entry:
+  switch i32 %s, label %def [
+    i32 0, label %c0
+    i32 1, label %c1
+    i32 2, label %c2
+    i32 3, label %c3
+    i32 4, label %c4
+    i32 5, label %c5
+    i32 6, label %c6
+    i32 7, label %c7
+    i32 8, label %c8
+    i32 9, label %c9
+    i32 10, label %c10
+    i32 11, label %c11
+    i32 12, label %c12
+    i32 13, label %c13
+    i32 14, label %c14
+    i32 15, label %c15
+    i32 16, label %c16
+    i32 17, label %c17
+    i32 18, label %c18
+    i32 19, label %c19
+    i32 20, label %c20
+    i32 21, label %c21
+    i32 22, label %c22
+    i32 23, label %c23
+  ]
+
+c0:
+  %a0 = add i64 %x, 1
+  call void @use(i64 %y)
+  br label %join
+
+c1:
+  %a1 = add i64 %x, 4
+  call void @use(i64 %y)
+  br label %join
+
+c2:
+  %a2 = add i64 %x, 7
+  call void @use(i64 %y)
+  br label %join
+
+c3:
+  %a3 = add i64 %x, 10
+  call void @use(i64 %y)
+  br label %join
+
+c4:
+  %a4 = add i64 %x, 13
+  call void @use(i64 %y)
+  br label %join
+
+c5:
+  %a5 = add i64 %x, 16
+  call void @use(i64 %y)
+  br label %join
+
+c6:
+  %a6 = add i64 %x, 19
+  call void @use(i64 %y)
+  br label %join
+
+c7:
+  %a7 = add i64 %x, 22
+  call void @use(i64 %y)
+  br label %join
+
+c8:
+  %a8 = add i64 %x, 25
+  call void @use(i64 %y)
+  br label %join
+
+c9:
+  %a9 = add i64 %x, 28
+  call void @use(i64 %y)
+  br label %join
+
+c10:
+  %a10 = add i64 %x, 31
+  call void @use(i64 %y)
+  br label %join
+
+c11:
+  %a11 = add i64 %x, 34
+  call void @use(i64 %y)
+  br label %join
+
+c12:
+  %a12 = add i64 %x, 37
+  call void @use(i64 %y)
+  br label %join
+
+c13:
+  %a13 = add i64 %x, 40
+  call void @use(i64 %y)
+  br label %join
+
+c14:
+  %a14 = add i64 %x, 43
+  call void @use(i64 %y)
+  br label %join
+
+c15:
+  %a15 = add i64 %x, 46
+  call void @use(i64 %y)
+  br label %join
+
+c16:
+  %a16 = add i64 %x, 49
+  call void @use(i64 %y)
+  br label %join
+
+c17:
+  %a17 = add i64 %x, 52
+  call void @use(i64 %y)
+  br label %join
+
+c18:
+  %a18 = add i64 %x, 55
+  call void @use(i64 %y)
+  br label %join
+
+c19:
+  %a19 = add i64 %x, 58
+  call void @use(i64 %y)
+  br label %join
+
+c20:
+  %a20 = add i64 %x, 61
+  call void @use(i64 %y)
+  br label %join
+
+c21:
+  %a21 = add i64 %x, 64
+  call void @use(i64 %y)
+  br label %join
+
+c22:
+  %a22 = add i64 %x, 67
+  call void @use(i64 %y)
+  br label %join
+
+c23:
+  %a23 = add i64 %x, 70
+  call void @use(i64 %y)
+  br label %join
+
+def:
+  br label %join
+
+join:
+  %r = phi i64 [ %a0, %c0 ], [ %a1, %c1 ], [ %a2, %c2 ], [ %a3, %c3 ], [ %a4, %c4 ], [ %a5, %c5 ], [ %a6, %c6 ], [ %a7, %c7 ], [ %a8, %c8 ], [ %a9, %c9 ], [ %a10, %c10 ], [ %a11, %c11 ], [ %a12, %c12 ], [ %a13, %c13 ], [ %a14, %c14 ], [ %a15, %c15 ], [ %a16, %c16 ], [ %a17, %c17 ], [ %a18, %c18 ], [ %a19, %c19 ], [ %a20, %c20 ], [ %a21, %c21 ], [ %a22, %c22 ], [ %a23, %c23 ], [ %y, %def ]
+  %z = add i64 %r, %x
+  ret i64 %z
+}
+
+; The PHI input register has one value per case, so it is large from the
+; start.  By default every copy into it is joined and no COPY is left in the
+; cases.  With the small thresholds it is joined three times, and the later
+; cases keep their copies.
+
+; DEFAULT-LABEL: Machine code for function phi_join:
+; DEFAULT: derived from LLVM BB %c0
+; DEFAULT-NOT: COPY
+; DEFAULT: derived from LLVM BB %join
+
+; SMALL-LABEL: Machine code for function phi_join:
+; SMALL: derived from LLVM BB %c0
+; SMALL-NOT: COPY
+; SMALL: derived from LLVM BB %c1
+; SMALL: derived from LLVM BB %c7
+; SMALL-NOT: derived from
+; SMALL: %vreg{{[0-9]+}}<def> = COPY %vreg{{[0-9]+}}
+; SMALL: derived from LLVM BB %join
+
+define i64 @phi_join(i64 %x, i32 %s) {
+entry:
+  switch i32 %s, label %def [
+    i32 0, label %c0
+    i32 1, label %c1
+    i32 2, label %c2
+    i32 3, label %c3
+    i32 4, label %c4
+    i32 5, label %c5
+    i32 6, label %c6
+    i32 7, label %c7
+  ]
+
+c0:
+  %a0 = mul i64 %x, 5
+  br label %join
+
+c1:
+  %a1 = mul i64 %x, 8
+  br label %join
+
+c2:
+  %a2 = mul i64 %x, 11
+  br label %join
+
+c3:
+  %a3 = mul i64 %x, 14
+  br label %join
+
+c4:
+  %a4 = mul i64 %x, 17
+  br label %join
+
+c5:
+  %a5 = mul i64 %x, 20
+  br label %join
+
+c6:
+  %a6 = mul i64 %x, 23
+  br label %join
+
+c7:
+  %a7 = mul i64 %x, 26
+  br label %join
+
+def:
+  br label %join
+
+join:
+  %r = phi i64 [ %a0, %c0 ], [ %a1, %c1 ], [ %a2, %c2 ], [ %a3, %c3 ], [ %a4, %c4 ], [ %a5, %c5 ], [ %a6, %c6 ], [ %a7, %c7 ], [ %x, %def ]
+  ret i64 %r
+}
+
+; Every block copies the PHI value twice, and joining the two copies erases
+; the second one, which ends the live range of the value it read.  The
+; function is pr13209.ll.
+
+; FALLBACK-LABEL: shrink_fallback:
+; FALLBACK-NOT: mov
+; FALLBACK: .size shrink_fallback
+
+define zeroext i1 @shrink_fallback(i8** %x, i8*** %jumpTable) nounwind {
+if.end51:
+  br label %indirectgoto.preheader
+indirectgoto.preheader:
+  %frombool.i5915.ph = phi i8 [ undef, %if.end51 ], [ %frombool.i5917, %jit_return ]
+  br label %indirectgoto
+do.end165:
+  %tmp92 = load i8** %x, align 8
+  br label %indirectgoto
+do.end209:
+  %tmp104 = load i8** %x, align 8
+  br label %indirectgoto
+do.end220:
+  %tmp107 = load i8** %x, align 8
+  br label %indirectgoto
+do.end231:
+  %tmp110 = load i8** %x, align 8
+  br label %indirectgoto
+do.end242:
+  %tmp113 = load i8** %x, align 8
+  br label %indirectgoto
+do.end253:
+  %tmp116 = load i8** %x, align 8
+  br label %indirectgoto
+do.end286:
+  %tmp125 = load i8** %x, align 8
+  br label %indirectgoto
+do.end297:
+  %tmp128 = load i8** %x, align 8
+  br label %indirectgoto
+do.end308:
+  %tmp131 = load i8** %x, align 8
+  br label %indirectgoto
+do.end429:
+  %tmp164 = load i8** %x, align 8
+  br label %indirectgoto
+do.end440:
+  %tmp167 = load i8** %x, align 8
+  br label %indirectgoto
+do.body482:
+  br i1 false, label %indirectgoto, label %do.body495
+do.body495:
+  br label %indirectgoto
+do.end723:
+  br label %inline_return
+inline_return:
+  %frombool.i5917 = phi i8 [ 0, %if.end5571 ], [ %frombool.i5915, %do.end723 ]
+  br label %jit_return
+jit_return:
+  br label %indirectgoto.preheader
+L_JSOP_UINT24:
+  %tmp864 = load i8** %x, align 8
+  br label %indirectgoto
+L_JSOP_THROWING:
+  %tmp1201 = load i8** %x, align 8
+  br label %indirectgoto
+do.body4936:
+  %tmp1240 = load i8** %x, align 8
+  br label %indirectgoto
+do.body5184:
+  %tmp1340 = load i8** %x, align 8
+  br label %indirectgoto
+if.end5571:
+  br  label %inline_return
+indirectgoto:
+  %frombool.i5915 = phi i8  [ 0, %do.body495 ],[ 0, %do.body482 ] , [ %frombool.i5915, %do.body4936 ],[ %frombool.i5915, %do.body5184 ], [ %frombool.i5915, %L_JSOP_UINT24 ], [ %frombool.i5915, %do.end286 ], [ %frombool.i5915, %do.end297 ], [ %frombool.i5915, %do.end308 ], [ %frombool.i5915, %do.end429 ], [ %frombool.i5915, %do.end440 ], [ %frombool.i5915, %L_JSOP_THROWING ], [ %frombool.i5915, %do.end253 ], [ %frombool.i5915, %do.end242 ], [ %frombool.i5915, %do.end231 ], [ %frombool.i5915, %do.end220 ], [ %frombool.i5915, %do.end209 ],[ %frombool.i5915, %do.end165 ], [ %frombool.i5915.ph, %indirectgoto.preheader ]
+  indirectbr i8* null, [ label %if.end5571, label %do.end165, label %do.end209, label %do.end220, label %do.end231, label %do.end242, label %do.end253, label %do.end723, label %L_JSOP_THROWING, label %do.end440, label %do.end429, label %do.end308, label %do.end297, label %do.end286, label %L_JSOP_UINT24, label %do.body5184, label %do.body4936, label %do.body482]
+}
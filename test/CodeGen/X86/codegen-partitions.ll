@@ -0,0 +1,67 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -codegen-partitions=3 -o %t
+; RUN: FileCheck %s -check-prefix=P0 < %t
+; RUN: FileCheck %s -check-prefix=P1 < %t.1
+; RUN: FileCheck %s -check-prefix=P2 < %t.2
+
+; Functions are spread over the partitions by size. Global variables, aliases
+; and the functions they alias stay in partition 0. Local symbols are made
+; hidden globals when they are referenced from another partition.
+
+@counter = internal global i32 0
+@table = global [2 x void ()*] [void ()* @a, void ()* @b]
+@str = private unnamed_addr constant [6 x i8] c"hello\00"
+@alias_b = alias void ()* @b
+
+declare i32 @puts(i8*)
+
+; P0-NOT: bump:
+; P0: a:
+; P0: movl $.Lstr, %edi
+; P0: b:
+; P0: .hidden counter
+; P0: .globl counter
+; P0: counter:
+; P0: table:
+; P0: .Lstr:
+; P0: alias_b = b
+
+; P1-NOT: {{^(a|b|bump|counter):}}
+; P1: main:
+; P1: callq a
+; P1: callq alias_b
+; P1: callq bump
+; P1-NOT: {{^(a|b|bump|counter):}}
+
+; P2-NOT: {{^(a|b|main|counter):}}
+; P2: .hidden bump
+; P2: .globl bump
+; P2: bump:
+; P2: incl counter(%rip)
+; P2-NOT: {{^(a|b|main|counter):}}
+
+define internal void @bump() {
+  %v = load i32* @counter
+  %n = add i32 %v, 1
+  store i32 %n, i32* @counter
+  ret void
+}
+
+define void @a() {
+  call void @bump()
+  %p = getelementptr [6 x i8]* @str, i64 0, i64 0
+  call i32 @puts(i8* %p)
+  ret void
+}
+
+define void @b() {
+  call void @bump()
+  ret void
+}
+
+define i32 @main() {
+  call void @a()
+  call void @alias_b()
+  call void @bump()
+  %v = load i32* @counter
+  ret i32 %v
+}
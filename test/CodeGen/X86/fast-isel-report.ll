@@ -0,0 +1,28 @@
+; RUN: llc < %s -O0 -fast-isel-report -mtriple=x86_64-unknown-unknown -mcpu=corei7 -o /dev/null 2>&1 | FileCheck %s
+
+; CHECK: FastISel Fallback Report
+; CHECK: 4 instructions selected by FastISel
+; CHECK: 4 instructions selected by SelectionDAG
+; CHECK: 50.0% FastISel coverage
+; CHECK: Misses    Insts  Instruction
+; CHECK-NEXT: 1        3  shufflevector <vector>
+; CHECK-NEXT: 1        1  call llvm.x86.sse2.pmovmskb.128 <vector>
+; CHECK-NEXT: 2        0  formal arguments
+
+declare i32 @llvm.x86.sse2.pmovmskb.128(<16 x i8>)
+
+define <4 x i32> @shuffle(<4 x i32>* %p, <4 x i32> %b) nounwind {
+entry:
+  %a = load <4 x i32>* %p
+  %c = add <4 x i32> %a, %b
+  %s = shufflevector <4 x i32> %c, <4 x i32> %b, <4 x i32> <i32 1, i32 0, i32 3, i32 2>
+  %t = add <4 x i32> %s, %b
+  ret <4 x i32> %t
+}
+
+define i32 @intrinsic(<16 x i8> %v) nounwind {
+entry:
+  %m = call i32 @llvm.x86.sse2.pmovmskb.128(<16 x i8> %v)
+  %r = add i32 %m, 1
+  ret i32 %r
+}
@@ -0,0 +1,75 @@
+; RUN: llc < %s -O0 -fast-isel-abort -mtriple=x86_64-unknown-unknown -mcpu=corei7 -verify-machineinstrs | FileCheck %s
+
+; Vector loads, constants, bitcasts and selects are handled by fast isel.
+
+; CHECK-LABEL: load_add:
+; CHECK-DAG: movups (%rdi), [[A:%xmm[0-9]+]]
+; CHECK-DAG: movaps {{.*}}LCPI{{.*}}, [[C:%xmm[0-9]+]]
+; CHECK: addps
+define <4 x float> @load_add(<4 x float>* %p) nounwind {
+entry:
+  %a = load <4 x float>* %p, align 4
+  %b = fadd <4 x float> %a, <float 1.0, float 2.0, float 3.0, float 4.0>
+  ret <4 x float> %b
+}
+
+; CHECK-LABEL: aligned_load:
+; CHECK: movdqa (%rdi)
+define <2 x i64> @aligned_load(<2 x i64>* %p) nounwind {
+entry:
+  %a = load <2 x i64>* %p
+  ret <2 x i64> %a
+}
+
+; CHECK-LABEL: zero_bitcast:
+; CHECK: xorps
+; CHECK: paddd
+define <2 x i64> @zero_bitcast(<2 x i64> %a) nounwind {
+entry:
+  %b = bitcast <2 x i64> %a to <4 x i32>
+  %c = add <4 x i32> %b, zeroinitializer
+  %d = bitcast <4 x i32> %c to <2 x i64>
+  ret <2 x i64> %d
+}
+
+; CHECK-LABEL: select_v4f32:
+; CHECK: testb
+; CHECK: je
+define void @select_v4f32(i1 %c, <4 x float>* %p, <4 x float> %a,
+                          <4 x float> %b) nounwind {
+entry:
+  %s = select i1 %c, <4 x float> %a, <4 x float> %b
+  store <4 x float> %s, <4 x float>* %p
+  ret void
+}
+
+; CHECK-LABEL: select_f64:
+; CHECK: testb
+; CHECK: je
+define void @select_f64(i1 %c, double* %p, double %a, double %b) nounwind {
+entry:
+  %s = select i1 %c, double %a, double %b
+  store double %s, double* %p
+  ret void
+}
+
+; CHECK-LABEL: select_i8:
+; CHECK: testb
+; CHECK: je
+define void @select_i8(i1 %c, i8* %p, i8 %a, i8 %b) nounwind {
+entry:
+  %s = select i1 %c, i8 %a, i8 %b
+  store i8 %s, i8* %p
+  ret void
+}
+
+; A tail call that is not in tail position is an ordinary call.
+declare void @g(i32)
+
+; CHECK-LABEL: not_tail:
+; CHECK: callq g
+define i32 @not_tail(i32 %x) nounwind {
+entry:
+  tail call void @g(i32 %x)
+  ret i32 %x
+}
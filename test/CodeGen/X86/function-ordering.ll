@@ -0,0 +1,46 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -disable-function-ordering | FileCheck %s -check-prefix=MODULE
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -O0 | FileCheck %s -check-prefix=MODULE
+
+; Functions are laid out along the hottest call edges from the profile: a-c,
+; then c-d, then d-b.  Functions without profiled calls come last.
+
+; CHECK: a:
+; CHECK: c:
+; CHECK: d:
+; CHECK: b:
+; CHECK: e:
+
+; MODULE: a:
+; MODULE: b:
+; MODULE: c:
+; MODULE: d:
+; MODULE: e:
+
+define void @a() {
+  call void @c(), !prof !0
+  ret void
+}
+
+define void @b() {
+  call void @d(), !prof !2
+  ret void
+}
+
+define void @c() {
+  call void @d(), !prof !1
+  ret void
+}
+
+define void @d() {
+  ret void
+}
+
+define void @e() {
+  call void @a()
+  ret void
+}
+
+!0 = metadata !{metadata !"branch_weights", i32 1000}
+!1 = metadata !{metadata !"branch_weights", i32 500}
+!2 = metadata !{metadata !"branch_weights", i32 10}
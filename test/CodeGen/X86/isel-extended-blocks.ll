@@ -0,0 +1,66 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -disable-cgp | FileCheck %s -check-prefix=BLOCK
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -disable-cgp -isel-extended-blocks | FileCheck %s -check-prefix=EBB
+
+; Without CodeGenPrepare sinking them, the address and the compare are
+; computed in the entry block and only reach their users through registers.
+; In extended basic block mode they are selected again next to their users,
+; so they fold into the addressing modes and the branch.
+
+; BLOCK-LABEL: addr:
+; BLOCK: cmpq $100, %rsi
+; BLOCK: setl
+; BLOCK: leaq (%rdi,%rsi,4), [[REG:%[a-z]+]]
+; BLOCK: movl ([[REG]]), %eax
+; BLOCK: movl $0, ([[REG]])
+
+; EBB-LABEL: addr:
+; EBB-NOT: setl
+; EBB: testb $1, %dl
+; EBB: cmpq $99, %rsi
+; EBB-NEXT: jg
+; EBB-NOT: leaq
+; EBB: movl (%rdi,%rsi,4), %eax
+; EBB: movl $0, (%rdi,%rsi,4)
+
+define i32 @addr(i32* %p, i64 %i, i1 %c) {
+entry:
+  %a = getelementptr i32* %p, i64 %i
+  %cmp = icmp slt i64 %i, 100
+  br i1 %c, label %then, label %exit
+
+then:
+  %v = load i32* %a
+  br i1 %cmp, label %then2, label %exit
+
+then2:
+  store i32 0, i32* %a
+  ret i32 %v
+
+exit:
+  ret i32 0
+}
+
+; The loop header has two predecessors, so the address computed before the
+; loop is not recomputed inside it.
+
+; EBB-LABEL: loop:
+; EBB: leaq (%rdi,%rsi,4), [[PTR:%[a-z]+]]
+; EBB: [[LOOP:.LBB[0-9_]+]]:
+; EBB: movl $0, ([[PTR]])
+; EBB: jne [[LOOP]]
+
+define void @loop(i32* %p, i64 %i, i32 %n) {
+entry:
+  %a = getelementptr i32* %p, i64 %i
+  br label %body
+
+body:
+  %k = phi i32 [ 0, %entry ], [ %k.next, %body ]
+  store volatile i32 0, i32* %a
+  %k.next = add i32 %k, 1
+  %done = icmp eq i32 %k.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret void
+}
@@ -0,0 +1,16 @@
+; RUN: llc < %s -march=x86 -regalloc=linearscan -verify-machineinstrs \
+; RUN:     | FileCheck %s
+
+; Six unspillable operands compete for the six registers left besides %ecx.
+; The "q" operand can only use %eax, %ebx or %edx, so it has to evict one of
+; the "r" operands that were assigned first.
+
+; CHECK-LABEL: constrain_abcd:
+; CHECK: #APP
+; CHECK-NEXT: foo %e{{..}} %e{{..}} %e{{..}} %e{{..}} %e{{[abd]}}x %e{{..}}
+; CHECK-NEXT: #NO_APP
+define void @constrain_abcd(i8* %h) nounwind ssp {
+entry:
+  %0 = call { i32, i32, i32, i32, i32 } asm sideeffect "foo $0 $1 $2 $3 $4 $5", "=&r,=&r,=&r,=&r,=&q,r,~{ecx},~{memory},~{dirflag},~{fpsr},~{flags}"(i8* %h) nounwind
+  ret void
+}
@@ -0,0 +1,54 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux -regalloc=linearscan \
+; RUN:     -verify-machineinstrs | FileCheck %s
+
+; More values are live across the call than there are callee-saved registers,
+; so some of them are spilled after their definition and reloaded after the
+; call.
+
+declare void @g()
+
+; CHECK-LABEL: f:
+; CHECK: 8-byte Spill
+; CHECK: callq g
+; CHECK: 8-byte Folded Reload
+; CHECK: ret
+define i64 @f(i64* %p, i1 %c) {
+entry:
+  %e0 = getelementptr i64* %p, i64 0
+  %a0 = load volatile i64* %e0
+  %e1 = getelementptr i64* %p, i64 1
+  %a1 = load volatile i64* %e1
+  %e2 = getelementptr i64* %p, i64 2
+  %a2 = load volatile i64* %e2
+  %e3 = getelementptr i64* %p, i64 3
+  %a3 = load volatile i64* %e3
+  %e4 = getelementptr i64* %p, i64 4
+  %a4 = load volatile i64* %e4
+  %e5 = getelementptr i64* %p, i64 5
+  %a5 = load volatile i64* %e5
+  %e6 = getelementptr i64* %p, i64 6
+  %a6 = load volatile i64* %e6
+  %e7 = getelementptr i64* %p, i64 7
+  %a7 = load volatile i64* %e7
+  %e8 = getelementptr i64* %p, i64 8
+  %a8 = load volatile i64* %e8
+  %e9 = getelementptr i64* %p, i64 9
+  %a9 = load volatile i64* %e9
+  br i1 %c, label %call, label %join
+
+call:
+  call void @g()
+  br label %join
+
+join:
+  %s1 = add i64 %a0, %a1
+  %s2 = add i64 %s1, %a2
+  %s3 = add i64 %s2, %a3
+  %s4 = add i64 %s3, %a4
+  %s5 = add i64 %s4, %a5
+  %s6 = add i64 %s5, %a6
+  %s7 = add i64 %s6, %a7
+  %s8 = add i64 %s7, %a8
+  %s9 = add i64 %s8, %a9
+  ret i64 %s9
+}
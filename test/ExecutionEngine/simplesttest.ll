@@ -1,4 +1,5 @@
 ; RUN: %lli %s > /dev/null
+; RUN: %lli -O2 %s > /dev/null
 
 define i32 @main() {
 	ret i32 0
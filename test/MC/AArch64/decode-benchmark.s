@@ -0,0 +1,14 @@
+// RUN: llvm-mc -triple aarch64-none-linux-gnu -filetype=obj %s -o %t
+// RUN: llvm-objdump -decode-benchmark=3 %t | FileCheck %s
+
+// Decoding in bulk finds the same instructions as decoding them one at a
+// time, including the trailing bytes that do not make up a whole one.
+
+// CHECK: decoded 39 bytes
+// CHECK: getInstruction: 12 instructions in
+// CHECK: getInstructions: 12 instructions in
+
+        add x0, x1, x2
+        ldr w3, [x4, #8]
+        b.ne #-4
+        .byte 0x1f
@@ -0,0 +1,32 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.serial
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t.parallel \
+// RUN:   -elf-writer-threads=4
+// RUN: cmp %t.serial %t.parallel
+// RUN: llvm-nm %t.parallel | FileCheck %s
+
+// The symbol table and the relocations are large enough to be sorted and
+// encoded in several pieces; the object must not depend on the thread count.
+
+// CHECK:      U ext1010
+// CHECK-NEXT: U ext1011
+// CHECK:      U ext7979
+// CHECK:      T glob1010
+// CHECK-NEXT: T glob1011
+// CHECK:      T glob7979
+// CHECK:      t loc1010
+// CHECK-NEXT: t loc1011
+// CHECK:      t loc7979
+
+.macro row a
+.irp b,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63,64,65,66,67,68,69,70,71,72,73,74,75,76,77,78,79
+        .globl glob\a\b
+glob\a\b:
+loc\a\b:
+        call ext\a\b
+        .quad loc\a\b+8
+.endr
+.endm
+
+.irp a,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63,64,65,66,67,68,69,70,71,72,73,74,75,76,77,78,79
+row \a
+.endr
@@ -0,0 +1,30 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+// RUN:   | llvm-objdump -d - | FileCheck %s
+
+// Every jump below fits in a short jump until the one after it grows, so the
+// relaxation of the last jump has to reach back through the others. In the
+// second group, the growth of k1 moves u0 to the next alignment boundary,
+// which is out of reach of k0.
+
+// CHECK:   0: e9 80 00 00 00 jmpq 128
+// CHECK:  80: e9 80 00 00 00 jmpq 128
+// CHECK: 100: e9 c8 00 00 00 jmpq 200
+
+j0:     jmp     t0
+        .fill   123, 1, 0x90
+j1:     jmp     t1
+t0:     .fill   123, 1, 0x90
+j2:     jmp     t2
+t1:     .fill   200, 1, 0x90
+t2:     nop
+
+// CHECK: 200: e9 fb 00 00 00 jmpq 251
+// CHECK: 281: e9 42 01 00 00 jmpq 322
+
+        .p2align 7
+k0:     jmp     u0
+        .fill   124, 1, 0x90
+k1:     jmp     u1
+        .p2align 7
+u0:     .fill   200, 1, 0x90
+u1:     nop
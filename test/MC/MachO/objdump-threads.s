@@ -0,0 +1,37 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-apple-darwin10 %s -o %t
+// RUN: llvm-objdump -d -r %t > %t.serial
+// RUN: llvm-objdump -d -r -threads=4 %t > %t.parallel
+// RUN: cmp %t.serial %t.parallel
+// RUN: FileCheck %s < %t.parallel
+
+// __text is split into several chunks at symbol boundaries when it is
+// disassembled on more than one thread; the listing, including the
+// relocations printed between the instructions, must not depend on the
+// thread count.
+
+// CHECK:      Disassembly of section __TEXT,__text:
+// CHECK-NEXT: f1010:
+// CHECK-NEXT: 0: e8 00 00 00 00 callq 0
+// CHECK-NEXT: 1: X86_64_RELOC_BRANCH g1010
+// CHECK-NEXT: 5: 48 8d 05 f4 ff ff ff leaq -12(%rip), %rax
+// CHECK:      f4510:
+// CHECK-NEXT: e8 00 00 00 00 callq 0
+// CHECK-NEXT: X86_64_RELOC_BRANCH g4510
+// CHECK:      f7979:
+// CHECK-NEXT: f8c7: e8 00 00 00 00 callq 0
+// CHECK-NEXT: f8c8: X86_64_RELOC_BRANCH g7979
+// CHECK-NEXT: f8cc: 48 8d 05 f4 ff ff ff leaq -12(%rip), %rax
+// CHECK-NEXT: f8d3: c3 ret
+
+.macro row a
+.irp b,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63,64,65,66,67,68,69,70,71,72,73,74,75,76,77,78,79
+f\a\b:
+        call g\a\b
+        leaq f\a\b(%rip), %rax
+        ret
+.endr
+.endm
+
+.irp a,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63,64,65,66,67,68,69,70,71,72,73,74,75,76,77,78,79
+row \a
+.endr
@@ -0,0 +1,122 @@
+; RUN: opt < %s -hotcoldsplit -S | FileCheck %s
+; RUN: opt < %s -lower-expect -hotcoldsplit -S | FileCheck %s -check-prefix=EXPECT
+
+declare void @sink(i32)
+declare void @abort() noreturn nounwind
+declare i64 @llvm.expect.i64(i64, i64) nounwind readnone
+
+; The error path only runs when the branch weights say it is unlikely, so it
+; is moved into its own function in the cold section.
+; CHECK-LABEL: define i32 @weights(
+; CHECK: call void @weights_
+; CHECK-NOT: call void @sink
+; CHECK: ret i32
+define i32 @weights(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0
+  br i1 %cmp, label %error, label %exit, !prof !0
+
+error:
+  call void @sink(i32 1)
+  call void @sink(i32 2)
+  call void @sink(i32 %x)
+  br label %exit
+
+exit:
+  %r = add i32 %x, 1
+  ret i32 %r
+}
+
+; Paths ending in unreachable are cold, and stay noreturn once outlined.
+; CHECK-LABEL: define void @noreturn(
+; CHECK: call void @noreturn_{{.*}} #[[NORETURN:[0-9]+]]
+; CHECK-NEXT: unreachable
+; CHECK-NOT: call void @abort
+; CHECK: ret void
+define void @noreturn(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 0
+  br i1 %cmp, label %fail, label %ok
+
+fail:
+  call void @sink(i32 %x)
+  call void @sink(i32 0)
+  call void @abort()
+  unreachable
+
+ok:
+  call void @sink(i32 %x)
+  ret void
+}
+
+; A balanced diamond has no cold side.
+; CHECK-LABEL: define void @balanced(
+; CHECK-NOT: call void @balanced_
+; CHECK: ret void
+define void @balanced(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0
+  br i1 %cmp, label %a, label %b
+
+a:
+  call void @sink(i32 1)
+  call void @sink(i32 2)
+  call void @sink(i32 3)
+  br label %exit
+
+b:
+  call void @sink(i32 4)
+  call void @sink(i32 5)
+  call void @sink(i32 6)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; Cold regions below the minimum size are left alone.
+; CHECK-LABEL: define void @tiny(
+; CHECK-NOT: call void @tiny_
+; CHECK: ret void
+define void @tiny(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0
+  br i1 %cmp, label %error, label %exit, !prof !0
+
+error:
+  call void @sink(i32 1)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; llvm.expect is turned into branch weights before the split.
+; EXPECT-LABEL: define void @expect(
+; EXPECT: call void @expect_
+; EXPECT: ret void
+define void @expect(i32 %x) {
+entry:
+  %conv = sext i32 %x to i64
+  %expval = call i64 @llvm.expect.i64(i64 %conv, i64 0)
+  %tobool = icmp ne i64 %expval, 0
+  br i1 %tobool, label %unlikely, label %exit
+
+unlikely:
+  call void @sink(i32 1)
+  call void @sink(i32 2)
+  call void @sink(i32 %x)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK: define internal void @weights_{{.*}} #[[ATTR:[0-9]+]] section ".text.unlikely"
+; CHECK: call void @sink(i32 1)
+; CHECK: define internal void @noreturn_{{.*}} section ".text.unlikely"
+; CHECK: call void @abort()
+; CHECK: attributes #[[ATTR]] = { cold noinline optsize }
+; CHECK: attributes #[[NORETURN]] = { noreturn }
+
+!0 = metadata !{metadata !"branch_weights", i32 1, i32 2000}
@@ -1,4 +1,5 @@
-; RUN: opt -loop-vectorize -mtriple=x86_64-apple-macosx -S -mcpu=corei7-avx < %s | FileCheck %s
+; RUN: opt -loop-vectorize -mtriple=x86_64-apple-macosx -S -mcpu=corei7-avx -enable-interleaved-mem-accesses=false < %s | FileCheck %s
+; RUN: opt -loop-vectorize -mtriple=x86_64-apple-macosx -S -mcpu=corei7-avx < %s | FileCheck %s -check-prefix=INTERLEAVE
 target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
 
 @kernel = global [512 x float] zeroinitializer, align 16
@@ -16,6 +17,11 @@ target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f3
 ; Make sure we are conservative and don't vectorize it.
 ; CHECK-NOT: x float>
 
+; The three loads from src_data form an interleave group though. As one wide
+; load plus shuffles they are cheap enough to make vectorization worthwhile.
+; INTERLEAVE: load <24 x float>
+; INTERLEAVE: shufflevector <24 x float>
+
 define void @_Z4testmm(i64 %size, i64 %offset) {
 entry:
   %cmp53 = icmp eq i64 %size, 0
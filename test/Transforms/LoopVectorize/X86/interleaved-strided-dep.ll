@@ -0,0 +1,66 @@
+; RUN: opt < %s -loop-vectorize -mcpu=corei7-avx -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -mcpu=corei7-avx | %lli
+; REQUIRES: native
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; A stride-2 group feeding a stride-2 group two iterations later:
+;   for (i = 0; i < 1024; i++) {
+;     A[2*i+4] = A[2*i] + 1;
+;     A[2*i+5] = A[2*i+1] + 1;
+;   }
+; The accesses are 16 bytes apart, but that is only two iterations, so the
+; vector width must not exceed 2. A wider loop reads A[2*i+4] before the
+; iteration two back has stored it.
+
+@A = global [2056 x i32] zeroinitializer, align 16
+
+;CHECK-LABEL: @strided_dep(
+;CHECK-NOT: <8 x i32>
+;CHECK: %[[WIDE:.*]] = load <4 x i32>* {{.*}}, align 4
+;CHECK: shufflevector <4 x i32> %[[WIDE]], <4 x i32> undef, <2 x i32> <i32 0, i32 2>
+;CHECK: shufflevector <4 x i32> %[[WIDE]], <4 x i32> undef, <2 x i32> <i32 1, i32 3>
+;CHECK: store <4 x i32> {{.*}}, align 4
+;CHECK: %index.next = add i64 %index, 2
+;CHECK-NOT: <8 x i32>
+;CHECK: ret void
+define void @strided_dep() {
+entry:
+  br label %for.body
+
+for.body:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %for.body ]
+  %even = shl nsw i64 %i, 1
+  %odd = or i64 %even, 1
+  %p0 = getelementptr inbounds [2056 x i32]* @A, i64 0, i64 %even
+  %l0 = load i32* %p0, align 4
+  %a0 = add nsw i32 %l0, 1
+  %s0.idx = add nsw i64 %even, 4
+  %s0 = getelementptr inbounds [2056 x i32]* @A, i64 0, i64 %s0.idx
+  store i32 %a0, i32* %s0, align 4
+  %p1 = getelementptr inbounds [2056 x i32]* @A, i64 0, i64 %odd
+  %l1 = load i32* %p1, align 4
+  %a1 = add nsw i32 %l1, 1
+  %s1.idx = add nsw i64 %even, 5
+  %s1 = getelementptr inbounds [2056 x i32]* @A, i64 0, i64 %s1.idx
+  store i32 %a1, i32* %s1, align 4
+  %i.next = add nuw nsw i64 %i, 1
+  %exitcond = icmp eq i64 %i.next, 1024
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Every iteration adds one to the chain that A[2049] ends, so it is 512
+; when the loop runs in order. main returns 0 in that case.
+define i32 @main() {
+entry:
+  call void @strided_dep()
+  %p = getelementptr inbounds [2056 x i32]* @A, i64 0, i64 2049
+  %v = load i32* %p, align 4
+  %ok = icmp eq i32 %v, 512
+  %ret = select i1 %ok, i32 0, i32 1
+  ret i32 %ret
+}
@@ -324,14 +324,14 @@ define void @example10b(i16* noalias nocapture %sa, i16* noalias nocapture %sb,
 }
 
 ;CHECK-LABEL: @example11(
-;CHECK: load i32
-;CHECK: load i32
-;CHECK: load i32
-;CHECK: load i32
-;CHECK: insertelement
-;CHECK: insertelement
-;CHECK: insertelement
-;CHECK: insertelement
+;CHECK: load <8 x i32>
+;CHECK: shufflevector <8 x i32>
+;CHECK: shufflevector <8 x i32>
+;CHECK: load <8 x i32>
+;CHECK: shufflevector <8 x i32>
+;CHECK: shufflevector <8 x i32>
+;CHECK: store <4 x i32>
+;CHECK: store <4 x i32>
 ;CHECK: ret void
 define void @example11() nounwind uwtable ssp {
   br label %1
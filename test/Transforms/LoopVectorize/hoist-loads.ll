@@ -1,4 +1,5 @@
 ; RUN: opt -loop-vectorize -force-vector-width=2 -force-vector-unroll=1 -S < %s | FileCheck %s
+; RUN: opt -loop-vectorize -force-vector-width=2 -force-vector-unroll=1 -enable-predicated-mem-accesses=false -S < %s | FileCheck %s -check-prefix=NOPRED
 
 target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
 
@@ -8,6 +9,9 @@ target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f3
 ; Make sure we can vectorize in the presence of hoistable conditional loads.
 ; CHECK-LABEL: @hoist_cond_load(
 ; CHECK: load <2 x float>
+; CHECK-NOT: pred.if
+; NOPRED-LABEL: @hoist_cond_load(
+; NOPRED: load <2 x float>
 
 define void @hoist_cond_load() {
 entry:
@@ -37,9 +41,17 @@ for.end:
 }
 
 ; However, we can't hoist loads whose address we have not seen unconditionally
-; accessed.
+; accessed. Such loads are executed lane by lane under the mask instead, or
+; block vectorization when predicated accesses are disabled.
 ; CHECK-LABEL: @dont_hoist_cond_load(
-; CHECK-NOT: load <2 x float>
+; CHECK: %[[MASK:.*]] = extractelement <2 x i1> %{{.*}}, i32 0
+; CHECK: br i1 %[[MASK]], label %pred.if, label %pred.continue
+; CHECK: pred.if:
+; CHECK: load float*
+; CHECK: pred.continue:
+; CHECK: phi <2 x float>
+; NOPRED-LABEL: @dont_hoist_cond_load(
+; NOPRED-NOT: load <2 x float>
 
 define void @dont_hoist_cond_load() {
 entry:
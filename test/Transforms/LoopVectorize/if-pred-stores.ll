@@ -0,0 +1,122 @@
+; RUN: opt < %s -loop-vectorize -force-vector-width=2 -force-vector-unroll=1 -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -force-vector-width=1 -force-vector-unroll=2 -S | FileCheck %s -check-prefix=UNROLL
+; RUN: opt < %s -loop-vectorize -force-vector-width=2 -force-vector-unroll=1 -enable-predicated-mem-accesses=false -S | FileCheck %s -check-prefix=DISABLED
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Conditional stores are executed lane by lane, each guarded by its bit of the
+; block mask:
+;   for (int i = 0; i < n; i++)
+;     if (a[i] > t)
+;       b[i] = x;
+
+;CHECK-LABEL: @cond_store(
+;CHECK: vector.body:
+;CHECK: %[[C:.*]] = icmp sgt <2 x i32> %wide.load
+;CHECK: %[[M0:.*]] = extractelement <2 x i1> %{{.*}}, i32 0
+;CHECK: br i1 %[[M0]], label %pred.if, label %pred.continue
+;CHECK: pred.if:
+;CHECK: store i32 %x, i32* %{{.*}}, align 4
+;CHECK: br label %pred.continue
+;CHECK: pred.continue:
+;CHECK: %[[M1:.*]] = extractelement <2 x i1> %{{.*}}, i32 1
+;CHECK: br i1 %[[M1]], label %pred.if{{[0-9]+}}, label %pred.continue{{[0-9]+}}
+;CHECK: store i32 %x, i32* %{{.*}}, align 4
+;CHECK: ret void
+
+;UNROLL-LABEL: @cond_store(
+;UNROLL: vector.body:
+;UNROLL: br i1 %{{.*}}, label %pred.if, label %pred.continue
+;UNROLL: pred.if:
+;UNROLL: store i32 %x
+;UNROLL: pred.continue:
+;UNROLL: br i1 %{{.*}}, label %pred.if{{[0-9]+}}, label %pred.continue{{[0-9]+}}
+;UNROLL: store i32 %x
+;UNROLL: ret void
+
+;DISABLED-LABEL: @cond_store(
+;DISABLED-NOT: vector.body:
+;DISABLED: ret void
+define void @cond_store(i32* noalias nocapture %a, i32* noalias nocapture %b, i32 %t, i32 %x, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.inc ], [ 0, %entry ]
+  %pa = getelementptr inbounds i32* %a, i64 %i
+  %va = load i32* %pa, align 4
+  %c = icmp sgt i32 %va, %t
+  br i1 %c, label %if.then, label %for.inc
+
+if.then:
+  %pb = getelementptr inbounds i32* %b, i64 %i
+  store i32 %x, i32* %pb, align 4
+  br label %for.inc
+
+for.inc:
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; A conditional load from memory that is not accessed unconditionally may
+; fault, so it cannot be hoisted. The loaded lanes are merged through phis
+; and feed the reduction.
+;   for (int i = 0; i < n; i++)
+;     if (a[i])
+;       sum += b[i];
+
+;CHECK-LABEL: @cond_load_sum(
+;CHECK: vector.body:
+;CHECK: %vec.phi = phi <2 x i32>
+;CHECK: pred.if:
+;CHECK: %[[L0:.*]] = load i32* %{{.*}}, align 4
+;CHECK: %[[V0:.*]] = insertelement <2 x i32> undef, i32 %[[L0]], i32 0
+;CHECK: pred.continue:
+;CHECK: %[[P0:.*]] = phi <2 x i32> [ undef, %vector.body ], [ %[[V0]], %pred.if ]
+;CHECK: %[[L1:.*]] = load i32* %{{.*}}, align 4
+;CHECK: %[[V1:.*]] = insertelement <2 x i32> %[[P0]], i32 %[[L1]], i32 1
+;CHECK: phi <2 x i32> [ %[[P0]], %pred.continue ], [ %[[V1]], %pred.if{{[0-9]+}} ]
+;CHECK: add <2 x i32> %vec.phi
+;CHECK: middle.block:
+;CHECK: ret i32
+
+;DISABLED-LABEL: @cond_load_sum(
+;DISABLED-NOT: vector.body:
+;DISABLED: ret i32
+define i32 @cond_load_sum(i32* noalias nocapture %a, i32* noalias nocapture %b, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.inc ], [ 0, %entry ]
+  %sum = phi i32 [ %sum.next, %for.inc ], [ 0, %entry ]
+  %pa = getelementptr inbounds i32* %a, i64 %i
+  %va = load i32* %pa, align 4
+  %c = icmp ne i32 %va, 0
+  br i1 %c, label %if.then, label %for.inc
+
+if.then:
+  %pb = getelementptr inbounds i32* %b, i64 %i
+  %vb = load i32* %pb, align 4
+  br label %for.inc
+
+for.inc:
+  %add = phi i32 [ %vb, %if.then ], [ 0, %for.body ]
+  %sum.next = add i32 %sum, %add
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  %r = phi i32 [ 0, %entry ], [ %sum.next, %for.inc ]
+  ret i32 %r
+}
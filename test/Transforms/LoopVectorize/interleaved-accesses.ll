@@ -0,0 +1,202 @@
+; RUN: opt < %s -loop-vectorize -force-vector-unroll=1 -force-vector-width=4 -dce -instcombine -S | FileCheck %s
+; RUN: opt < %s -loop-vectorize -force-vector-unroll=1 -force-vector-width=4 -enable-interleaved-mem-accesses=false -dce -instcombine -S | FileCheck %s -check-prefix=DISABLED
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Complex numbers stored as interleaved real/imaginary pairs:
+;   for (int i = 0; i < n; i++) {
+;     float re = a[2*i], im = a[2*i+1];
+;     b[2*i] = re + im;
+;     b[2*i+1] = re - im;
+;   }
+; The two loads become one wide load plus two shuffles and the two stores
+; become one interleaving shuffle plus one wide store.
+
+;CHECK-LABEL: @stride2(
+;CHECK: %[[WIDE:.*]] = load <8 x float>* {{.*}}, align 4
+;CHECK: shufflevector <8 x float> %[[WIDE]], <8 x float> undef, <4 x i32> <i32 0, i32 2, i32 4, i32 6>
+;CHECK: shufflevector <8 x float> %[[WIDE]], <8 x float> undef, <4 x i32> <i32 1, i32 3, i32 5, i32 7>
+;CHECK: shufflevector <4 x float> {{.*}}, <4 x float> {{.*}}, <8 x i32> <i32 0, i32 4, i32 1, i32 5, i32 2, i32 6, i32 3, i32 7>
+;CHECK: store <8 x float> {{.*}}, align 4
+;CHECK: ret void
+
+;DISABLED-LABEL: @stride2(
+;DISABLED-NOT: load <8 x float>
+;DISABLED-NOT: store <8 x float>
+;DISABLED: ret void
+define void @stride2(float* noalias nocapture %a, float* noalias nocapture %b, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %idx0 = shl nsw i64 %i, 1
+  %idx1 = or i64 %idx0, 1
+  %a0 = getelementptr inbounds float* %a, i64 %idx0
+  %re = load float* %a0, align 4
+  %a1 = getelementptr inbounds float* %a, i64 %idx1
+  %im = load float* %a1, align 4
+  %sum = fadd float %re, %im
+  %diff = fsub float %re, %im
+  %b0 = getelementptr inbounds float* %b, i64 %idx0
+  store float %sum, float* %b0, align 4
+  %b1 = getelementptr inbounds float* %b, i64 %idx1
+  store float %diff, float* %b1, align 4
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Scale complex numbers in place. Loading a[2*i+1] after storing a[2*i] does
+; not conflict, because the two members never touch the same element.
+;   for (int i = 0; i < n; i++) {
+;     a[2*i] *= s;
+;     a[2*i+1] *= s;
+;   }
+
+;CHECK-LABEL: @inplace(
+;CHECK: load <8 x float>
+;CHECK: store <8 x float>
+;CHECK: ret void
+define void @inplace(float* nocapture %a, float %s, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %idx0 = shl nsw i64 %i, 1
+  %idx1 = or i64 %idx0, 1
+  %a0 = getelementptr inbounds float* %a, i64 %idx0
+  %re = load float* %a0, align 4
+  %re.s = fmul float %re, %s
+  store float %re.s, float* %a0, align 4
+  %a1 = getelementptr inbounds float* %a, i64 %idx1
+  %im = load float* %a1, align 4
+  %im.s = fmul float %im, %s
+  store float %im.s, float* %a1, align 4
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; RGB to grayscale:
+;   for (int i = 0; i < n; i++)
+;     out[i] = rgb[3*i] + rgb[3*i+1] + rgb[3*i+2];
+; The members are loaded in a different order than they appear in memory.
+
+;CHECK-LABEL: @stride3(
+;CHECK: %[[WIDE:.*]] = load <12 x i8>* {{.*}}, align 1
+;CHECK-DAG: shufflevector <12 x i8> %[[WIDE]], <12 x i8> undef, <4 x i32> <i32 0, i32 3, i32 6, i32 9>
+;CHECK-DAG: shufflevector <12 x i8> %[[WIDE]], <12 x i8> undef, <4 x i32> <i32 1, i32 4, i32 7, i32 10>
+;CHECK-DAG: shufflevector <12 x i8> %[[WIDE]], <12 x i8> undef, <4 x i32> <i32 2, i32 5, i32 8, i32 11>
+;CHECK: store <4 x i8>
+;CHECK: ret void
+define void @stride3(i8* noalias nocapture %rgb, i8* noalias nocapture %out, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %r.idx = mul nsw i64 %i, 3
+  %g.idx = add nsw i64 %r.idx, 1
+  %b.idx = add nsw i64 %r.idx, 2
+  %g.ptr = getelementptr inbounds i8* %rgb, i64 %g.idx
+  %g = load i8* %g.ptr, align 1
+  %r.ptr = getelementptr inbounds i8* %rgb, i64 %r.idx
+  %r = load i8* %r.ptr, align 1
+  %b.ptr = getelementptr inbounds i8* %rgb, i64 %b.idx
+  %b = load i8* %b.ptr, align 1
+  %rg = add i8 %r, %g
+  %rgb.sum = add i8 %rg, %b
+  %out.ptr = getelementptr inbounds i8* %out, i64 %i
+  store i8 %rgb.sum, i8* %out.ptr, align 1
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Fill an array of four-element tuples:
+;   for (int i = 0; i < n; i++) {
+;     a[4*i] = i; a[4*i+1] = x; a[4*i+2] = i; a[4*i+3] = x;
+;   }
+
+;CHECK-LABEL: @stride4(
+;CHECK: shufflevector <8 x i32> {{.*}}, <8 x i32> {{.*}}, <16 x i32> <i32 0, i32 4, i32 8, i32 12, i32 1, i32 5, i32 9, i32 13, i32 2, i32 6, i32 10, i32 14, i32 3, i32 7, i32 11, i32 15>
+;CHECK: store <16 x i32> {{.*}}, align 16
+;CHECK: ret void
+define void @stride4(i32* noalias nocapture %a, i32 %x, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %v = trunc i64 %i to i32
+  %idx0 = shl nsw i64 %i, 2
+  %idx1 = or i64 %idx0, 1
+  %idx2 = or i64 %idx0, 2
+  %idx3 = or i64 %idx0, 3
+  %a0 = getelementptr inbounds i32* %a, i64 %idx0
+  store i32 %v, i32* %a0, align 16
+  %a1 = getelementptr inbounds i32* %a, i64 %idx1
+  store i32 %x, i32* %a1, align 4
+  %a2 = getelementptr inbounds i32* %a, i64 %idx2
+  store i32 %v, i32* %a2, align 8
+  %a3 = getelementptr inbounds i32* %a, i64 %idx3
+  store i32 %x, i32* %a3, align 4
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Only two of the four tuple elements are read. A wide load would access the
+; elements in between, so the loads stay scalar.
+
+;CHECK-LABEL: @gap(
+;CHECK-NOT: load <16 x i32>
+;CHECK: ret i32
+define i32 @gap(i32* noalias nocapture %a, i32 %n) {
+entry:
+  %cmp = icmp sgt i32 %n, 0
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %i = phi i64 [ %i.next, %for.body ], [ 0, %entry ]
+  %sum = phi i32 [ %sum.next, %for.body ], [ 0, %entry ]
+  %idx0 = shl nsw i64 %i, 2
+  %idx1 = or i64 %idx0, 1
+  %a0 = getelementptr inbounds i32* %a, i64 %idx0
+  %x = load i32* %a0, align 4
+  %a1 = getelementptr inbounds i32* %a, i64 %idx1
+  %y = load i32* %a1, align 4
+  %xy = add i32 %x, %y
+  %sum.next = add i32 %sum, %xy
+  %i.next = add nsw i64 %i, 1
+  %i.trunc = trunc i64 %i.next to i32
+  %exitcond = icmp eq i32 %i.trunc, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  %sum.lcssa = phi i32 [ 0, %entry ], [ %sum.next, %for.body ]
+  ret i32 %sum.lcssa
+}
@@ -0,0 +1,120 @@
+; RUN: opt < %s -basicaa -slp-vectorizer -dce -S -mcpu=corei7 | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Bundles whose lanes alternate between add and sub are computed with one
+; vector operation per opcode and blended with a shuffle.
+;   c[0] = a[0] + b[0]; c[1] = a[1] - b[1];
+;   c[2] = a[2] + b[2]; c[3] = a[3] - b[3];
+
+; CHECK-LABEL: @faddsub(
+; CHECK: %[[A:.*]] = load <4 x float>*
+; CHECK: %[[B:.*]] = load <4 x float>*
+; CHECK: %[[ADD:.*]] = fadd <4 x float> %[[A]], %[[B]]
+; CHECK: %[[SUB:.*]] = fsub <4 x float> %[[A]], %[[B]]
+; CHECK: %[[R:.*]] = shufflevector <4 x float> %[[ADD]], <4 x float> %[[SUB]], <4 x i32> <i32 0, i32 5, i32 2, i32 7>
+; CHECK: store <4 x float> %[[R]]
+; CHECK: ret void
+define void @faddsub(float* noalias %a, float* noalias %b, float* noalias %c) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %r0 = fadd float %a0, %b0
+  store float %r0, float* %c, align 4
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %pc1 = getelementptr inbounds float* %c, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %r1 = fsub float %a1, %b1
+  store float %r1, float* %pc1, align 4
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %pc2 = getelementptr inbounds float* %c, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %r2 = fadd float %a2, %b2
+  store float %r2, float* %pc2, align 4
+  %pa3 = getelementptr inbounds float* %a, i64 3
+  %pb3 = getelementptr inbounds float* %b, i64 3
+  %pc3 = getelementptr inbounds float* %c, i64 3
+  %a3 = load float* %pa3, align 4
+  %b3 = load float* %pb3, align 4
+  %r3 = fsub float %a3, %b3
+  store float %r3, float* %pc3, align 4
+  ret void
+}
+
+; The alternation may start with either opcode.
+
+; CHECK-LABEL: @subadd(
+; CHECK: %[[SUB:.*]] = sub <4 x i32>
+; CHECK: %[[ADD:.*]] = add <4 x i32>
+; CHECK: shufflevector <4 x i32> %[[SUB]], <4 x i32> %[[ADD]], <4 x i32> <i32 0, i32 5, i32 2, i32 7>
+; CHECK: store <4 x i32>
+; CHECK: ret void
+define void @subadd(i32* noalias %a, i32* noalias %b, i32* noalias %c) {
+entry:
+  %a0 = load i32* %a, align 4
+  %b0 = load i32* %b, align 4
+  %r0 = sub i32 %a0, %b0
+  store i32 %r0, i32* %c, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %pb1 = getelementptr inbounds i32* %b, i64 1
+  %pc1 = getelementptr inbounds i32* %c, i64 1
+  %a1 = load i32* %pa1, align 4
+  %b1 = load i32* %pb1, align 4
+  %r1 = add i32 %a1, %b1
+  store i32 %r1, i32* %pc1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %pb2 = getelementptr inbounds i32* %b, i64 2
+  %pc2 = getelementptr inbounds i32* %c, i64 2
+  %a2 = load i32* %pa2, align 4
+  %b2 = load i32* %pb2, align 4
+  %r2 = sub i32 %a2, %b2
+  store i32 %r2, i32* %pc2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %pb3 = getelementptr inbounds i32* %b, i64 3
+  %pc3 = getelementptr inbounds i32* %c, i64 3
+  %a3 = load i32* %pa3, align 4
+  %b3 = load i32* %pb3, align 4
+  %r3 = add i32 %a3, %b3
+  store i32 %r3, i32* %pc3, align 4
+  ret void
+}
+
+; Lanes that do not strictly alternate are not blended.
+
+; CHECK-LABEL: @no_alternation(
+; CHECK-NOT: shufflevector
+; CHECK: ret void
+define void @no_alternation(float* noalias %a, float* noalias %b, float* noalias %c) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %r0 = fadd float %a0, %b0
+  store float %r0, float* %c, align 4
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %pc1 = getelementptr inbounds float* %c, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %r1 = fadd float %a1, %b1
+  store float %r1, float* %pc1, align 4
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %pc2 = getelementptr inbounds float* %c, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %r2 = fsub float %a2, %b2
+  store float %r2, float* %pc2, align 4
+  %pa3 = getelementptr inbounds float* %a, i64 3
+  %pb3 = getelementptr inbounds float* %b, i64 3
+  %pc3 = getelementptr inbounds float* %c, i64 3
+  %a3 = load float* %pa3, align 4
+  %b3 = load float* %pb3, align 4
+  %r3 = fsub float %a3, %b3
+  store float %r3, float* %pc3, align 4
+  ret void
+}
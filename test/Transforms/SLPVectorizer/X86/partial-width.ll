@@ -0,0 +1,89 @@
+; RUN: opt < %s -basicaa -slp-vectorizer -dce -S -mcpu=corei7 | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Chains that are not a multiple of the vector width are vectorized with
+; narrower vectors where possible. A three element float vector is stored as
+; a pair of floats plus a scalar:
+;   c[0] = a[0] * b[0]; c[1] = a[1] * b[1]; c[2] = a[2] * b[2];
+
+; CHECK-LABEL: @vec3(
+; CHECK: fmul <2 x float>
+; CHECK: store <2 x float>
+; CHECK: fmul float
+; CHECK: store float
+; CHECK: ret void
+define void @vec3(float* noalias %a, float* noalias %b, float* noalias %c) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %r0 = fmul float %a0, %b0
+  store float %r0, float* %c, align 4
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %pc1 = getelementptr inbounds float* %c, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %r1 = fmul float %a1, %b1
+  store float %r1, float* %pc1, align 4
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %pc2 = getelementptr inbounds float* %c, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %r2 = fmul float %a2, %b2
+  store float %r2, float* %pc2, align 4
+  ret void
+}
+
+; Six floats are stored as a vector of four plus a vector of two.
+
+; CHECK-LABEL: @vec6(
+; CHECK-DAG: store <4 x float>
+; CHECK-DAG: store <2 x float>
+; CHECK-NOT: store float
+; CHECK: ret void
+define void @vec6(float* noalias %a, float* noalias %b, float* noalias %c) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %r0 = fmul float %a0, %b0
+  store float %r0, float* %c, align 4
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %pc1 = getelementptr inbounds float* %c, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %r1 = fmul float %a1, %b1
+  store float %r1, float* %pc1, align 4
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %pc2 = getelementptr inbounds float* %c, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %r2 = fmul float %a2, %b2
+  store float %r2, float* %pc2, align 4
+  %pa3 = getelementptr inbounds float* %a, i64 3
+  %pb3 = getelementptr inbounds float* %b, i64 3
+  %pc3 = getelementptr inbounds float* %c, i64 3
+  %a3 = load float* %pa3, align 4
+  %b3 = load float* %pb3, align 4
+  %r3 = fmul float %a3, %b3
+  store float %r3, float* %pc3, align 4
+  %pa4 = getelementptr inbounds float* %a, i64 4
+  %pb4 = getelementptr inbounds float* %b, i64 4
+  %pc4 = getelementptr inbounds float* %c, i64 4
+  %a4 = load float* %pa4, align 4
+  %b4 = load float* %pb4, align 4
+  %r4 = fmul float %a4, %b4
+  store float %r4, float* %pc4, align 4
+  %pa5 = getelementptr inbounds float* %a, i64 5
+  %pb5 = getelementptr inbounds float* %b, i64 5
+  %pc5 = getelementptr inbounds float* %c, i64 5
+  %a5 = load float* %pa5, align 4
+  %b5 = load float* %pb5, align 4
+  %r5 = fmul float %a5, %b5
+  store float %r5, float* %pc5, align 4
+  ret void
+}
@@ -0,0 +1,29 @@
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/bad.prof -S \
+; RUN:   2> %t.err | FileCheck %s
+; RUN: FileCheck --check-prefix=BAD < %t.err %s
+; RUN: opt < %s -sample-profile -sample-profile-file=%t.missing -S \
+; RUN:   2> %t.err | FileCheck %s
+; RUN: FileCheck --check-prefix=MISSING < %t.err %s
+
+; A profile that can't be read is only warned about; the module is compiled
+; as if there were no profile.
+
+; BAD: warning: {{.*}}bad.prof:4: invalid branch count 'ten', ignoring the profile
+; MISSING: warning: could not open profile file '{{.*}}.missing': {{.*}}, ignoring it
+
+define void @foo(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0, !dbg !3
+; CHECK: br i1 %cmp, label %then, label %else, !dbg !{{[0-9]+}}{{$}}
+  br i1 %cmp, label %then, label %else, !dbg !3
+then:
+  ret void
+else:
+  ret void
+}
+
+!llvm.dbg.sp = !{!0}
+
+!0 = metadata !{i32 786478, metadata !1, null, metadata !"foo", metadata !"foo", metadata !"", i32 1, null, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 false, void (i32)* @foo, null, null, null, i32 1} ; [ DW_TAG_subprogram ]
+!1 = metadata !{metadata !"bad.c", metadata !"/tmp"}
+!3 = metadata !{i32 3, i32 0, metadata !0, null}
@@ -0,0 +1,80 @@
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/branch.prof -S | FileCheck %s
+
+; Branches and calls are matched to the profile through their source lines.
+
+declare void @bar()
+declare void @baz()
+
+define void @foo(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0, !dbg !3
+; CHECK: br i1 %cmp, label %then, label %else, !dbg !{{[0-9]+}}, !prof ![[FOO_BR:[0-9]+]]
+  br i1 %cmp, label %then, label %else, !dbg !3
+
+then:
+; CHECK: call void @bar(), !dbg !{{[0-9]+}}, !prof ![[BAR:[0-9]+]]
+  call void @bar(), !dbg !4
+  br label %exit, !dbg !4
+
+else:
+; A call on a line without a record keeps its weights unset.
+; CHECK: call void @bar(), !dbg !{{[0-9]+}}{{$}}
+; CHECK: call void @baz(), !dbg !{{[0-9]+}}, !prof ![[BAZ:[0-9]+]]
+  call void @bar(), !dbg !5
+  call void @baz(), !dbg !6
+  br label %exit, !dbg !6
+
+exit:
+  ret void, !dbg !7
+}
+
+define i32 @switcher(i32 %x) {
+entry:
+; CHECK: switch i32 %x, label %d [
+; CHECK: ], !dbg !{{[0-9]+}}, !prof ![[SW:[0-9]+]]
+  switch i32 %x, label %d [
+    i32 1, label %a
+    i32 2, label %b
+    i32 3, label %c
+  ], !dbg !12
+a:
+  ret i32 1
+b:
+  ret i32 2
+c:
+  ret i32 3
+d:
+  %cmp = icmp sgt i32 %x, 10, !dbg !15
+; CHECK: br i1 %cmp, label %c, label %b, !dbg !{{[0-9]+}}{{$}}
+  br i1 %cmp, label %c, label %b, !dbg !15
+}
+
+; Functions without a profile are left untouched.
+; CHECK-LABEL: define void @no_profile(
+; CHECK: br i1 %cmp, label %then, label %else, !dbg !{{[0-9]+}}{{$}}
+define void @no_profile(i32 %x) {
+entry:
+  %cmp = icmp eq i32 %x, 0, !dbg !3
+  br i1 %cmp, label %then, label %else, !dbg !3
+then:
+  ret void
+else:
+  ret void
+}
+
+; CHECK-DAG: ![[FOO_BR]] = metadata !{metadata !"branch_weights", i32 10, i32 990}
+; CHECK-DAG: ![[BAR]] = metadata !{metadata !"branch_weights", i32 10}
+; CHECK-DAG: ![[BAZ]] = metadata !{metadata !"branch_weights", i32 990}
+; CHECK-DAG: ![[SW]] = metadata !{metadata !"branch_weights", i32 5, i32 0, i32 3000, i32 7}
+
+!llvm.dbg.sp = !{!0}
+
+!0 = metadata !{i32 786478, metadata !1, null, metadata !"foo", metadata !"foo", metadata !"", i32 1, null, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 false, void (i32)* @foo, null, null, null, i32 1} ; [ DW_TAG_subprogram ]
+!1 = metadata !{metadata !"branch.c", metadata !"/tmp"}
+!3 = metadata !{i32 3, i32 0, metadata !0, null}
+!4 = metadata !{i32 4, i32 0, metadata !0, null}
+!5 = metadata !{i32 5, i32 0, metadata !0, null}
+!6 = metadata !{i32 6, i32 0, metadata !0, null}
+!7 = metadata !{i32 7, i32 0, metadata !0, null}
+!12 = metadata !{i32 12, i32 0, metadata !0, null}
+!15 = metadata !{i32 15, i32 0, metadata !0, null}
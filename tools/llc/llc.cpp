@@ -15,11 +15,14 @@
 
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
@@ -53,6 +56,12 @@ InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
 
+static cl::opt<unsigned>
+CodeGenPartitions("codegen-partitions", cl::init(1u), cl::value_desc("N"),
+                  cl::desc("Split the module into N partitions and compile "
+                           "them in parallel; partition I > 0 is written to "
+                           "<output>.I"));
+
 static cl::opt<unsigned>
 TimeCompilations("time-compilations", cl::Hidden, cl::init(1u),
                  cl::value_desc("N"),
@@ -79,6 +88,9 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::init(false));
 
 static int compileModule(char**, LLVMContext&);
+static int compileModuleInPartitions(char **, Module *, TargetMachine &,
+                                     const TargetLibraryInfo *,
+                                     tool_output_file *);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
@@ -310,13 +322,21 @@ static int compileModule(char **argv, LLVMContext &Context) {
     (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
   if (!Out) return 1;
 
-  // Build up all of the passes that we want to do to the module.
-  PassManager PM;
-
   // Add an appropriate TargetLibraryInfo pass for the module's triple.
   TargetLibraryInfo *TLI = new TargetLibraryInfo(TheTriple);
   if (DisableSimplifyLibCalls)
     TLI->disableAllFunctions();
+
+  if (CodeGenPartitions > 1) {
+    OwningPtr<TargetLibraryInfo> TLIOwner(TLI);
+    Target.setAsmVerbosityDefault(true);
+    if (RelaxAll && FileType == TargetMachine::CGFT_ObjectFile)
+      Target.setMCRelaxAll(true);
+    return compileModuleInPartitions(argv, mod, Target, TLI, Out.get());
+  }
+
+  // Build up all of the passes that we want to do to the module.
+  PassManager PM;
   PM.add(TLI);
 
   // Add intenal analysis passes from the target machine.
@@ -381,3 +401,60 @@ static int compileModule(char **argv, LLVMContext &Context) {
 
   return 0;
 }
+
+/// compileModuleInPartitions - Generate code for the partitions of the module
+/// in parallel, partition 0 into Out and partition I into <output>.I.
+static int compileModuleInPartitions(char **argv, Module *mod,
+                                     TargetMachine &Target,
+                                     const TargetLibraryInfo *TLI,
+                                     tool_output_file *Out) {
+  if (OutputFilename == "-") {
+    errs() << argv[0] << ": -codegen-partitions needs an output file.\n";
+    return 1;
+  }
+  if (!StartAfter.empty() || !StopAfter.empty()) {
+    errs() << argv[0] << ": -start-after and -stop-after cannot be used "
+           << "with -codegen-partitions.\n";
+    return 1;
+  }
+
+  std::vector<tool_output_file *> Outs;
+  Outs.push_back(Out);
+  for (unsigned I = 1; I != CodeGenPartitions; ++I) {
+    std::string Error;
+    sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
+    if (FileType != TargetMachine::CGFT_AssemblyFile)
+      OpenFlags |= sys::fs::F_Binary;
+    std::string Name = OutputFilename + "." + utostr(I);
+    Outs.push_back(new tool_output_file(Name.c_str(), Error, OpenFlags));
+    if (!Error.empty()) {
+      errs() << Error << '\n';
+      for (unsigned J = 1, E = Outs.size(); J != E; ++J)
+        delete Outs[J];
+      return 1;
+    }
+  }
+
+  std::vector<formatted_raw_ostream *> OSs;
+  for (unsigned I = 0, E = Outs.size(); I != E; ++I)
+    OSs.push_back(new formatted_raw_ostream(Outs[I]->os()));
+
+  cl::PrintOptionValues();
+
+  std::string Error;
+  bool Failed = splitCodeGen(mod, OSs, Target, FileType, TLI, Error);
+
+  for (unsigned I = 0, E = Outs.size(); I != E; ++I) {
+    delete OSs[I];
+    if (!Failed)
+      Outs[I]->keep();
+    if (I)
+      delete Outs[I];
+  }
+
+  if (Failed) {
+    errs() << argv[0] << ": " << Error << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -27,6 +27,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdlib>
+#include <map>
 #include <memory>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
@@ -90,6 +91,7 @@ static cl::extrahelp MoreHelp(
   "  [o] - preserve original dates\n"
   "  [s] - create an archive index (cf. ranlib)\n"
   "  [S] - do not build a symbol table\n"
+  "  [T] - create a thin archive\n"
   "  [u] - update only files newer than archive contents\n"
   "\nMODIFIERS (generic):\n"
   "  [c] - do not warn if the library had to be created\n"
@@ -117,6 +119,7 @@ static bool OriginalDates = false; ///< 'o' modifier
 static bool OnlyUpdate = false;    ///< 'u' modifier
 static bool Verbose = false;       ///< 'v' modifier
 static bool Symtab = true;         ///< 's' modifier
+static bool Thin = false;          ///< 'T' modifier
 
 // Relative Positional Argument (for insert/move). This variable holds
 // the name of the archive member to which the 'a', 'b' or 'i' modifier
@@ -209,6 +212,9 @@ static ArchiveOperation parseCommandLine() {
     case 'S':
       Symtab = false;
       break;
+    case 'T':
+      Thin = true;
+      break;
     case 'u': OnlyUpdate = true; break;
     case 'v': Verbose = true; break;
     case 'a':
@@ -262,6 +268,9 @@ static ArchiveOperation parseCommandLine() {
     show_help("The 'o' modifier is only applicable to the 'x' operation");
   if (OnlyUpdate && Operation != ReplaceOrInsert)
     show_help("The 'u' modifier is only applicable to the 'r' operation");
+  if (Thin && Operation != QuickAppend && Operation != ReplaceOrInsert)
+    show_help("The 'T' modifier is only applicable to the 'q' and 'r' "
+              "operations");
 
   // Return the parsed operation to the caller
   return Operation;
@@ -365,14 +374,22 @@ static bool shouldCreateArchive(ArchiveOperation Op) {
 
 static void performReadOperation(ArchiveOperation Operation,
                                  object::Archive *OldArchive) {
+  // The members of a thin archive are the files it refers to.
+  if (Operation == Extract && OldArchive->isThin())
+    fail("Cannot extract members of a thin archive");
+
   for (object::Archive::child_iterator I = OldArchive->begin_children(),
                                        E = OldArchive->end_children();
        I != E; ++I) {
     StringRef Name;
     failIfError(I->getName(Name));
 
+    // Thin archive members can be named by their path or their file name.
     if (!Members.empty() &&
-        std::find(Members.begin(), Members.end(), Name) == Members.end())
+        std::find(Members.begin(), Members.end(), Name) == Members.end() &&
+        (!OldArchive->isThin() ||
+         std::find(Members.begin(), Members.end(),
+                   sys::path::filename(Name)) == Members.end()))
       continue;
 
     switch (Operation) {
@@ -448,7 +465,9 @@ class HasName {
 
 public:
   HasName(StringRef Name) : Name(Name) {}
-  bool operator()(StringRef Path) { return Name == sys::path::filename(Path); }
+  bool operator()(StringRef Path) {
+    return sys::path::filename(Name) == sys::path::filename(Path);
+  }
 };
 }
 
@@ -522,7 +541,7 @@ computeNewArchiveMembers(ArchiveOperation Operation,
       int Pos = Ret.size();
       StringRef Name;
       failIfError(I->getName(Name));
-      if (Name == PosName) {
+      if (sys::path::filename(Name) == PosName) {
         assert(AddAfter || AddBefore);
         if (AddBefore)
           InsertPos = Pos;
@@ -537,7 +556,7 @@ computeNewArchiveMembers(ArchiveOperation Operation,
         addMember(Ret, I, Name);
         break;
       case IA_AddNewMeber:
-        addMember(Ret, &*MemberI, Name);
+        addMember(Ret, &*MemberI, Thin ? StringRef(*MemberI) : Name);
         break;
       case IA_Delete:
         break;
@@ -545,7 +564,7 @@ computeNewArchiveMembers(ArchiveOperation Operation,
         addMember(Moved, I, Name);
         break;
       case IA_MoveNewMember:
-        addMember(Moved, &*MemberI, Name);
+        addMember(Moved, &*MemberI, Thin ? StringRef(*MemberI) : Name);
         break;
       }
       if (MemberI != Members.end())
@@ -570,7 +589,8 @@ computeNewArchiveMembers(ArchiveOperation Operation,
   for (std::vector<std::string>::iterator I = Members.begin(),
          E = Members.end();
        I != E; ++I, ++Pos) {
-    StringRef Name = sys::path::filename(*I);
+    // Thin archives refer to their members by path.
+    StringRef Name = Thin ? StringRef(*I) : sys::path::filename(*I);
     addMember(Ret, &*I, Name, Pos);
   }
 
@@ -630,7 +650,7 @@ static void writeStringTable(raw_fd_ostream &Out,
                                               E = Members.end();
        I != E; ++I) {
     StringRef Name = I->getName();
-    if (Name.size() < 16)
+    if (Name.size() < 16 && !Thin)
       continue;
     if (StartOffset == 0) {
       printWithSpacePadding(Out, "//", 58);
@@ -650,8 +670,31 @@ static void writeStringTable(raw_fd_ostream &Out,
   Out.seek(Pos);
 }
 
+typedef std::map<object::Archive::child_iterator, std::vector<StringRef> >
+    OldSymbolMap;
+
+// getOldSymbols - Collect the symbols the index of OldArchive lists for each
+// of its members. The symbol table of members that are kept is copied from
+// there instead of being rebuilt from their object files.
+static void getOldSymbols(object::Archive *OldArchive,
+                          OldSymbolMap &OldSymbols) {
+  if (!OldArchive || !OldArchive->hasSymbolTable() ||
+      OldArchive->kind() != object::Archive::K_GNU)
+    return;
+  for (object::Archive::symbol_iterator I = OldArchive->begin_symbols(),
+                                        E = OldArchive->end_symbols();
+       I != E; ++I) {
+    StringRef Name;
+    failIfError(I->getName(Name));
+    object::Archive::child_iterator Member;
+    failIfError(I->getMember(Member));
+    OldSymbols[Member].push_back(Name);
+  }
+}
+
 static void writeSymbolTable(
     raw_fd_ostream &Out, ArrayRef<NewArchiveIterator> Members,
+    const OldSymbolMap &OldSymbols,
     std::vector<std::pair<unsigned, unsigned> > &MemberOffsetRefs) {
   unsigned StartOffset = 0;
   unsigned MemberNum = 0;
@@ -660,6 +703,25 @@ static void writeSymbolTable(
   for (ArrayRef<NewArchiveIterator>::iterator I = Members.begin(),
                                               E = Members.end();
        I != E; ++I, ++MemberNum) {
+    OldSymbolMap::const_iterator Old = OldSymbols.end();
+    if (!I->isNewMember())
+      Old = OldSymbols.find(I->getOld());
+    if (Old != OldSymbols.end()) {
+      if (!StartOffset) {
+        printMemberHeader(Out, "", sys::TimeValue::now(), 0, 0, 0, 0);
+        StartOffset = Out.tell();
+        print32BE(Out, 0);
+      }
+      for (std::vector<StringRef>::const_iterator NI = Old->second.begin(),
+                                                  NE = Old->second.end();
+           NI != NE; ++NI) {
+        SymNames.push_back(*NI);
+        MemberOffsetRefs.push_back(std::make_pair(Out.tell(), MemberNum));
+        print32BE(Out, 0);
+      }
+      continue;
+    }
+
     object::ObjectFile *Obj;
     if (I->isNewMember()) {
       const char *Filename = I->getNew();
@@ -734,6 +796,26 @@ static void writeSymbolTable(
 
 static void performWriteOperation(ArchiveOperation Operation,
                                   object::Archive *OldArchive) {
+  // A thin archive stays thin.
+  if (OldArchive) {
+    if (Thin && !OldArchive->isThin())
+      fail("Cannot convert a regular archive to a thin one");
+    Thin = OldArchive->isThin();
+  }
+
+  // Paths in a thin archive are relative to the directory it is in. The
+  // members of an archive outside of the current directory are recorded by
+  // their absolute path instead.
+  if (Thin && !sys::path::parent_path(ArchiveName).empty()) {
+    for (std::vector<std::string>::iterator I = Members.begin(),
+                                            E = Members.end();
+         I != E; ++I) {
+      SmallString<128> Path(*I);
+      failIfError(sys::fs::make_absolute(Path), *I);
+      *I = Path.str();
+    }
+  }
+
   SmallString<128> TmpArchive;
   failIfError(sys::fs::createUniqueFile(ArchiveName + ".temp-archive-%%%%%%%.a",
                                         TmpArchiveFD, TmpArchive));
@@ -741,7 +823,7 @@ static void performWriteOperation(ArchiveOperation Operation,
   TemporaryOutput = TmpArchive.c_str();
   tool_output_file Output(TemporaryOutput, TmpArchiveFD);
   raw_fd_ostream &Out = Output.os();
-  Out << "!<arch>\n";
+  Out << (Thin ? "!<thin>\n" : "!<arch>\n");
 
   std::vector<NewArchiveIterator> NewMembers =
       computeNewArchiveMembers(Operation, OldArchive);
@@ -749,7 +831,9 @@ static void performWriteOperation(ArchiveOperation Operation,
   std::vector<std::pair<unsigned, unsigned> > MemberOffsetRefs;
 
   if (Symtab) {
-    writeSymbolTable(Out, NewMembers, MemberOffsetRefs);
+    OldSymbolMap OldSymbols;
+    getOldSymbols(OldArchive, OldSymbols);
+    writeSymbolTable(Out, NewMembers, OldSymbols, MemberOffsetRefs);
   }
 
   std::vector<unsigned> StringMapIndexes;
@@ -773,6 +857,7 @@ static void performWriteOperation(ArchiveOperation Operation,
     }
     Out.seek(Pos);
 
+    // The members of a thin archive are just a header.
     if (I->isNewMember()) {
       const char *FileName = I->getNew();
 
@@ -783,12 +868,13 @@ static void performWriteOperation(ArchiveOperation Operation,
       failIfError(sys::fs::status(FD, Status), FileName);
 
       OwningPtr<MemoryBuffer> File;
-      failIfError(MemoryBuffer::getOpenFile(FD, FileName, File,
-                                            Status.getSize(), false),
-                  FileName);
+      if (!Thin)
+        failIfError(MemoryBuffer::getOpenFile(FD, FileName, File,
+                                              Status.getSize(), false),
+                    FileName);
 
-      StringRef Name = sys::path::filename(FileName);
-      if (Name.size() < 16)
+      StringRef Name = I->getName();
+      if (Name.size() < 16 && !Thin)
         printMemberHeader(Out, Name, Status.getLastModificationTime(),
                           Status.getUser(), Status.getGroup(),
                           Status.permissions(), Status.getSize());
@@ -797,12 +883,14 @@ static void performWriteOperation(ArchiveOperation Operation,
                           Status.getLastModificationTime(), Status.getUser(),
                           Status.getGroup(), Status.permissions(),
                           Status.getSize());
-      Out << File->getBuffer();
+      if (!Thin)
+        Out << File->getBuffer();
+      close(FD);
     } else {
       object::Archive::child_iterator OldMember = I->getOld();
       StringRef Name = I->getName();
 
-      if (Name.size() < 16)
+      if (Name.size() < 16 && !Thin)
         printMemberHeader(Out, Name, OldMember->getLastModified(),
                           OldMember->getUID(), OldMember->getGID(),
                           OldMember->getAccessMode(), OldMember->getSize());
@@ -811,7 +899,8 @@ static void performWriteOperation(ArchiveOperation Operation,
                           OldMember->getLastModified(), OldMember->getUID(),
                           OldMember->getGID(), OldMember->getAccessMode(),
                           OldMember->getSize());
-      Out << OldMember->getBuffer();
+      if (!Thin)
+        Out << OldMember->getBuffer();
     }
 
     if (Out.tell() % 2)
@@ -52,6 +52,16 @@ static cl::opt<bool>
 PrintInlining("inlining", cl::init(false),
               cl::desc("Print all inlined frames for a given address"));
 
+static cl::list<std::string>
+FindNames("find", cl::value_desc("name"),
+          cl::desc("Print the debug info entries with the given name, looked "
+                   "up in the accelerator tables or pubnames"));
+
+static cl::opt<unsigned>
+NumThreads("threads", cl::init(1u), cl::value_desc("N"),
+           cl::desc("Parse compile units on N threads when dumping "
+                    ".debug_info or building address ranges"));
+
 static cl::opt<DIDumpType>
 DumpType("debug-dump", cl::init(DIDT_All),
   cl::desc("Dump of debug sections:"),
@@ -97,9 +107,14 @@ static void DumpInput(const StringRef &Filename) {
     return;
   }
 
-  OwningPtr<DIContext> DICtx(DIContext::getDWARFContext(Obj.get()));
+  OwningPtr<DIContext> DICtx(DIContext::getDWARFContext(Obj.get(), NumThreads));
 
-  if (Address == -1ULL) {
+  if (!FindNames.empty()) {
+    for (unsigned i = 0, e = FindNames.size(); i != e; ++i)
+      if (!DICtx->dumpDIEsNamed(outs(), FindNames[i]))
+        errs() << Filename << ": no debug info entry named '" << FindNames[i]
+               << "'\n";
+  } else if (Address == -1ULL) {
     outs() << Filename
            << ":\tfile format " << Obj->getFileFormatName() << "\n\n";
     // Dump the complete DWARF structure.
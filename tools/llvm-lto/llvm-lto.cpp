@@ -12,11 +12,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
@@ -36,6 +40,11 @@ static cl::opt<bool>
 DisableGVNLoadPRE("disable-gvn-loadpre", cl::init(false),
   cl::desc("Do not run the GVN load PRE pass"));
 
+static cl::opt<unsigned>
+CodeGenPartitions("codegen-partitions", cl::init(1u), cl::value_desc("N"),
+  cl::desc("Split the merged module into N partitions and compile them in "
+           "parallel, writing one object file per partition"));
+
 static cl::list<std::string>
 InputFilenames(cl::Positional, cl::OneOrMore,
   cl::desc("<input bitcode files>"));
@@ -125,7 +134,43 @@ int main(int argc, char **argv) {
   for (unsigned i = 0; i < DSOSymbols.size(); ++i)
     CodeGen.addDSOSymbol(DSOSymbols[i].c_str());
 
-  if (!OutputFilename.empty()) {
+  if (CodeGenPartitions > 1) {
+    std::string ErrorInfo;
+    std::vector<std::string> OutputNames;
+    CodeGen.setCodeGenPartitions(CodeGenPartitions);
+    if (!CodeGen.compile_to_files(OutputNames, DisableOpt, DisableInline,
+                                  DisableGVNLoadPRE, ErrorInfo)) {
+      errs() << argv[0]
+             << ": error compiling the code: " << ErrorInfo << "\n";
+      return 1;
+    }
+
+    // With -o, partition I > 0 goes to <output>.I.
+    for (unsigned i = 0, e = OutputNames.size(); i != e; ++i) {
+      std::string Name = OutputNames[i];
+      if (!OutputFilename.empty()) {
+        Name = OutputFilename;
+        if (i)
+          Name += "." + utostr(i);
+
+        OwningPtr<MemoryBuffer> Object;
+        if (error_code EC = MemoryBuffer::getFile(OutputNames[i], Object)) {
+          errs() << argv[0] << ": error reading the file '" << OutputNames[i]
+                 << "': " << EC.message() << "\n";
+          return 1;
+        }
+        raw_fd_ostream FileStream(Name.c_str(), ErrorInfo, sys::fs::F_Binary);
+        if (!ErrorInfo.empty()) {
+          errs() << argv[0] << ": error opening the file '" << Name
+                 << "': " << ErrorInfo << "\n";
+          return 1;
+        }
+        FileStream << Object->getBuffer();
+        sys::fs::remove(OutputNames[i]);
+      }
+      outs() << "Wrote native object file '" << Name << "'\n";
+    }
+  } else if (!OutputFilename.empty()) {
     size_t len = 0;
     std::string ErrorInfo;
     const void *Code = CodeGen.compile(&len, DisableOpt, DisableInline,
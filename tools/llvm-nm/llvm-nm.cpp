@@ -17,6 +17,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Object/Archive.h"
@@ -30,6 +31,7 @@
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 #include <algorithm>
@@ -117,6 +119,10 @@ namespace {
     cl::desc("Print the archive map"));
   cl::alias ArchiveMaps("s", cl::desc("Alias for --print-armap"),
                                  cl::aliasopt(ArchiveMap));
+
+  cl::opt<unsigned> NumThreads("threads", cl::init(1u), cl::value_desc("N"),
+    cl::desc("Read the symbols of N object files or archive members at "
+             "once"));
   bool PrintAddress = true;
 
   bool MultipleFiles = false;
@@ -127,7 +133,12 @@ namespace {
 }
 
 
+static void FlushJobs();
+
+/// error - Report a problem with a file. The queued jobs are printed first,
+/// so that diagnostics come out in input order along with the symbols.
 static void error(Twine message, Twine path = Twine()) {
+  FlushJobs();
   errs() << ToolName << ": " << path << ": " << message << ".\n";
 }
 
@@ -182,12 +193,49 @@ namespace {
       return false;
   }
 
-  StringRef CurrentFilename;
   typedef std::vector<NMSymbol> SymbolListT;
-  SymbolListT SymbolList;
+
+  /// NMJob - The symbols of one object file or bitcode module. A job prints
+  /// into buffers of its own, so that several jobs can run at once; the
+  /// buffers are written out in input order.
+  struct NMJob {
+    /// Output that goes before the symbols, such as the member name.
+    std::string Prefix;
+    /// The object file to dump, or null for a bitcode module.
+    ObjectFile *Obj;
+    OwningPtr<Binary> ObjOwner;
+    /// The bitcode to parse and dump, and the name of the file it came from
+    /// if failing to parse it is an error.
+    OwningPtr<MemoryBuffer> Bitcode;
+    std::string BitcodeFilename;
+
+    std::string Out;
+    std::string Err;
+    bool HadError;
+
+    NMJob() : Obj(0), HadError(false) {}
+  };
+
+  /// The jobs that have not been printed yet, and the files they refer to.
+  std::vector<NMJob *> Jobs;
+  std::vector<Binary *> JobBinaries;
+
+  /// Output that goes before the next job.
+  std::string PendingOutput;
+  raw_string_ostream PendingOS(PendingOutput);
+}
+
+static bool error(error_code ec, NMJob &Job) {
+  if (!ec)
+    return false;
+  raw_string_ostream OS(Job.Err);
+  OS << ToolName << ": : " << ec.message() << ".\n";
+  Job.HadError = true;
+  return true;
 }
 
-static void SortAndPrintSymbolList() {
+static void SortAndPrintSymbolList(raw_ostream &OS, SymbolListT &SymbolList,
+                                   StringRef CurrentFilename) {
   if (!NoSort) {
     if (NumericSort)
       std::sort(SymbolList.begin(), SymbolList.end(), CompareSymbolAddress);
@@ -198,13 +246,13 @@ static void SortAndPrintSymbolList() {
   }
 
   if (OutputFormat == posix && MultipleFiles) {
-    outs() << '\n' << CurrentFilename << ":\n";
+    OS << '\n' << CurrentFilename << ":\n";
   } else if (OutputFormat == bsd && MultipleFiles) {
-    outs() << "\n" << CurrentFilename << ":\n";
+    OS << "\n" << CurrentFilename << ":\n";
   } else if (OutputFormat == sysv) {
-    outs() << "\n\nSymbols from " << CurrentFilename << ":\n\n"
-           << "Name                  Value   Class        Type"
-           << "         Size   Line  Section\n";
+    OS << "\n\nSymbols from " << CurrentFilename << ":\n\n"
+       << "Name                  Value   Class        Type"
+       << "         Size   Line  Section\n";
   }
 
   for (SymbolListT::iterator i = SymbolList.begin(),
@@ -231,30 +279,29 @@ static void SortAndPrintSymbolList() {
       format("%08" PRIx64, i->Size).print(SymbolSizeStr, sizeof(SymbolSizeStr));
 
     if (OutputFormat == posix) {
-      outs() << i->Name << " " << i->TypeChar << " "
-             << SymbolAddrStr << SymbolSizeStr << "\n";
+      OS << i->Name << " " << i->TypeChar << " "
+         << SymbolAddrStr << SymbolSizeStr << "\n";
     } else if (OutputFormat == bsd) {
       if (PrintAddress)
-        outs() << SymbolAddrStr << ' ';
+        OS << SymbolAddrStr << ' ';
       if (PrintSize) {
-        outs() << SymbolSizeStr;
+        OS << SymbolSizeStr;
         if (i->Size != object::UnknownAddressOrSize)
-          outs() << ' ';
+          OS << ' ';
       }
-      outs() << i->TypeChar << " " << i->Name  << "\n";
+      OS << i->TypeChar << " " << i->Name  << "\n";
     } else if (OutputFormat == sysv) {
       std::string PaddedName (i->Name);
       while (PaddedName.length () < 20)
         PaddedName += " ";
-      outs() << PaddedName << "|" << SymbolAddrStr << "|   "
-             << i->TypeChar
-             << "  |                  |" << SymbolSizeStr << "|     |\n";
+      OS << PaddedName << "|" << SymbolAddrStr << "|   "
+         << i->TypeChar
+         << "  |                  |" << SymbolSizeStr << "|     |\n";
     }
   }
 
   SymbolList.clear();
 }
-
 static char TypeCharForSymbol(GlobalValue &GV) {
   if (GV.isDeclaration())                                  return 'U';
   if (GV.hasLinkOnceLinkage())                             return 'C';
@@ -272,7 +319,8 @@ static char TypeCharForSymbol(GlobalValue &GV) {
                                                            return '?';
 }
 
-static void DumpSymbolNameForGlobalValue(GlobalValue &GV) {
+static void DumpSymbolNameForGlobalValue(GlobalValue &GV,
+                                         SymbolListT &SymbolList) {
   // Private linkage and available_externally linkage don't exist in symtab.
   if (GV.hasPrivateLinkage() ||
       GV.hasLinkerPrivateLinkage() ||
@@ -291,19 +339,24 @@ static void DumpSymbolNameForGlobalValue(GlobalValue &GV) {
   SymbolList.push_back(s);
 }
 
-static void DumpSymbolNamesFromModule(Module *M) {
-  CurrentFilename = M->getModuleIdentifier();
-  std::for_each (M->begin(), M->end(), DumpSymbolNameForGlobalValue);
-  std::for_each (M->global_begin(), M->global_end(),
-                 DumpSymbolNameForGlobalValue);
+static void DumpSymbolNamesFromModule(Module *M, raw_ostream &OS) {
+  SymbolListT SymbolList;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    DumpSymbolNameForGlobalValue(*I, SymbolList);
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I)
+    DumpSymbolNameForGlobalValue(*I, SymbolList);
   if (!WithoutAliases)
-    std::for_each (M->alias_begin(), M->alias_end(),
-		   DumpSymbolNameForGlobalValue);
+    for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+         I != E; ++I)
+      DumpSymbolNameForGlobalValue(*I, SymbolList);
 
-  SortAndPrintSymbolList();
+  SortAndPrintSymbolList(OS, SymbolList, M->getModuleIdentifier());
 }
 
-static void DumpSymbolNamesFromObject(ObjectFile *obj) {
+static void DumpSymbolNamesFromObject(ObjectFile *obj, raw_ostream &OS,
+                                      NMJob &Job) {
+  SymbolListT SymbolList;
   error_code ec;
   symbol_iterator ibegin = obj->begin_symbols();
   symbol_iterator iend = obj->end_symbols();
@@ -312,30 +365,111 @@ static void DumpSymbolNamesFromObject(ObjectFile *obj) {
     iend = obj->end_dynamic_symbols();
   }
   for (symbol_iterator i = ibegin; i != iend; i.increment(ec)) {
-    if (error(ec)) break;
+    if (error(ec, Job)) break;
     uint32_t symflags;
-    if (error(i->getFlags(symflags))) break;
+    if (error(i->getFlags(symflags), Job)) break;
     if (!DebugSyms && (symflags & SymbolRef::SF_FormatSpecific))
       continue;
     NMSymbol s;
     s.Size = object::UnknownAddressOrSize;
     s.Address = object::UnknownAddressOrSize;
     if (PrintSize || SizeSort) {
-      if (error(i->getSize(s.Size))) break;
+      if (error(i->getSize(s.Size), Job)) break;
     }
     if (PrintAddress)
-      if (error(i->getAddress(s.Address))) break;
-    if (error(i->getNMTypeChar(s.TypeChar))) break;
-    if (error(i->getName(s.Name))) break;
+      if (error(i->getAddress(s.Address), Job)) break;
+    if (error(i->getNMTypeChar(s.TypeChar), Job)) break;
+    if (error(i->getName(s.Name), Job)) break;
     SymbolList.push_back(s);
   }
 
-  CurrentFilename = obj->getFileName();
-  SortAndPrintSymbolList();
+  SortAndPrintSymbolList(OS, SymbolList, obj->getFileName());
+}
+
+static void RunJob(NMJob &Job) {
+  raw_string_ostream OS(Job.Out);
+  if (Job.Obj) {
+    DumpSymbolNamesFromObject(Job.Obj, OS, Job);
+    return;
+  }
+
+  // Every job has a context of its own, so that jobs can run at once.
+  LLVMContext Context;
+  std::string ErrorMessage;
+  OwningPtr<Module> M(ParseBitcodeFile(Job.Bitcode.get(), Context,
+                                       &ErrorMessage));
+  if (M)
+    DumpSymbolNamesFromModule(M.get(), OS);
+  else if (!Job.BitcodeFilename.empty())
+    raw_string_ostream(Job.Err) << ToolName << ": " << Job.BitcodeFilename
+                                << ": " << ErrorMessage << ".\n";
+}
+
+static void RunJobAt(void *Arg, unsigned I) {
+  RunJob(*(*static_cast<std::vector<NMJob *> *>(Arg))[I]);
+}
+
+/// FlushJobs - Run the queued jobs, on several threads if asked to, and
+/// print what they produced in order.
+static void FlushJobs() {
+  if (NumThreads > 1 && Jobs.size() > 1 && !llvm_is_multithreaded())
+    llvm_start_multithreaded();
+  llvm_execute_in_parallel(RunJobAt, &Jobs, Jobs.size(), NumThreads);
+
+  for (std::vector<NMJob *>::iterator I = Jobs.begin(), E = Jobs.end();
+       I != E; ++I) {
+    NMJob *Job = *I;
+    outs() << Job->Prefix;
+    if (!Job->Err.empty()) {
+      outs().flush();
+      errs() << Job->Err;
+    }
+    outs() << Job->Out;
+    HadError |= Job->HadError;
+    delete Job;
+  }
+  Jobs.clear();
+
+  for (std::vector<Binary *>::iterator I = JobBinaries.begin(),
+                                       E = JobBinaries.end();
+       I != E; ++I)
+    delete *I;
+  JobBinaries.clear();
+
+  outs() << PendingOS.str();
+  PendingOutput.clear();
+  // Anything written to errs() next must not overtake this.
+  outs().flush();
+}
+
+/// AddJob - Queue Job behind the output so far. A batch of a few jobs per
+/// thread is run at once, which keeps the files that are held open and the
+/// buffered output small.
+static void AddJob(NMJob *Job) {
+  Job->Prefix = PendingOS.str();
+  PendingOutput.clear();
+  Jobs.push_back(Job);
+  if (Jobs.size() >= 8 * std::max(1u, unsigned(NumThreads)))
+    FlushJobs();
+}
+
+static void AddObjectJob(ObjectFile *Obj, Binary *Owner) {
+  NMJob *Job = new NMJob();
+  Job->Obj = Obj;
+  Job->ObjOwner.reset(Owner);
+  AddJob(Job);
+}
+
+static void AddBitcodeJob(MemoryBuffer *Bitcode, StringRef Filename) {
+  NMJob *Job = new NMJob();
+  Job->Bitcode.reset(Bitcode);
+  Job->BitcodeFilename = Filename;
+  AddJob(Job);
 }
 
 static void DumpSymbolNamesFromFile(std::string &Filename) {
   if (Filename != "-" && !sys::fs::exists(Filename)) {
+    FlushJobs();
     errs() << ToolName << ": '" << Filename << "': " << "No such file\n";
     return;
   }
@@ -346,18 +480,8 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
 
   sys::fs::file_magic magic = sys::fs::identify_magic(Buffer->getBuffer());
 
-  LLVMContext &Context = getGlobalContext();
-  std::string ErrorMessage;
   if (magic == sys::fs::file_magic::bitcode) {
-    Module *Result = 0;
-    Result = ParseBitcodeFile(Buffer.get(), Context, &ErrorMessage);
-    if (Result) {
-      DumpSymbolNamesFromModule(Result);
-      delete Result;
-    } else {
-      error(ErrorMessage, Filename);
-      return;
-    }
+    AddBitcodeJob(Buffer.take(), Filename);
   } else if (magic == sys::fs::file_magic::archive) {
     OwningPtr<Binary> arch;
     if (error(object::createBinary(Buffer.take(), arch), Filename))
@@ -368,7 +492,7 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
         object::Archive::symbol_iterator I = a->begin_symbols();
         object::Archive::symbol_iterator E = a->end_symbols();
         if (I !=E) {
-          outs() << "Archive map" << "\n";
+          PendingOS << "Archive map" << "\n";
           for (; I != E; ++I) {
             object::Archive::child_iterator c;
             StringRef symname;
@@ -379,9 +503,9 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
               return;
             if (error(c->getName(filename)))
               return;
-            outs() << symname << " in " << filename << "\n";
+            PendingOS << symname << " in " << filename << "\n";
           }
-          outs() << "\n";
+          PendingOS << "\n";
         }
       }
 
@@ -392,22 +516,18 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
           // Try opening it as a bitcode file.
           OwningPtr<MemoryBuffer> buff;
           if (error(i->getMemoryBuffer(buff)))
-            return;
-          Module *Result = 0;
+            break;
           if (buff)
-            Result = ParseBitcodeFile(buff.get(), Context, &ErrorMessage);
-
-          if (Result) {
-            DumpSymbolNamesFromModule(Result);
-            delete Result;
-          }
+            AddBitcodeJob(buff.take(), "");
           continue;
         }
         if (object::ObjectFile *o = dyn_cast<ObjectFile>(child.get())) {
-          outs() << o->getFileName() << ":\n";
-          DumpSymbolNamesFromObject(o);
+          PendingOS << o->getFileName() << ":\n";
+          AddObjectJob(o, child.take());
         }
       }
+      // The members refer to the archive until they have been printed.
+      JobBinaries.push_back(arch.take());
     }
   } else if (magic == sys::fs::file_magic::macho_universal_binary) {
     OwningPtr<Binary> Bin;
@@ -422,17 +542,20 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
          I != E; ++I) {
       OwningPtr<ObjectFile> Obj;
       if (!I->getAsObjectFile(Obj)) {
-        outs() << Obj->getFileName() << ":\n";
-        DumpSymbolNamesFromObject(Obj.get());
+        PendingOS << Obj->getFileName() << ":\n";
+        ObjectFile *O = Obj.take();
+        AddObjectJob(O, O);
       }
     }
+    JobBinaries.push_back(Bin.take());
   } else if (magic.is_object()) {
     OwningPtr<Binary> obj;
     if (error(object::createBinary(Buffer.take(), obj), Filename))
       return;
     if (object::ObjectFile *o = dyn_cast<ObjectFile>(obj.get()))
-      DumpSymbolNamesFromObject(o);
+      AddObjectJob(o, obj.take());
   } else {
+    FlushJobs();
     errs() << ToolName << ": " << Filename << ": "
            << "unrecognizable file type\n";
     HadError = true;
@@ -470,6 +593,7 @@ int main(int argc, char **argv) {
 
   std::for_each(InputFilenames.begin(), InputFilenames.end(),
                 DumpSymbolNamesFromFile);
+  FlushJobs();
 
   if (HadError)
     return 1;
@@ -410,7 +410,7 @@ static void DisassembleInputMachO2(StringRef Filename,
         if (DTI != Dices.end()){
           uint16_t Length;
           DTI->second.getLength(Length);
-          DumpBytes(StringRef(Bytes.data() + Index, Length));
+          DumpBytes(StringRef(Bytes.data() + Index, Length), outs());
           uint16_t Kind;
           DTI->second.getKind(Kind);
           DumpDataInCode(Bytes.data() + Index, Length, Kind);
@@ -419,7 +419,7 @@ static void DisassembleInputMachO2(StringRef Filename,
 
         if (DisAsm->getInstruction(Inst, Size, memoryObject, Index,
                                    DebugOut, nulls())) {
-          DumpBytes(StringRef(Bytes.data() + Index, Size));
+          DumpBytes(StringRef(Bytes.data() + Index, Size), outs());
           IP->printInst(&Inst, outs(), "");
 
           // Print debug info.
@@ -453,7 +453,7 @@ static void DisassembleInputMachO2(StringRef Filename,
         if (DisAsm->getInstruction(Inst, InstSize, memoryObject, Index,
                                    DebugOut, nulls())) {
           outs() << format("%8" PRIx64 ":\t", SectAddress + Index);
-          DumpBytes(StringRef(Bytes.data() + Index, InstSize));
+          DumpBytes(StringRef(Bytes.data() + Index, InstSize), outs());
           IP->printInst(&Inst, outs(), "");
           outs() << "\n";
         } else {
@@ -31,6 +31,7 @@
 #include "llvm/MC/MCInstrAnalysis.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCModule.h"
+#include "llvm/MC/MCModuleBinary.h"
 #include "llvm/MC/MCModuleYAML.h"
 #include "llvm/MC/MCObjectDisassembler.h"
 #include "llvm/MC/MCObjectFileInfo.h"
@@ -49,6 +50,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/GraphWriter.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/MemoryObject.h"
@@ -57,6 +59,9 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/StringRefMemoryObject.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
 #include <algorithm>
@@ -147,6 +152,23 @@ YAMLCFG("yaml-cfg",
         cl::desc("Create a CFG and write it as a YAML MCModule."),
         cl::value_desc("yaml output file"));
 
+static cl::opt<std::string>
+CFGCache("cfg-cache",
+         cl::desc("With -cfg or -yaml-cfg, read the CFG from this file if it "
+                  "was created for the same object, otherwise create it and "
+                  "write it there"),
+         cl::value_desc("cache file"));
+
+static cl::opt<unsigned>
+DecodeBenchmark("decode-benchmark", cl::init(0u), cl::value_desc("N"),
+                cl::desc("Decode the text sections N times and print the "
+                         "decoding throughput instead of disassembling"));
+
+static cl::opt<unsigned>
+NumThreads("threads", cl::init(1u), cl::value_desc("N"),
+           cl::desc("Disassemble on N threads, in chunks split on symbol "
+                    "boundaries"));
+
 static StringRef ToolName;
 
 bool llvm::error(error_code ec) {
@@ -185,6 +207,45 @@ static const Target *getTarget(const ObjectFile *Obj = NULL) {
   return TheTarget;
 }
 
+// The CFG cache is only valid for the exact same object and target.
+static std::string getCFGCacheKey(const ObjectFile *Obj) {
+  MD5 Hash;
+  Hash.update(Obj->getData());
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Digest;
+  MD5::stringifyResult(Result, Digest);
+  return (Twine(TripleName) + ":" + Digest.str()).str();
+}
+
+static void loadCFGCache(OwningPtr<MCModule> &Mod, StringRef Key,
+                         const MCInstrInfo &MII, const MCRegisterInfo &MRI) {
+  OwningPtr<MemoryBuffer> Buf;
+  if (MemoryBuffer::getFile(CFGCache, Buf))
+    return;
+  StringRef Err = binary2mcmodule(Mod, Buf->getBuffer(), Key, MII, MRI);
+  if (!Err.empty())
+    errs() << ToolName << ": warning: ignoring CFG cache '" << CFGCache
+           << "': " << Err << '\n';
+}
+
+static void writeCFGCache(const MCModule &Mod, StringRef Key,
+                          const MCInstrInfo &MII, const MCRegisterInfo &MRI) {
+  std::string Error;
+  raw_fd_ostream Out(CFGCache.c_str(), Error, sys::fs::F_Binary);
+  if (!Error.empty()) {
+    errs() << ToolName << ": warning: " << Error << '\n';
+    return;
+  }
+  StringRef Err = mcmodule2binary(Out, Mod, Key, MII, MRI);
+  if (!Err.empty()) {
+    errs() << ToolName << ": warning: can't write CFG cache '" << CFGCache
+           << "': " << Err << '\n';
+    Out.close();
+    sys::fs::remove(CFGCache.c_str());
+  }
+}
+
 // Write a graphviz file for the CFG inside an MCFunction.
 // FIXME: Use GraphWriter
 static void emitDOTFile(const char *FileName, const MCFunction &f,
@@ -232,7 +293,7 @@ static void emitDOTFile(const char *FileName, const MCFunction &f,
   Out << "}\n";
 }
 
-void llvm::DumpBytes(StringRef bytes) {
+void llvm::DumpBytes(StringRef bytes, raw_ostream &OS) {
   static const char hex_rep[] = "0123456789abcdef";
   // FIXME: The real way to do this is to figure out the longest instruction
   //        and align to that size before printing. I'll fix this when I get
@@ -255,7 +316,7 @@ void llvm::DumpBytes(StringRef bytes) {
   }
 
   output[sizeof(output) - 1] = 0;
-  outs() << output;
+  OS << output;
 }
 
 bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
@@ -265,6 +326,340 @@ bool llvm::RelocAddressLess(RelocationRef a, RelocationRef b) {
   return a_addr < b_addr;
 }
 
+namespace {
+/// DisasmTarget - What disassembles and prints the instructions of an object
+/// file. Disassemblers and symbolizers keep state, so every thread that
+/// disassembles needs a DisasmTarget of its own.
+struct DisasmTarget {
+  OwningPtr<const MCObjectFileInfo> MOFI;
+  OwningPtr<MCContext> Ctx;
+  OwningPtr<MCDisassembler> DisAsm;
+  OwningPtr<MCInstPrinter> IP;
+};
+
+/// DisasmSection - A text section, with its symbols and relocations.
+struct DisasmSection {
+  StringRef Bytes;
+  uint64_t SectionAddr;
+  uint64_t SectSize;
+  std::vector<std::pair<uint64_t, StringRef> > Symbols;
+  std::vector<RelocationRef> Rels;
+  /// The first relocation that has not been printed yet.
+  unsigned NextRel;
+};
+
+/// DisasmInst - Where the output of an instruction ends in the text of its
+/// chunk.
+struct DisasmInst {
+  uint64_t Index;
+  uint64_t Size;
+  size_t TextEnd;
+  bool Valid;
+};
+
+/// DisasmChunk - The symbols [SymBegin, SymEnd) of a section, or plain text
+/// if there is no section. Chunks are disassembled on their own and printed
+/// in order, along with the relocations of every instruction.
+struct DisasmChunk {
+  DisasmSection *Sec;
+  unsigned SymBegin;
+  unsigned SymEnd;
+  std::string Text;
+  std::vector<DisasmInst> Insts;
+};
+
+/// DisasmQueue - The chunks of an object file that have not been printed.
+struct DisasmQueue {
+  const ObjectFile *Obj;
+  const Target *TheTarget;
+  const MCRegisterInfo *MRI;
+  const MCAsmInfo *AsmInfo;
+  const MCSubtargetInfo *STI;
+  const MCInstrInfo *MII;
+  /// The DisasmTarget used when disassembling on a single thread.
+  DisasmTarget *Main;
+  std::vector<DisasmChunk *> Chunks;
+  std::vector<DisasmSection *> Sections;
+};
+}
+
+// The amount of code a chunk covers when disassembling on several threads.
+static const uint64_t DisasmChunkSize = 16 * 1024;
+
+static bool createDisasmTarget(const DisasmQueue &Q, DisasmTarget &DT) {
+  DT.DisAsm.reset(Q.TheTarget->createMCDisassembler(*Q.STI));
+  if (!DT.DisAsm) {
+    errs() << "error: no disassembler for target " << TripleName << "\n";
+    return false;
+  }
+
+  if (Symbolize) {
+    DT.MOFI.reset(new MCObjectFileInfo);
+    DT.Ctx.reset(new MCContext(Q.AsmInfo, Q.MRI, DT.MOFI.get()));
+    OwningPtr<MCRelocationInfo> RelInfo(
+      Q.TheTarget->createMCRelocationInfo(TripleName, *DT.Ctx.get()));
+    if (RelInfo) {
+      OwningPtr<MCSymbolizer> Symzer(
+        MCObjectSymbolizer::createObjectSymbolizer(*DT.Ctx.get(), RelInfo,
+                                                   Q.Obj));
+      if (Symzer)
+        DT.DisAsm->setSymbolizer(Symzer);
+    }
+  }
+
+  int AsmPrinterVariant = Q.AsmInfo->getAssemblerDialect();
+  DT.IP.reset(Q.TheTarget->createMCInstPrinter(
+      AsmPrinterVariant, *Q.AsmInfo, *Q.MII, *Q.MRI, *Q.STI));
+  if (!DT.IP) {
+    errs() << "error: no instruction printer for target " << TripleName
+      << '\n';
+    return false;
+  }
+  return true;
+}
+
+static void disassembleChunk(DisasmChunk &C, DisasmTarget &DT) {
+  const DisasmSection &Sec = *C.Sec;
+  const std::vector<std::pair<uint64_t, StringRef> > &Symbols = Sec.Symbols;
+  raw_string_ostream OS(C.Text);
+
+  SmallString<40> Comments;
+  raw_svector_ostream CommentStream(Comments);
+
+  ArrayRef<uint8_t> Bytes(reinterpret_cast<const uint8_t *>(Sec.Bytes.data()),
+                          Sec.Bytes.size());
+  uint64_t Size;
+  uint64_t Index;
+
+  // Disassemble symbol by symbol.
+  for (unsigned si = C.SymBegin, se = Symbols.size(); si != C.SymEnd; ++si) {
+    uint64_t Start = Symbols[si].first;
+    uint64_t End;
+    // The end is either the size of the section or the beginning of the next
+    // symbol.
+    if (si == se - 1)
+      End = Sec.SectSize;
+    // Make sure this symbol takes up space.
+    else if (Symbols[si + 1].first != Start)
+      End = Symbols[si + 1].first - 1;
+    else
+      // This symbol has the same address as the next symbol. Skip it.
+      continue;
+
+    OS << '\n' << Symbols[si].second << ":\n";
+
+    // Decoders do not log at all when handed nulls(), so chunks running at
+    // once can share it.
+#ifndef NDEBUG
+    raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
+#else
+    raw_ostream &DebugOut = nulls();
+#endif
+
+    for (Index = Start; Index < End; Index += Size) {
+      MCInst Inst;
+
+      DisasmInst I;
+      I.Index = Index;
+      I.Valid = DT.DisAsm->getInstructionFromBytes(
+          Inst, Size,
+          Index < Bytes.size() ? Bytes.slice(Index) : ArrayRef<uint8_t>(),
+          Sec.SectionAddr + Index, DebugOut, CommentStream);
+      if (I.Valid) {
+        OS << format("%8" PRIx64 ":", Sec.SectionAddr + Index);
+        if (!NoShowRawInsn) {
+          OS << "\t";
+          DumpBytes(StringRef(Sec.Bytes.data() + Index, Size), OS);
+        }
+        DT.IP->printInst(&Inst, OS, "");
+        OS << CommentStream.str();
+        Comments.clear();
+        OS << "\n";
+      } else if (Size == 0) {
+        Size = 1; // skip illegible bytes
+      }
+      I.Size = Size;
+      I.TextEnd = OS.tell();
+      C.Insts.push_back(I);
+    }
+  }
+}
+
+static void disassembleChunkAt(void *Arg, unsigned I) {
+  DisasmQueue &Q = *static_cast<DisasmQueue *>(Arg);
+  DisasmChunk &C = *Q.Chunks[I];
+  if (!C.Sec)
+    return;
+  if (Q.Main) {
+    disassembleChunk(C, *Q.Main);
+    return;
+  }
+  DisasmTarget DT;
+  if (createDisasmTarget(Q, DT))
+    disassembleChunk(C, DT);
+}
+
+/// printRelocations - Print the relocations of Sec up to the end of the
+/// instruction at Index.
+static void printRelocations(DisasmSection &Sec, uint64_t Index,
+                             uint64_t Size) {
+  for (unsigned e = Sec.Rels.size(); Sec.NextRel != e; ++Sec.NextRel) {
+    const RelocationRef &Rel = Sec.Rels[Sec.NextRel];
+    bool hidden = false;
+    uint64_t addr;
+    SmallString<16> name;
+    SmallString<32> val;
+
+    // If this relocation is hidden, skip it.
+    if (error(Rel.getHidden(hidden))) continue;
+    if (hidden) continue;
+
+    if (error(Rel.getOffset(addr))) continue;
+    // Stop when the relocation's address is past the current instruction.
+    if (addr >= Index + Size) break;
+    if (error(Rel.getTypeName(name))) continue;
+    if (error(Rel.getValueString(val))) continue;
+
+    outs() << format("\t\t\t%8" PRIx64 ": ", Sec.SectionAddr + addr) << name
+           << "\t" << val << "\n";
+  }
+}
+
+/// flushDisassembly - Disassemble the queued chunks, on several threads if
+/// asked to, and print them in order.
+static void flushDisassembly(DisasmQueue &Q) {
+  if (!Q.Main && Q.Chunks.size() > 1 && !llvm_is_multithreaded())
+    llvm_start_multithreaded();
+  llvm_execute_in_parallel(disassembleChunkAt, &Q, Q.Chunks.size(),
+                           Q.Main ? 1 : unsigned(NumThreads));
+
+  for (std::vector<DisasmChunk *>::iterator CI = Q.Chunks.begin(),
+                                            CE = Q.Chunks.end();
+       CI != CE; ++CI) {
+    DisasmChunk &C = **CI;
+    StringRef Text = C.Text;
+    size_t Pos = 0;
+    for (std::vector<DisasmInst>::iterator I = C.Insts.begin(),
+                                           E = C.Insts.end();
+         I != E; ++I) {
+      outs() << Text.slice(Pos, I->TextEnd);
+      Pos = I->TextEnd;
+      if (!I->Valid)
+        errs() << ToolName << ": warning: invalid instruction encoding\n";
+      // Print relocation for instruction.
+      printRelocations(*C.Sec, I->Index, I->Size);
+    }
+    outs() << Text.substr(Pos);
+    delete &C;
+  }
+  Q.Chunks.clear();
+}
+
+static void queueText(DisasmQueue &Q, StringRef Text) {
+  DisasmChunk *C = new DisasmChunk();
+  C->Sec = 0;
+  C->Text = Text;
+  Q.Chunks.push_back(C);
+}
+
+static void queueChunk(DisasmQueue &Q, DisasmSection *Sec, unsigned SymBegin,
+                       unsigned SymEnd) {
+  DisasmChunk *C = new DisasmChunk();
+  C->Sec = Sec;
+  C->SymBegin = SymBegin;
+  C->SymEnd = SymEnd;
+  Q.Chunks.push_back(C);
+  if (Q.Main || Q.Chunks.size() >= 16 * NumThreads)
+    flushDisassembly(Q);
+}
+
+/// error - Report ec after everything queued before it has been printed.
+static bool error(error_code ec, DisasmQueue &Q) {
+  if (!ec) return false;
+  flushDisassembly(Q);
+  return error(ec);
+}
+
+/// benchmarkDecoding - Decode the text sections of Obj DecodeBenchmark times,
+/// once an instruction at a time through a MemoryObject and once in bulk from
+/// the section contents, and print the instructions decoded per second.
+static void benchmarkDecoding(const ObjectFile *Obj,
+                              const MCDisassembler &DisAsm) {
+  std::vector<std::pair<uint64_t, StringRef> > Sections;
+  uint64_t NumBytes = 0;
+  error_code ec;
+  for (section_iterator i = Obj->begin_sections(),
+                        e = Obj->end_sections();
+                        i != e; i.increment(ec)) {
+    if (error(ec)) return;
+    bool text;
+    uint64_t SectionAddr;
+    StringRef Bytes;
+    if (error(i->isText(text))) return;
+    if (!text) continue;
+    if (error(i->getAddress(SectionAddr))) return;
+    if (error(i->getContents(Bytes))) return;
+    Sections.push_back(std::make_pair(SectionAddr, Bytes));
+    NumBytes += Bytes.size();
+  }
+
+  // One instruction at a time, as the disassembler used to be driven.
+  uint64_t NumInsts = 0;
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  for (unsigned Round = 0; Round != DecodeBenchmark; ++Round) {
+    for (unsigned si = 0, se = Sections.size(); si != se; ++si) {
+      StringRefMemoryObject Region(Sections[si].second, Sections[si].first);
+      uint64_t Size;
+      for (uint64_t Index = 0, End = Sections[si].second.size(); Index < End;
+           Index += Size) {
+        MCInst Inst;
+        if (DisAsm.getInstruction(Inst, Size, Region,
+                                  Sections[si].first + Index, nulls(),
+                                  nulls()) == MCDisassembler::Fail &&
+            Size == 0)
+          Size = 1;
+        ++NumInsts;
+      }
+    }
+  }
+  TimeRecord Single = TimeRecord::getCurrentTime(false);
+  Single -= Start;
+
+  // In bulk, reusing the same MCInsts.
+  uint64_t NumBulkInsts = 0;
+  std::vector<MCDisassembler::DecodedInst> Insts;
+  Start = TimeRecord::getCurrentTime(true);
+  for (unsigned Round = 0; Round != DecodeBenchmark; ++Round) {
+    for (unsigned si = 0, se = Sections.size(); si != se; ++si) {
+      ArrayRef<uint8_t> Bytes(
+          reinterpret_cast<const uint8_t *>(Sections[si].second.data()),
+          Sections[si].second.size());
+      uint64_t Address = Sections[si].first;
+      while (!Bytes.empty()) {
+        size_t N = DisAsm.getInstructions(Insts, Bytes, Address, nulls(),
+                                          nulls(), 4096);
+        const MCDisassembler::DecodedInst &Last = Insts[N - 1];
+        uint64_t Consumed = Last.Address + Last.Size - Address;
+        Bytes = Bytes.slice(std::min<uint64_t>(Consumed, Bytes.size()));
+        Address += Consumed;
+        NumBulkInsts += N;
+      }
+    }
+  }
+  TimeRecord Bulk = TimeRecord::getCurrentTime(false);
+  Bulk -= Start;
+
+  outs() << format("decoded %" PRIu64 " bytes\n", NumBytes * DecodeBenchmark);
+  outs() << format("getInstruction:  %" PRIu64 " instructions in %.3fs, "
+                   "%.0f instructions/s\n",
+                   NumInsts, Single.getWallTime(),
+                   NumInsts / std::max(Single.getWallTime(), 1e-9));
+  outs() << format("getInstructions: %" PRIu64 " instructions in %.3fs, "
+                   "%.0f instructions/s\n",
+                   NumBulkInsts, Bulk.getWallTime(),
+                   NumBulkInsts / std::max(Bulk.getWallTime(), 1e-9));
+}
+
 static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   const Target *TheTarget = getTarget(Obj);
   // getTarget() will have already issued a diagnostic if necessary, so
@@ -308,44 +703,44 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     return;
   }
 
-  OwningPtr<MCDisassembler> DisAsm(TheTarget->createMCDisassembler(*STI));
-  if (!DisAsm) {
-    errs() << "error: no disassembler for target " << TripleName << "\n";
-    return;
-  }
+  DisasmQueue Q;
+  Q.Obj = Obj;
+  Q.TheTarget = TheTarget;
+  Q.MRI = MRI.get();
+  Q.AsmInfo = AsmInfo.get();
+  Q.STI = STI.get();
+  Q.MII = MII.get();
 
-  OwningPtr<const MCObjectFileInfo> MOFI;
-  OwningPtr<MCContext> Ctx;
+  DisasmTarget Main;
+  if (!createDisasmTarget(Q, Main))
+    return;
+  MCDisassembler *DisAsm = Main.DisAsm.get();
+  MCInstPrinter *IP = Main.IP.get();
+  // With more than one thread every chunk gets a DisasmTarget of its own.
+  Q.Main = NumThreads > 1 ? 0 : &Main;
 
-  if (Symbolize) {
-    MOFI.reset(new MCObjectFileInfo);
-    Ctx.reset(new MCContext(AsmInfo.get(), MRI.get(), MOFI.get()));
-    OwningPtr<MCRelocationInfo> RelInfo(
-      TheTarget->createMCRelocationInfo(TripleName, *Ctx.get()));
-    if (RelInfo) {
-      OwningPtr<MCSymbolizer> Symzer(
-        MCObjectSymbolizer::createObjectSymbolizer(*Ctx.get(), RelInfo, Obj));
-      if (Symzer)
-        DisAsm->setSymbolizer(Symzer);
-    }
+  if (DecodeBenchmark) {
+    benchmarkDecoding(Obj, *DisAsm);
+    return;
   }
 
   OwningPtr<const MCInstrAnalysis>
     MIA(TheTarget->createMCInstrAnalysis(MII.get()));
 
-  int AsmPrinterVariant = AsmInfo->getAssemblerDialect();
-  OwningPtr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
-      AsmPrinterVariant, *AsmInfo, *MII, *MRI, *STI));
-  if (!IP) {
-    errs() << "error: no instruction printer for target " << TripleName
-      << '\n';
-    return;
-  }
-
   if (CFG || !YAMLCFG.empty()) {
-    OwningPtr<MCObjectDisassembler> OD(
-      new MCObjectDisassembler(*Obj, *DisAsm, *MIA));
-    OwningPtr<MCModule> Mod(OD->buildModule(/* withCFG */ true));
+    OwningPtr<MCModule> Mod;
+    std::string CacheKey;
+    if (!CFGCache.empty()) {
+      CacheKey = getCFGCacheKey(Obj);
+      loadCFGCache(Mod, CacheKey, *MII, *MRI);
+    }
+    if (!Mod) {
+      OwningPtr<MCObjectDisassembler> OD(
+        new MCObjectDisassembler(*Obj, *DisAsm, *MIA));
+      Mod.reset(OD->buildModule(/* withCFG */ true));
+      if (!CFGCache.empty())
+        writeCFGCache(*Mod, CacheKey, *MII, *MRI);
+    }
     for (MCModule::const_atom_iterator AI = Mod->atom_begin(),
                                        AE = Mod->atom_end();
                                        AI != AE; ++AI) {
@@ -366,7 +761,7 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
         static int filenum = 0;
         emitDOTFile((Twine((*FI)->getName()) + "_" +
                      utostr(filenum) + ".dot").str().c_str(),
-                      **FI, IP.get());
+                      **FI, IP);
         ++filenum;
       }
     }
@@ -386,28 +781,31 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
   for (section_iterator i = Obj->begin_sections(),
                         e = Obj->end_sections();
                         i != e; i.increment(ec)) {
-    if (error(ec)) break;
+    if (error(ec, Q)) break;
     bool text;
-    if (error(i->isText(text))) break;
+    if (error(i->isText(text), Q)) break;
     if (!text) continue;
 
-    uint64_t SectionAddr;
-    if (error(i->getAddress(SectionAddr))) break;
+    DisasmSection *Sec = new DisasmSection();
+    Q.Sections.push_back(Sec);
+    Sec->NextRel = 0;
+    uint64_t &SectionAddr = Sec->SectionAddr;
+    if (error(i->getAddress(SectionAddr), Q)) break;
 
     // Make a list of all the symbols in this section.
-    std::vector<std::pair<uint64_t, StringRef> > Symbols;
+    std::vector<std::pair<uint64_t, StringRef> > &Symbols = Sec->Symbols;
     for (symbol_iterator si = Obj->begin_symbols(),
                          se = Obj->end_symbols();
                          si != se; si.increment(ec)) {
       bool contains;
-      if (!error(i->containsSymbol(*si, contains)) && contains) {
+      if (!error(i->containsSymbol(*si, contains), Q) && contains) {
         uint64_t Address;
-        if (error(si->getAddress(Address))) break;
+        if (error(si->getAddress(Address), Q)) break;
         if (Address == UnknownAddressOrSize) continue;
         Address -= SectionAddr;
 
         StringRef Name;
-        if (error(si->getName(Name))) break;
+        if (error(si->getName(Name), Q)) break;
         Symbols.push_back(std::make_pair(Address, Name));
       }
     }
@@ -416,12 +814,12 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
     array_pod_sort(Symbols.begin(), Symbols.end());
 
     // Make a list of all the relocations for this section.
-    std::vector<RelocationRef> Rels;
+    std::vector<RelocationRef> &Rels = Sec->Rels;
     if (InlineRelocs) {
       for (relocation_iterator ri = i->begin_relocations(),
                                re = i->end_relocations();
                                ri != re; ri.increment(ec)) {
-        if (error(ec)) break;
+        if (error(ec, Q)) break;
         Rels.push_back(*ri);
       }
     }
@@ -436,101 +834,30 @@ static void DisassembleObject(const ObjectFile *Obj, bool InlineRelocs) {
       SegmentName = MachO->getSectionFinalSegmentName(DR);
     }
     StringRef name;
-    if (error(i->getName(name))) break;
-    outs() << "Disassembly of section ";
-    if (!SegmentName.empty())
-      outs() << SegmentName << ",";
-    outs() << name << ':';
+    if (error(i->getName(name), Q)) break;
+    queueText(Q, (Twine("Disassembly of section ") + SegmentName +
+                  (SegmentName.empty() ? "" : ",") + name + ":").str());
 
     // If the section has no symbols just insert a dummy one and disassemble
     // the whole section.
     if (Symbols.empty())
       Symbols.push_back(std::make_pair(0, name));
 
+    if (error(i->getContents(Sec->Bytes), Q)) break;
+    if (error(i->getSize(Sec->SectSize), Q)) break;
 
-    SmallString<40> Comments;
-    raw_svector_ostream CommentStream(Comments);
-
-    StringRef Bytes;
-    if (error(i->getContents(Bytes))) break;
-    StringRefMemoryObject memoryObject(Bytes, SectionAddr);
-    uint64_t Size;
-    uint64_t Index;
-    uint64_t SectSize;
-    if (error(i->getSize(SectSize))) break;
-
-    std::vector<RelocationRef>::const_iterator rel_cur = Rels.begin();
-    std::vector<RelocationRef>::const_iterator rel_end = Rels.end();
-    // Disassemble symbol by symbol.
-    for (unsigned si = 0, se = Symbols.size(); si != se; ++si) {
-      uint64_t Start = Symbols[si].first;
-      uint64_t End;
-      // The end is either the size of the section or the beginning of the next
-      // symbol.
-      if (si == se - 1)
-        End = SectSize;
-      // Make sure this symbol takes up space.
-      else if (Symbols[si + 1].first != Start)
-        End = Symbols[si + 1].first - 1;
-      else
-        // This symbol has the same address as the next symbol. Skip it.
+    // Split the section into chunks on symbol boundaries.
+    unsigned Begin = 0;
+    for (unsigned si = 1, se = Symbols.size(); si <= se; ++si) {
+      if (si != se && (Q.Main || Symbols[si].first - Symbols[Begin].first <
+                                     DisasmChunkSize))
         continue;
-
-      outs() << '\n' << Symbols[si].second << ":\n";
-
-#ifndef NDEBUG
-        raw_ostream &DebugOut = DebugFlag ? dbgs() : nulls();
-#else
-        raw_ostream &DebugOut = nulls();
-#endif
-
-      for (Index = Start; Index < End; Index += Size) {
-        MCInst Inst;
-
-        if (DisAsm->getInstruction(Inst, Size, memoryObject,
-                                   SectionAddr + Index,
-                                   DebugOut, CommentStream)) {
-          outs() << format("%8" PRIx64 ":", SectionAddr + Index);
-          if (!NoShowRawInsn) {
-            outs() << "\t";
-            DumpBytes(StringRef(Bytes.data() + Index, Size));
-          }
-          IP->printInst(&Inst, outs(), "");
-          outs() << CommentStream.str();
-          Comments.clear();
-          outs() << "\n";
-        } else {
-          errs() << ToolName << ": warning: invalid instruction encoding\n";
-          if (Size == 0)
-            Size = 1; // skip illegible bytes
-        }
-
-        // Print relocation for instruction.
-        while (rel_cur != rel_end) {
-          bool hidden = false;
-          uint64_t addr;
-          SmallString<16> name;
-          SmallString<32> val;
-
-          // If this relocation is hidden, skip it.
-          if (error(rel_cur->getHidden(hidden))) goto skip_print_rel;
-          if (hidden) goto skip_print_rel;
-
-          if (error(rel_cur->getOffset(addr))) goto skip_print_rel;
-          // Stop when rel_cur's address is past the current instruction.
-          if (addr >= Index + Size) break;
-          if (error(rel_cur->getTypeName(name))) goto skip_print_rel;
-          if (error(rel_cur->getValueString(val))) goto skip_print_rel;
-
-          outs() << format("\t\t\t%8" PRIx64 ": ", SectionAddr + addr) << name
-                 << "\t" << val << "\n";
-
-        skip_print_rel:
-          ++rel_cur;
-        }
-      }
+      queueChunk(Q, Sec, Begin, si);
+      Begin = si;
     }
   }
+  flushDisassembly(Q);
+  DeleteContainerPointers(Q.Sections);
 }
 
 static void PrintRelocations(const ObjectFile *o) {
@@ -871,6 +1198,10 @@ int main(int argc, char **argv) {
   if (InputFilenames.size() == 0)
     InputFilenames.push_back("a.out");
 
+  // The benchmark takes the place of the disassembly.
+  if (DecodeBenchmark)
+    Disassemble = true;
+
   if (!Disassemble
       && !Relocations
       && !SectionHeaders
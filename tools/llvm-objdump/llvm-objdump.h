@@ -23,6 +23,7 @@ namespace object {
   class RelocationRef;
 }
 class error_code;
+class raw_ostream;
 
 extern cl::opt<std::string> TripleName;
 extern cl::opt<std::string> ArchName;
@@ -30,7 +31,7 @@ extern cl::opt<std::string> ArchName;
 // Various helper functions.
 bool error(error_code ec);
 bool RelocAddressLess(object::RelocationRef a, object::RelocationRef b);
-void DumpBytes(StringRef bytes);
+void DumpBytes(StringRef bytes, raw_ostream &OS);
 void DisassembleInputMachO(StringRef Filename);
 void printCOFFUnwindInfo(const object::COFFObjectFile* o);
 void printELFFileHeader(const object::ObjectFile *o);
@@ -22,6 +22,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
+#include <algorithm>
 #include <sstream>
 #include <stdlib.h>
 
@@ -51,13 +52,33 @@ static void patchFunctionNameInDILineInfo(const std::string &NewFunctionName,
                         LineInfo.getLine(), LineInfo.getColumn());
 }
 
+namespace {
+  struct SymbolAddrOrder {
+    template <typename T> bool operator()(const T &LHS, const T &RHS) const {
+      return LHS.first < RHS.first;
+    }
+  };
+  struct SymbolAddrEq {
+    template <typename T> bool operator()(const T &LHS, const T &RHS) const {
+      return LHS.first.Addr == RHS.first.Addr;
+    }
+  };
+}
+
+void ModuleInfo::sortSymbols(SymbolListTy &Symbols) {
+  // Like inserting into a map, keep the first symbol seen at each address.
+  std::stable_sort(Symbols.begin(), Symbols.end(), SymbolAddrOrder());
+  Symbols.erase(std::unique(Symbols.begin(), Symbols.end(), SymbolAddrEq()),
+                Symbols.end());
+}
+
 ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
     : Module(Obj), DebugInfoContext(DICtx) {
   error_code ec;
   for (symbol_iterator si = Module->begin_symbols(), se = Module->end_symbols();
        si != se; si.increment(ec)) {
     if (error(ec))
-      return;
+      break;
     SymbolRef::Type SymbolType;
     if (error(si->getType(SymbolType)))
       continue;
@@ -84,20 +105,25 @@ ModuleInfo::ModuleInfo(ObjectFile *Obj, DIContext *DICtx)
       SymbolName = SymbolName.drop_front();
     // FIXME: If a function has alias, there are two entries in symbol table
     // with same address size. Make sure we choose the correct one.
-    SymbolMapTy &M = SymbolType == SymbolRef::ST_Function ? Functions : Objects;
+    SymbolListTy &M =
+        SymbolType == SymbolRef::ST_Function ? Functions : Objects;
     SymbolDesc SD = { SymbolAddress, SymbolSize };
-    M.insert(std::make_pair(SD, SymbolName));
+    M.push_back(std::make_pair(SD, SymbolName));
   }
+  sortSymbols(Functions);
+  sortSymbols(Objects);
 }
 
 bool ModuleInfo::getNameFromSymbolTable(SymbolRef::Type Type, uint64_t Address,
                                         std::string &Name, uint64_t &Addr,
                                         uint64_t &Size) const {
-  const SymbolMapTy &M = Type == SymbolRef::ST_Function ? Functions : Objects;
+  const SymbolListTy &M = Type == SymbolRef::ST_Function ? Functions : Objects;
   if (M.empty())
     return false;
   SymbolDesc SD = { Address, Address };
-  SymbolMapTy::const_iterator it = M.upper_bound(SD);
+  SymbolListTy::const_iterator it =
+      std::upper_bound(M.begin(), M.end(), std::make_pair(SD, StringRef()),
+                       SymbolAddrOrder());
   if (it == M.begin())
     return false;
   --it;
@@ -204,6 +230,44 @@ std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   return ss.str();
 }
 
+void LLVMSymbolizer::symbolizeCodeBatch(const std::string &ModuleName,
+                                        ArrayRef<uint64_t> ModuleOffsets,
+                                        std::vector<std::string> &Results) {
+  symbolizeBatch(ModuleName, false, ModuleOffsets, Results);
+}
+
+void LLVMSymbolizer::symbolizeDataBatch(const std::string &ModuleName,
+                                        ArrayRef<uint64_t> ModuleOffsets,
+                                        std::vector<std::string> &Results) {
+  symbolizeBatch(ModuleName, true, ModuleOffsets, Results);
+}
+
+void LLVMSymbolizer::symbolizeBatch(const std::string &ModuleName,
+                                    bool IsData,
+                                    ArrayRef<uint64_t> ModuleOffsets,
+                                    std::vector<std::string> &Results) {
+  // Traces repeat the same addresses a lot; look each one up only once, and
+  // in address order so that neighbouring lookups hit the same symbols, DIEs
+  // and line table rows.
+  std::vector<uint64_t> Sorted(ModuleOffsets.begin(), ModuleOffsets.end());
+  std::sort(Sorted.begin(), Sorted.end());
+  Sorted.erase(std::unique(Sorted.begin(), Sorted.end()), Sorted.end());
+
+  std::vector<std::string> SortedResults;
+  SortedResults.reserve(Sorted.size());
+  for (size_t i = 0, e = Sorted.size(); i != e; ++i)
+    SortedResults.push_back(IsData ? symbolizeData(ModuleName, Sorted[i])
+                                   : symbolizeCode(ModuleName, Sorted[i]));
+
+  Results.clear();
+  Results.reserve(ModuleOffsets.size());
+  for (size_t i = 0, e = ModuleOffsets.size(); i != e; ++i) {
+    size_t Index = std::lower_bound(Sorted.begin(), Sorted.end(),
+                                    ModuleOffsets[i]) - Sorted.begin();
+    Results.push_back(SortedResults[Index]);
+  }
+}
+
 void LLVMSymbolizer::flush() {
   DeleteContainerSeconds(Modules);
   DeleteContainerPointers(ParsedBinariesAndObjects);
@@ -388,7 +452,7 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
     Modules.insert(make_pair(ModuleName, (ModuleInfo *)0));
     return 0;
   }
-  DIContext *Context = DIContext::getDWARFContext(DbgObj);
+  DIContext *Context = DIContext::getDWARFContext(DbgObj, Opts.NumThreads);
   assert(Context);
   ModuleInfo *Info = new ModuleInfo(Obj, Context);
   Modules.insert(make_pair(ModuleName, Info));
@@ -13,6 +13,7 @@
 #ifndef LLVM_SYMBOLIZE_H
 #define LLVM_SYMBOLIZE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/DIContext.h"
@@ -21,6 +22,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -38,12 +40,13 @@ public:
     bool PrintInlining : 1;
     bool Demangle : 1;
     std::string DefaultArch;
+    unsigned NumThreads;
     Options(bool UseSymbolTable = true, bool PrintFunctions = true,
             bool PrintInlining = true, bool Demangle = true,
-            std::string DefaultArch = "")
+            std::string DefaultArch = "", unsigned NumThreads = 1)
         : UseSymbolTable(UseSymbolTable), PrintFunctions(PrintFunctions),
           PrintInlining(PrintInlining), Demangle(Demangle),
-          DefaultArch(DefaultArch) {
+          DefaultArch(DefaultArch), NumThreads(NumThreads) {
     }
   };
 
@@ -58,6 +61,15 @@ public:
   symbolizeCode(const std::string &ModuleName, uint64_t ModuleOffset);
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
+  // Symbolizes all the offsets in one module. Each distinct offset is looked
+  // up once, in increasing order. Results[i] is the result for
+  // ModuleOffsets[i].
+  void symbolizeCodeBatch(const std::string &ModuleName,
+                          ArrayRef<uint64_t> ModuleOffsets,
+                          std::vector<std::string> &Results);
+  void symbolizeDataBatch(const std::string &ModuleName,
+                          ArrayRef<uint64_t> ModuleOffsets,
+                          std::vector<std::string> &Results);
   void flush();
   static std::string DemangleName(const std::string &Name);
 private:
@@ -70,6 +82,9 @@ private:
   /// universal binary (or the binary itself if it is an object file).
   ObjectFile *getObjectFileFromBinary(Binary *Bin, const std::string &ArchName);
 
+  void symbolizeBatch(const std::string &ModuleName, bool IsData,
+                      ArrayRef<uint64_t> ModuleOffsets,
+                      std::vector<std::string> &Results);
   std::string printDILineInfo(DILineInfo LineInfo) const;
   static std::string DemangleGlobalName(const std::string &Name);
 
@@ -115,9 +130,11 @@ private:
       return s1.Addr < s2.Addr;
     }
   };
-  typedef std::map<SymbolDesc, StringRef> SymbolMapTy;
-  SymbolMapTy Functions;
-  SymbolMapTy Objects;
+  // Symbols sorted by address, with one entry per address.
+  typedef std::vector<std::pair<SymbolDesc, StringRef> > SymbolListTy;
+  static void sortSymbols(SymbolListTy &Symbols);
+  SymbolListTy Functions;
+  SymbolListTy Objects;
 };
 
 } // namespace symbolize
@@ -25,7 +25,9 @@
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -51,6 +53,16 @@ static cl::opt<std::string> ClDefaultArch("default-arch", cl::init(""),
                                           cl::desc("Default architecture "
                                                    "(for multi-arch objects)"));
 
+static cl::opt<unsigned>
+ClThreads("threads", cl::init(1u), cl::value_desc("N"),
+          cl::desc("Build the address ranges of a module's compile units on "
+                   "N threads"));
+
+static cl::opt<bool>
+ClBatch("batch", cl::init(false),
+        cl::desc("Read all addresses before symbolizing any of them, and "
+                 "look up each distinct address only once"));
+
 static bool parseCommand(bool &IsData, std::string &ModuleName,
                          uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
@@ -106,12 +118,50 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm symbolizer for compiler-rt\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle, ClDefaultArch);
+                               ClPrintInlining, ClDemangle, ClDefaultArch,
+                               ClThreads);
   LLVMSymbolizer Symbolizer(Opts);
 
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
+
+  if (ClBatch) {
+    // Group the requests by module and kind, and print the results in the
+    // order the requests came in.
+    typedef std::map<std::pair<std::string, bool>, std::vector<size_t> >
+        GroupMapTy;
+    GroupMapTy Groups;
+    std::vector<uint64_t> Offsets;
+    while (parseCommand(IsData, ModuleName, ModuleOffset)) {
+      Groups[std::make_pair(ModuleName, IsData)].push_back(Offsets.size());
+      Offsets.push_back(ModuleOffset);
+    }
+
+    std::vector<std::string> Results(Offsets.size());
+    std::vector<uint64_t> GroupOffsets;
+    std::vector<std::string> GroupResults;
+    for (GroupMapTy::iterator I = Groups.begin(), E = Groups.end(); I != E;
+         ++I) {
+      const std::vector<size_t> &Indices = I->second;
+      GroupOffsets.clear();
+      for (size_t i = 0, e = Indices.size(); i != e; ++i)
+        GroupOffsets.push_back(Offsets[Indices[i]]);
+      if (I->first.second)
+        Symbolizer.symbolizeDataBatch(I->first.first, GroupOffsets,
+                                      GroupResults);
+      else
+        Symbolizer.symbolizeCodeBatch(I->first.first, GroupOffsets,
+                                      GroupResults);
+      for (size_t i = 0, e = Indices.size(); i != e; ++i)
+        Results[Indices[i]].swap(GroupResults[i]);
+    }
+
+    for (size_t i = 0, e = Results.size(); i != e; ++i)
+      outs() << Results[i] << "\n";
+    return 0;
+  }
+
   while (parseCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
@@ -147,4 +147,16 @@ TEST(AllocatorTest, TestBigAlignment) {
   EXPECT_LE(Ptr + 3000, ((uintptr_t)Slab) + Slab->Size);
 }
 
+// Test that slabs released by one allocator are reused by the next one.
+TEST(AllocatorTest, TestRecyclingSlabs) {
+  RecyclingSlabAllocator SlabAlloc(4096, 1);
+  void *First;
+  {
+    BumpPtrAllocator Alloc(4096, 4096, SlabAlloc);
+    First = Alloc.Allocate(16, 0);
+  }
+  BumpPtrAllocator Alloc(4096, 4096, SlabAlloc);
+  EXPECT_EQ(First, Alloc.Allocate(16, 0));
+}
+
 }  // anonymous namespace